@@ -1,706 +1,3521 @@
-/**
- * Copyright (c) 2014 - 2018, Nordic Semiconductor ASA
- *
- * All rights reserved.
- *
- * Redistribution and use in source and binary forms, with or without modification,
- * are permitted provided that the following conditions are met:
- *
- * 1. Redistributions of source code must retain the above copyright notice, this
- *    list of conditions and the following disclaimer.
- *
- * 2. Redistributions in binary form, except as embedded into a Nordic
- *    Semiconductor ASA integrated circuit in a product or a software update for
- *    such product, must reproduce the above copyright notice, this list of
- *    conditions and the following disclaimer in the documentation and/or other
- *    materials provided with the distribution.
- *
- * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
- *    contributors may be used to endorse or promote products derived from this
- *    software without specific prior written permission.
- *
- * 4. This software, with or without modification, must only be used with a
- *    Nordic Semiconductor ASA integrated circuit.
- *
- * 5. Any software provided in binary form under this license must not be reverse
- *    engineered, decompiled, modified and/or disassembled.
- *
- * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
- * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
- * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
- * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
- * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
- * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
- * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
- * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
- * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
- * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
- *
- */
-/**
- * @brief BLE LED Button Service central and client application main file.
- *
- * This file contains the source code for a sample client application using the LED Button service.
- */
-
-#include <stdint.h>
-#include <stdio.h>
-#include <string.h>
-#include "nrf_sdh.h"
-#include "nrf_sdh_ble.h"
-#include "nrf_sdh_soc.h"
-#include "nrf_pwr_mgmt.h"
-#include "app_timer.h"
-#include "boards.h"
-#include "bsp.h"
-#include "bsp_btn_ble.h"
-#include "ble.h"
-#include "ble_hci.h"
-#include "ble_advertising.h"
-#include "ble_conn_params.h"
-#include "ble_db_discovery.h"
-#include "ble_lbs_c.h"
-#include "nrf_ble_gatt.h"
-#include "nrf_ble_scan.h"
-#include "nrf_drv_timer.h"
-
-#include "nrf_log.h"
-#include "nrf_log_ctrl.h"
-#include "nrf_log_default_backends.h"
-
-#define CENTRAL_SCANNING_LED            BSP_BOARD_LED_0                     /**< Scanning LED will be on when the device is scanning. */
-#define CENTRAL_CONNECTED_LED           BSP_BOARD_LED_1                     /**< Connected LED will be on when the device is connected. */
-#define LEDBUTTON_LED                   BSP_BOARD_LED_2                     /**< LED to indicate a change of state of the the Button characteristic on the peer. */
-
-#define SCAN_INTERVAL                   0x00A0                              /**< Determines scan interval in units of 0.625 millisecond. */
-#define SCAN_WINDOW                     0x0050                              /**< Determines scan window in units of 0.625 millisecond. */
-#define SCAN_DURATION                   0x0000                              /**< Timout when scanning. 0x0000 disables timeout. */
-
-#define MIN_CONNECTION_INTERVAL         MSEC_TO_UNITS(7.5, UNIT_1_25_MS)    /**< Determines minimum connection interval in milliseconds. */
-#define MAX_CONNECTION_INTERVAL         MSEC_TO_UNITS(30, UNIT_1_25_MS)     /**< Determines maximum connection interval in milliseconds. */
-#define SLAVE_LATENCY                   0                                   /**< Determines slave latency in terms of connection events. */
-#define SUPERVISION_TIMEOUT             MSEC_TO_UNITS(4000, UNIT_10_MS)     /**< Determines supervision time-out in units of 10 milliseconds. */
-
-#define LEDBUTTON_BUTTON_PIN            BSP_BUTTON_0                        /**< Button that will write to the LED characteristic of the peer */
-#define BUTTON_DETECTION_DELAY          APP_TIMER_TICKS(50)                 /**< Delay from a GPIOTE event until a button is reported as pushed (in number of timer ticks). */
-
-#define APP_BLE_CONN_CFG_TAG            1                                   /**< A tag identifying the SoftDevice BLE configuration. */
-#define APP_BLE_OBSERVER_PRIO           3                                   /**< Application's BLE observer priority. You shouldn't need to modify this value. */
-
-
-//Blink master configuration
-#define MAX_RSSI_BUFF_SIZE          25
-#define RSSI_THRESHOLD              -50
-#define DISCONNECTION_RSSI_THRESHOLD              -60
-#define BLINK_TIME_INTERVAL_MS      500
-
-NRF_BLE_SCAN_DEF(m_scan);                                       /**< Scanning module instance. */
-BLE_LBS_C_DEF(m_ble_lbs_c);                                     /**< Main structure used by the LBS client module. */
-NRF_BLE_GATT_DEF(m_gatt);                                       /**< GATT module instance. */
-BLE_DB_DISCOVERY_DEF(m_db_disc);                                /**< DB discovery module instance. */
-
-static char const m_target_periph_name[] = "Nordic_Blinky";     /**< Name of the device we try to connect to. This name is searched in the scan report data*/
-static char const periph_uuid[] = "23D1BCEA5F782315DEEF121223150000";
-
-const nrf_drv_timer_t TIMER_LED = NRF_DRV_TIMER_INSTANCE(1);
-
-uint8_t ledStatus = 0;
-
-typedef struct __attribute__((packed)) {
-    uint8_t header;
-    uint8_t address[6];
-    uint8_t payload[37];
-} adv_payload_t;
-
-typedef struct __attribute__((packed)) {
-    uint8_t adv_len;
-    uint8_t adv_type;
-    uint8_t data[37];
-} adv_data_t;
-
-int8_t rssi_filter_buff[MAX_RSSI_BUFF_SIZE];
-int rssi_filter_counter = 0;
-
-int8_t calcMode (int8_t *rssi, int len);
-
-/**@brief Function to handle asserts in the SoftDevice.
- *
- * @details This function will be called in case of an assert in the SoftDevice.
- *
- * @warning This handler is an example only and does not fit a final product. You need to analyze
- *          how your product is supposed to react in case of Assert.
- * @warning On assert from the SoftDevice, the system can only recover on reset.
- *
- * @param[in] line_num     Line number of the failing ASSERT call.
- * @param[in] p_file_name  File name of the failing ASSERT call.
- */
-void assert_nrf_callback(uint16_t line_num, const uint8_t * p_file_name)
-{
-    app_error_handler(0xDEADBEEF, line_num, p_file_name);
-}
-
-/**@brief Function for the LEDs initialization.
- *
- * @details Initializes all LEDs used by the application.
- */
-static void leds_init(void)
-{
-    bsp_board_init(BSP_INIT_LEDS);
-}
-
-/**@brief Function to start scanning.
- */
-static void scan_start(void) {
-    ret_code_t err_code;
-    err_code = nrf_ble_scan_start(&m_scan);
-    APP_ERROR_CHECK(err_code);
-}
-
-/**@brief Handles events coming from the LED Button central module.
- */
-static void lbs_c_evt_handler(ble_lbs_c_t * p_lbs_c, ble_lbs_c_evt_t * p_lbs_c_evt)
-{
-    switch (p_lbs_c_evt->evt_type)
-    {
-        case BLE_LBS_C_EVT_DISCOVERY_COMPLETE:
-        {
-            ret_code_t err_code;
-
-            err_code = ble_lbs_c_handles_assign(&m_ble_lbs_c, p_lbs_c_evt->conn_handle, &p_lbs_c_evt->params.peer_db);
-            NRF_LOG_RAW_INFO("LED Button service discovered on conn_handle 0x%x.", p_lbs_c_evt->conn_handle);
-
-            err_code = app_button_enable();
-            APP_ERROR_CHECK(err_code);
-
-            // LED Button service discovered. Enable notification of Button.
-            err_code = ble_lbs_c_button_notif_enable(p_lbs_c);
-
-            nrf_drv_timer_enable(&TIMER_LED);
-
-           APP_ERROR_CHECK(err_code);
-        } break; // BLE_LBS_C_EVT_DISCOVERY_COMPLETE
-
-        case BLE_LBS_C_EVT_BUTTON_NOTIFICATION:
-            NRF_LOG_RAW_INFO("BLE_LBS_C_EVT_BUTTON_NOTIFICATION\n");
-        break;
-
-        default:
-            break;
-    }
-}
-
-/**@brief Function for handling BLE events.
- *
- * @param[in]   p_ble_evt   Bluetooth stack event.
- * @param[in]   p_context   Unused.
- */
-static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
-{
-    ret_code_t err_code;
-
-    // For readability.
-    ble_gap_evt_t const * p_gap_evt = &p_ble_evt->evt.gap_evt;
-
-    switch (p_ble_evt->header.evt_id)
-    {
-        // Upon connection, check which peripheral has connected (HR or RSC), initiate DB
-        // discovery, update LEDs status and resume scanning if necessary. */
-        case BLE_GAP_EVT_CONNECTED:
-        {
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_CONNECTED\n");
-            NRF_LOG_RAW_INFO("handle = 0x%X\n", p_gap_evt->conn_handle);
-            err_code = ble_lbs_c_handles_assign(&m_ble_lbs_c, p_gap_evt->conn_handle, NULL);
-            APP_ERROR_CHECK(err_code);
-
-            err_code = ble_db_discovery_start(&m_db_disc, p_gap_evt->conn_handle);
-            APP_ERROR_CHECK(err_code);
-            //start receive rssi during connection
-            err_code = sd_ble_gap_rssi_start(p_gap_evt->conn_handle, 5, 1);
-            //reset filter counter
-            rssi_filter_counter = 0;
-            //delete previous rssi
-            rssi_filter_counter = 0;
-            APP_ERROR_CHECK(err_code);
-        } 
-        break;
-
-        // Upon disconnection, reset the connection handle of the peer which disconnected, update
-        // the LEDs status and start scanning again.
-        case BLE_GAP_EVT_DISCONNECTED:
-        {
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_DISCONNECTED\n");
-            bsp_board_led_off(BSP_BOARD_LED_0);
-            nrf_drv_timer_disable(&TIMER_LED);
-            scan_start();
-        } break;
-
-        case BLE_GAP_EVT_TIMEOUT:
-        {
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_TIMEOUT\n");
-            // We have not specified a timeout for scanning, so only connection attemps can timeout.
-            if (p_gap_evt->params.timeout.src == BLE_GAP_TIMEOUT_SRC_CONN) {
-                NRF_LOG_RAW_INFO("BLE_GAP_EVT_TIMEOUT\n");
-            }
-        } 
-        break;
-
-        case BLE_GAP_EVT_CONN_PARAM_UPDATE_REQUEST:
-        {
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_CONN_PARAM_UPDATE_REQUEST\n");
-            // Accept parameters requested by peer.
-            err_code = sd_ble_gap_conn_param_update(p_gap_evt->conn_handle, &p_gap_evt->params.conn_param_update_request.conn_params);
-            APP_ERROR_CHECK(err_code);
-        } break;
-
-        case BLE_GAP_EVT_PHY_UPDATE_REQUEST:
-        {
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_PHY_UPDATE_REQUEST\n");
-            ble_gap_phys_t const phys = {
-                .rx_phys = BLE_GAP_PHY_AUTO,
-                .tx_phys = BLE_GAP_PHY_AUTO,
-            };
-            err_code = sd_ble_gap_phy_update(p_ble_evt->evt.gap_evt.conn_handle, &phys);
-            APP_ERROR_CHECK(err_code);
-        } break;
-
-        case BLE_GATTC_EVT_TIMEOUT:
-        {
-            // Disconnect on GATT Client timeout event.
-            NRF_LOG_RAW_INFO("BLE_GATTC_EVT_TIMEOUT\n");
-            err_code = sd_ble_gap_disconnect(p_ble_evt->evt.gattc_evt.conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
-            APP_ERROR_CHECK(err_code);
-        } break;
-
-        case BLE_GATTS_EVT_TIMEOUT:
-        {
-            // Disconnect on GATT Server timeout event.
-            NRF_LOG_RAW_INFO("BLE_GATTS_EVT_TIMEOUT\n");
-            err_code = sd_ble_gap_disconnect(p_ble_evt->evt.gatts_evt.conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
-            APP_ERROR_CHECK(err_code);
-        } break;
-
-        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_CONN_PARAM_UPDATE\n");
-        break;
-
-        case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_SEC_PARAMS_REQUEST\n");
-        break;
-
-        case BLE_GAP_EVT_SEC_INFO_REQUEST:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_SEC_INFO_REQUEST\n");
-        break;
-
-        case BLE_GAP_EVT_PASSKEY_DISPLAY:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_PASSKEY_DISPLAY\n");
-        break;
-
-        case BLE_GAP_EVT_KEY_PRESSED:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_KEY_PRESSED\n");
-        break;
-
-        case BLE_GAP_EVT_AUTH_KEY_REQUEST:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_AUTH_KEY_REQUEST\n");
-        break;
-
-        case BLE_GAP_EVT_LESC_DHKEY_REQUEST:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_LESC_DHKEY_REQUEST\n");
-        break;
-
-        case BLE_GAP_EVT_AUTH_STATUS :
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_AUTH_STATUS\n");
-        break;
-
-        case BLE_GAP_EVT_CONN_SEC_UPDATE:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_CONN_SEC_UPDATE\n");
-        break;
-
-        case BLE_GAP_EVT_RSSI_CHANGED:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_RSSI_CHANGED\n");
-            int8_t connectionRSSI;
-            uint8_t channelrssi_filter_counter;
-            uint32_t err_code = sd_ble_gap_rssi_get(p_ble_evt->evt.gatts_evt.conn_handle, &connectionRSSI, &channelrssi_filter_counter);
-            APP_ERROR_CHECK(err_code);
-            rssi_filter_buff[rssi_filter_counter++] = connectionRSSI;
-            if (rssi_filter_counter < MAX_RSSI_BUFF_SIZE)
-                return;
-            int mode = calcMode(rssi_filter_buff, rssi_filter_counter);
-            rssi_filter_counter = 0;
-            NRF_LOG_RAW_INFO("connectionRSSI = %i\n", mode);
-            if (mode <= RSSI_THRESHOLD) {
-                NRF_LOG_RAW_INFO("Disconnecting from slave, too far away\n");
-                err_code = sd_ble_gap_disconnect(p_ble_evt->evt.gattc_evt.conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
-            }
-        break;
-
-        case BLE_GAP_EVT_ADV_REPORT: {
-            //advertising report. Get remote rssi value
-            const ble_gap_evt_adv_report_t *p_adv_report = &p_gap_evt->params.adv_report;
-            uint8_t *data = p_adv_report->data.p_data;
-            uint16_t len = p_adv_report->data.len;
-
-            if (p_adv_report->type.status != BLE_GAP_ADV_DATA_STATUS_INCOMPLETE_MORE_DATA) {
-                adv_payload_t *adv = (adv_payload_t *) data;
-                adv_data_t *ad = (adv_data_t *) adv->payload;
-                if (p_adv_report->type.scan_response == 0) {
-                    if (ad->adv_type == 0x09) { 
-                        //complete local name
-                        int ret = memcmp(ad->data, m_target_periph_name, ad->adv_len - 1);
-                        if (ret == 0) {
-                            //device name founded
-                            ble_gap_scan_params_t scan_params;
-                            ble_gap_conn_params_t conn_params;
-
-                            memset(&scan_params, 0, sizeof(ble_gap_scan_params_t));
-                            scan_params.interval = SCAN_INTERVAL;
-                            scan_params.window = SCAN_WINDOW;
-                            scan_params.timeout = SCAN_DURATION;
-
-                            memset(&conn_params, 0, sizeof(ble_gap_conn_params_t));
-                            conn_params.min_conn_interval = MIN_CONNECTION_INTERVAL;
-                            conn_params.max_conn_interval = MAX_CONNECTION_INTERVAL;
-                            conn_params.slave_latency = SLAVE_LATENCY;
-                            conn_params.conn_sup_timeout = SUPERVISION_TIMEOUT;
-                            
-                            rssi_filter_buff[rssi_filter_counter++] = p_adv_report->rssi;
-                            if (rssi_filter_counter < MAX_RSSI_BUFF_SIZE)
-                                return;
-                            int8_t mode = calcMode(rssi_filter_buff, MAX_RSSI_BUFF_SIZE);
-                            rssi_filter_counter = 0;
-                            NRF_LOG_RAW_INFO("rssi mode = %i\n", mode);
-                            if (p_adv_report->rssi <= RSSI_THRESHOLD)
-                                return;
-
-                            uint32_t ret = sd_ble_gap_connect((ble_gap_addr_t const *)&p_adv_report->peer_addr, 
-                                (ble_gap_scan_params_t const *)&scan_params, 
-                                (ble_gap_conn_params_t const *)&conn_params, APP_BLE_CONN_CFG_TAG);
-                        }
-                    }
-                }
-                else if (p_adv_report->type.scan_response == 1) {
-                    //check uuid on scan response
-                    ad = (adv_data_t *) data;
-                    if (ad->adv_type == 0x07) {
-                        //complete list of 128-bit uuid
-                        //check uuid
-                    }
-                }
-            }
-            //NRF_LOG_RAW_INFO("BLE_GAP_EVT_ADV_REPORT\n");
-        }
-        break;
-
-        case BLE_GAP_EVT_SEC_REQUEST:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_SEC_REQUEST\n");
-        break;
-        
-        case BLE_GAP_EVT_SCAN_REQ_REPORT:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_SCAN_REQ_REPORT\n");
-        break;
-
-        case BLE_GAP_EVT_DATA_LENGTH_UPDATE_REQUEST:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_DATA_LENGTH_UPDATE_REQUEST\n");
-        break;
-
-        case BLE_GAP_EVT_DATA_LENGTH_UPDATE:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_DATA_LENGTH_UPDATE\n");
-        break;
-
-        case BLE_GAP_EVT_QOS_CHANNEL_SURVEY_REPORT:
-            NRF_LOG_RAW_INFO("BLE_GAP_EVT_QOS_CHANNEL_SURVEY_REPORT\n");
-        break;
-
-        default:
-            break;
-    }
-}
-
-/**@brief LED Button client initialization.
- */
-static void lbs_c_init(void)
-{
-    ble_lbs_c_init_t lbs_c_init_obj;
-
-    lbs_c_init_obj.evt_handler = lbs_c_evt_handler;
-
-    ret_code_t err_code = ble_lbs_c_init(&m_ble_lbs_c, &lbs_c_init_obj);
-    APP_ERROR_CHECK(err_code);
-}
-
-/**@brief Function for initializing the BLE stack.
- *
- * @details Initializes the SoftDevice and the BLE event interrupts.
- */
-static void ble_stack_init(void)
-{
-    ret_code_t err_code;
-
-    err_code = nrf_sdh_enable_request();
-    APP_ERROR_CHECK(err_code);
-
-    // Configure the BLE stack using the default settings.
-    // Fetch the start address of the application RAM.
-    uint32_t ram_start = 0;
-    err_code = nrf_sdh_ble_default_cfg_set(APP_BLE_CONN_CFG_TAG, &ram_start);
-    APP_ERROR_CHECK(err_code);
-
-    // Enable BLE stack.
-    err_code = nrf_sdh_ble_enable(&ram_start);
-    APP_ERROR_CHECK(err_code);
-
-    // Register a handler for BLE events.
-    NRF_SDH_BLE_OBSERVER(m_ble_observer, APP_BLE_OBSERVER_PRIO, ble_evt_handler, NULL);
-}
-
-/**@brief Function for handling events from the button handler module.
- *
- * @param[in] pin_no        The pin that the event applies to.
- * @param[in] button_action The button action (press/release).
- */
-static void button_event_handler(uint8_t pin_no, uint8_t button_action)
-{
-    ret_code_t err_code;
-
-    switch (pin_no)
-    {
-        case LEDBUTTON_BUTTON_PIN:
-            NRF_LOG_RAW_INFO("LEDBUTTON_BUTTON_PIN\n");
-            /*
-            err_code = ble_lbs_led_status_send(&m_ble_lbs_c, button_action);
-            if (err_code != NRF_SUCCESS &&
-                err_code != BLE_ERROR_INVALID_CONN_HANDLE &&
-                err_code != NRF_ERROR_INVALID_STATE)
-            {
-                APP_ERROR_CHECK(err_code);
-            }
-            if (err_code == NRF_SUCCESS)
-            {
-                //NRF_LOG_RAW_INFO("LBS write LED state %d", button_action);
-            }
-            */
-            break;
-
-        default:
-            APP_ERROR_HANDLER(pin_no);
-            break;
-    }
-}
-
-/**@brief Function for handling Scaning events.
- *
- * @param[in]   p_scan_evt   Scanning event.
- */
-static void scan_evt_handler(scan_evt_t const * p_scan_evt)
-{
-    ret_code_t err_code;
-
-    switch(p_scan_evt->scan_evt_id)
-    {
-        case NRF_BLE_SCAN_EVT_CONNECTING_ERROR:
-            NRF_LOG_RAW_INFO("NRF_BLES_SCAN_EVT_CONNECTING_ERROR\n");
-            err_code = p_scan_evt->params.connecting_err.err_code;
-            APP_ERROR_CHECK(err_code);
-            break;
-        case NRF_BLE_SCAN_EVT_FILTER_MATCH:
-            //NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_FILTER_MATCH\n");
-        break;
-
-        case NRF_BLE_SCAN_EVT_WHITELIST_REQUEST:
-            NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_WHITELIST_REQUEST\n");
-        break;
-
-        case NRF_BLE_SCAN_EVT_WHITELIST_ADV_REPORT:
-            NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_WHITELIST_ADV_REPORT\n");
-        break;
-
-        case NRF_BLE_SCAN_EVT_NOT_FOUND:
-            //NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_NOT_FOUND\n");
-        break;
-
-        case NRF_BLE_SCAN_EVT_SCAN_TIMEOUT:
-            NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_SCAN_TIMEOUT\n");
-        break;
-
-        case NRF_BLE_SCAN_EVT_SCAN_REQ_REPORT:
-            NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_SCAN_REQ_REPORT\n");
-        break;
-
-        case NRF_BLE_SCAN_EVT_CONNECTED:
-            NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_CONNECTED\n");
-        break;
-
-        default:
-            NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_DEFAULT\n");
-        break;
-    }
-}
-
-/**@brief Function for initializing the button handler module.
- */
-static void buttons_init(void)
-{
-    ret_code_t err_code;
-
-    //The array must be static because a pointer to it will be saved in the button handler module.
-    static app_button_cfg_t buttons[] = {
-        {LEDBUTTON_BUTTON_PIN, false, BUTTON_PULL, button_event_handler}
-    };
-
-    err_code = app_button_init(buttons, ARRAY_SIZE(buttons), BUTTON_DETECTION_DELAY);
-    APP_ERROR_CHECK(err_code);
-}
-
-/**@brief Function for handling database discovery events.
- *
- * @details This function is callback function to handle events from the database discovery module.
- *          Depending on the UUIDs that are discovered, this function should forward the events
- *          to their respective services.
- *
- * @param[in] p_event  Pointer to the database discovery event.
- */
-static void db_disc_handler(ble_db_discovery_evt_t * p_evt)
-{
-    ble_lbs_on_db_disc_evt(&m_ble_lbs_c, p_evt);
-}
-
-/**@brief Database discovery initialization.
- */
-static void db_discovery_init(void)
-{
-    ret_code_t err_code = ble_db_discovery_init(db_disc_handler);
-    APP_ERROR_CHECK(err_code);
-}
-
-/**@brief Function for initializing the log.
- */
-static void log_init(void)
-{
-    ret_code_t err_code = NRF_LOG_INIT(NULL);
-    APP_ERROR_CHECK(err_code);
-
-    NRF_LOG_DEFAULT_BACKENDS_INIT();
-}
-
-/**@brief Function for initializing the timer.
- */
-static void timer_init(void)
-{
-    ret_code_t err_code = app_timer_init();
-    APP_ERROR_CHECK(err_code);
-}
-
-
-/**@brief Function for initializing the Power manager. */
-static void power_management_init(void)
-{
-    ret_code_t err_code;
-    err_code = nrf_pwr_mgmt_init();
-    APP_ERROR_CHECK(err_code);
-}
-
-static void scan_init(void)
-{
-    ret_code_t          err_code;
-    nrf_ble_scan_init_t init_scan;
-
-    memset(&init_scan, 0, sizeof(init_scan));
-
-    init_scan.connect_if_match = false;
-    init_scan.conn_cfg_tag     = APP_BLE_CONN_CFG_TAG;
-
-    err_code = nrf_ble_scan_init(&m_scan, &init_scan, scan_evt_handler);
-    APP_ERROR_CHECK(err_code);
-
-    // Setting filters for scanning.
-    err_code = nrf_ble_scan_filters_enable(&m_scan, NRF_BLE_SCAN_NAME_FILTER, false);
-    APP_ERROR_CHECK(err_code);
-
-    err_code = nrf_ble_scan_filter_set(&m_scan, SCAN_NAME_FILTER, m_target_periph_name);
-    APP_ERROR_CHECK(err_code);
-}
-
-
-/**@brief Function for initializing the GATT module.
- */
-static void gatt_init(void)
-{
-    ret_code_t err_code = nrf_ble_gatt_init(&m_gatt, NULL);
-    APP_ERROR_CHECK(err_code);
-}
-
-void timer_led_event_handler(nrf_timer_event_t event_type, void* p_context)
-{
-    switch (event_type) {
-        case NRF_TIMER_EVENT_COMPARE0:
-            bsp_board_led_invert(BSP_BOARD_LED_0);
-            ledStatus = ~ledStatus;
-            ble_lbs_led_status_send(&m_ble_lbs_c, ledStatus);
-        break;
-
-        default:
-            //Do nothing.
-            break;
-    }
-}
-
-void config_led_timer (void) {
-    // Turn on the LED to signal scanning.
-    //bsp_board_led_on(CENTRAL_SCANNING_LED);
-    uint32_t time_ticks;
-    uint32_t err_code = NRF_SUCCESS;
-
-    //Configure all leds on board.
-    bsp_board_init(BSP_INIT_LEDS);
-
-    //Configure TIMER_LED for generating simple light effect - leds on board will invert his state one after the other.
-    nrf_drv_timer_config_t timer_cfg = NRF_DRV_TIMER_DEFAULT_CONFIG;
-    err_code = nrf_drv_timer_init(&TIMER_LED, &timer_cfg, timer_led_event_handler);
-
-    APP_ERROR_CHECK(err_code);
-    time_ticks = nrf_drv_timer_ms_to_ticks(&TIMER_LED, BLINK_TIME_INTERVAL_MS);
-    nrf_drv_timer_extended_compare(&TIMER_LED, NRF_TIMER_CC_CHANNEL0, time_ticks, NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, true);
-}
-
-int8_t calcMode (int8_t *rssi, int len) {
-  int8_t maxValue = 0, maxCount = 0, i, j;
-   for (i = 0; i < len; ++i) {
-      int8_t count = 0;
-      
-      for (j = 0; j < len; ++j) {
-         if (rssi[j] == rssi[i])
-         ++count;
-      }
-      
-      if (count > maxCount) {
-         maxCount = count;
-         maxValue = rssi[i];
-      }
-   }
-   return maxValue;
-}
-
-int main(void)
-{
-    // Initialize.
-    log_init();
-    timer_init();
-    leds_init();
-    buttons_init();
-    power_management_init();
-    ble_stack_init();
-    scan_init();
-    gatt_init();
-    db_discovery_init();
-    lbs_c_init();
-    config_led_timer();
-    
-    // Start execution.
-    NRF_LOG_RAW_INFO("Blinky CENTRAL example started.\n");
-    scan_start();
-
-    bsp_board_led_off(BSP_BOARD_LED_0);
-
-    while (1) {
-        nrf_pwr_mgmt_run();
-    }
-}
+/**
+ * Copyright (c) 2014 - 2018, Nordic Semiconductor ASA
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification,
+ * are permitted provided that the following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this
+ *    list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form, except as embedded into a Nordic
+ *    Semiconductor ASA integrated circuit in a product or a software update for
+ *    such product, must reproduce the above copyright notice, this list of
+ *    conditions and the following disclaimer in the documentation and/or other
+ *    materials provided with the distribution.
+ *
+ * 3. Neither the name of Nordic Semiconductor ASA nor the names of its
+ *    contributors may be used to endorse or promote products derived from this
+ *    software without specific prior written permission.
+ *
+ * 4. This software, with or without modification, must only be used with a
+ *    Nordic Semiconductor ASA integrated circuit.
+ *
+ * 5. Any software provided in binary form under this license must not be reverse
+ *    engineered, decompiled, modified and/or disassembled.
+ *
+ * THIS SOFTWARE IS PROVIDED BY NORDIC SEMICONDUCTOR ASA "AS IS" AND ANY EXPRESS
+ * OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY, NONINFRINGEMENT, AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL NORDIC SEMICONDUCTOR ASA OR CONTRIBUTORS BE
+ * LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR
+ * CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE
+ * GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+ * HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+/**
+ * @brief BLE LED Button Service central and client application main file.
+ *
+ * This file contains the source code for a sample client application using the LED Button service.
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "nrf_sdh.h"
+#include "nrf_sdh_ble.h"
+#include "nrf_sdh_soc.h"
+#include "nrf_pwr_mgmt.h"
+#include "app_timer.h"
+#include "app_scheduler.h"
+#include "boards.h"
+#include "bsp.h"
+#include "bsp_btn_ble.h"
+#include "ble.h"
+#include "ble_hci.h"
+#include "ble_advertising.h"
+#include "ble_conn_params.h"
+#include "ble_db_discovery.h"
+#include "ble_lbs_c.h"
+#include "nrf_ble_gatt.h"
+#include "nrf_ble_scan.h"
+#include "nrf_drv_timer.h"
+#include "nrf_drv_ppi.h"
+#include "nrf_drv_gpiote.h"
+#include "SEGGER_RTT.h"
+
+#include "nrf_log.h"
+#include "nrf_log_ctrl.h"
+#include "nrf_log_default_backends.h"
+
+#define CENTRAL_SCANNING_LED            BSP_BOARD_LED_0                     /**< Scanning LED will be on when the device is scanning. */
+#define CENTRAL_CONNECTED_LED           BSP_BOARD_LED_1                     /**< Connected LED will be on when the device is connected. */
+#define LEDBUTTON_LED                   BSP_BOARD_LED_2                     /**< LED to indicate a change of state of the the Button characteristic on the peer. */
+#define BLINK_LED_PIN                   BSP_LED_0                           /**< Pin of the local blinking LED (BSP_BOARD_LED_0), toggled by TIMER_LED through PPI. */
+
+#define SCAN_INTERVAL                   0x00A0                              /**< Determines scan interval in units of 0.625 millisecond. */
+#define SCAN_WINDOW                     0x0050                              /**< Determines scan window in units of 0.625 millisecond. */
+#define SCAN_DURATION                   0x0000                              /**< Timout when scanning. 0x0000 disables timeout. */
+#ifndef SCAN_ADAPT_ENABLED
+#define SCAN_ADAPT_ENABLED              1                                   /**< Step the scan duty cycle down while no target is seen (1), or stay on the fastest level (0). */
+#endif
+#define SCAN_IDLE_STEP_MS               10000                               /**< Time without a target sighting before the scanner steps down one duty cycle level. */
+#define SCAN_ADAPT_CHECK_MS             1000                                /**< Period of the scan duty cycle check. */
+#define SCAN_ADAPT_REPORT_CHECKS        10                                  /**< Number of duty cycle checks between two scan reports. */
+#define CONNECT_TIMEOUT                 MSEC_TO_UNITS(3000, UNIT_10_MS)     /**< Time a connection attempt may wait for the peer, in units of 10 milliseconds. */
+#define CONNECT_RETRY_MAX               3                                   /**< Connection attempts to the same peer after a timeout before scanning again. */
+#define CONNECT_BACKOFF_MS              250                                 /**< Delay before the first retry, doubled for every further retry. */
+
+#define LINKS_AIRTIME                   (NRF_SDH_BLE_CENTRAL_LINK_COUNT * NRF_SDH_BLE_GAP_EVENT_LENGTH)    /**< Radio time reserved for one connection event of every link, in units of 1.25 millisecond. */
+#define MIN_CONNECTION_INTERVAL         MAX(MSEC_TO_UNITS(7.5, UNIT_1_25_MS), LINKS_AIRTIME)               /**< Determines minimum connection interval, long enough for one event of every link. */
+#define MAX_CONNECTION_INTERVAL         MAX(MSEC_TO_UNITS(30, UNIT_1_25_MS), MIN_CONNECTION_INTERVAL)      /**< Determines maximum connection interval in units of 1.25 millisecond. */
+#define SLAVE_LATENCY                   0                                   /**< Determines slave latency in terms of connection events. */
+#define SUPERVISION_TIMEOUT             MSEC_TO_UNITS(4000, UNIT_10_MS)     /**< Determines supervision time-out in units of 10 milliseconds. */
+#if defined(S140)
+#define PHY_CODED_FALLBACK              1                                   /**< Move links close to the disconnection threshold to the Coded PHY. */
+#else
+#define PHY_CODED_FALLBACK              0                                   /**< The S132 SoftDevice has no Coded PHY. */
+#endif
+#define PHY_CODED_RSSI_MARGIN           5                                   /**< Switch to the Coded PHY when the filtered RSSI is within this many dBm of DISCONNECTION_RSSI_THRESHOLD. */
+#define PHY_CODED_RSSI_HYSTERESIS       5                                   /**< Go back to the 2M PHY this many dBm above the Coded PHY switch point. */
+#define CONN_PROFILE                    CONN_PROFILE_LOW_LATENCY            /**< Connection parameter profile used to connect and to answer peer update requests. */
+#define CONN_AIRTIME_BUDGET_PERMILLE    1000                                /**< Share of the radio time the connection events of all links may take, in per mille. */
+
+#define LEDBUTTON_BUTTON_PIN            BSP_BUTTON_0                        /**< Button that will write to the LED characteristic of the peer */
+#define BUTTON_DETECTION_DELAY          APP_TIMER_TICKS(50)                 /**< Delay from a GPIOTE event until a button is reported as pushed (in number of timer ticks). */
+
+#define APP_BLE_CONN_CFG_TAG            1                                   /**< A tag identifying the SoftDevice BLE configuration. */
+#define APP_BLE_OBSERVER_PRIO           3                                   /**< Application's BLE observer priority. You shouldn't need to modify this value. */
+
+#define SCHED_MAX_EVENT_DATA_SIZE       sizeof(uint32_t)                    /**< Maximum size of scheduler events. */
+#define SCHED_QUEUE_SIZE                8                                   /**< Maximum number of events in the scheduler queue. */
+#define ISR_STATS_LOG_INTERVAL          20                                  /**< Number of LED timer interrupts between two ISR residency reports. */
+
+#ifndef EVT_PROFILER_ENABLED
+#define EVT_PROFILER_ENABLED            0                                   /**< Instrumentation build: time every event handler case with the DWT cycle counter. */
+#endif
+#ifndef EVT_PROFILER_CYCLES
+#define EVT_PROFILER_CYCLES()           (DWT->CYCCNT)                       /**< Cycle counter read by the profiler, can be replaced by a host build. */
+#endif
+#define EVT_PROFILER_SLOT_COUNT         24                                  /**< Number of distinct (source, event ID) pairs the profiler can follow. */
+#define EVT_PROFILER_BUCKET_COUNT       24                                  /**< Power of two histogram buckets, the last one also holds longer calls. */
+#define EVT_PROFILER_DUMP_INTERVAL_MS   10000                               /**< Period of the profiler report on RTT. */
+
+#ifndef LATENCY_BENCH_ENABLED
+#define LATENCY_BENCH_ENABLED           0                                   /**< Benchmark build: send LED writes as write requests and time them until the write response. */
+#endif
+#define LATENCY_BENCH_SLOT_COUNT        4                                   /**< Number of distinct connection intervals the benchmark keeps a histogram for. */
+#define LATENCY_BENCH_BUCKET_US         2500                                /**< Width of a latency histogram bucket. */
+#define LATENCY_BENCH_BUCKET_COUNT      40                                  /**< Latency histogram buckets, the last one also holds longer writes. */
+
+#ifndef THROUGHPUT_TEST_ENABLED
+#define THROUGHPUT_TEST_ENABLED         0                                   /**< Test build: stream write commands to every ready link instead of blinking. */
+#endif
+#define THROUGHPUT_TX_QUEUE_SIZE        8                                   /**< Write commands the SoftDevice may queue per link in the throughput build. */
+
+#ifndef BLE_EVT_CAPTURE_ENABLED
+#define BLE_EVT_CAPTURE_ENABLED         0                                   /**< Capture build: copy every BLE event with a timestamp to an RTT channel. */
+#endif
+#define BLE_EVT_CAPTURE_RTT_CHANNEL     1                                   /**< RTT up channel of the capture, channel 0 carries the logs. */
+#define BLE_EVT_CAPTURE_BUF_SIZE        4096                                /**< Size of the RTT buffer of the capture channel. */
+#define BLE_EVT_CAPTURE_EVT_SIZE_MAX    MAX(NRF_SDH_BLE_EVT_BUF_SIZE, sizeof(ble_evt_t))  /**< Largest event a capture record holds. */
+
+
+//Blink master configuration
+#ifndef MAX_RSSI_BUFF_SIZE
+#define MAX_RSSI_BUFF_SIZE          25
+#endif
+#define RSSI_THRESHOLD              -50
+#define DISCONNECTION_RSSI_THRESHOLD              -60
+#define PERIPH_MATCH_BY_UUID        1                                   /**< Select peers by the service UUID in the scan response (1) or by the name in the advertising data (0). */
+#define UUID128_LEN                 16                                  /**< Length of a 128-bit UUID in bytes. */
+#define LBS_HANDLE_CACHE_SIZE       8                                   /**< Number of peers whose LBS attribute handles are remembered across connections. */
+#define TICKS_TO_MS(ticks)          ((uint32_t)(((uint64_t)(ticks) * 1000 * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1)) / APP_TIMER_CLOCK_FREQ))
+#define TICKS_TO_US(ticks)          ((uint32_t)(((uint64_t)(ticks) * 1000000 * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1)) / APP_TIMER_CLOCK_FREQ))
+#define US_TO_TICKS(us)             ((uint32_t)(((uint64_t)(us) * APP_TIMER_CLOCK_FREQ) / (1000000 * (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))))
+#define PROXIMITY_DWELL_MS          1000                                /**< Time the filtered RSSI must stay past a threshold before the near/far state changes. */
+#define BLINK_TIME_INTERVAL_MS      500
+#ifndef LED_BLINK_USE_APP_TIMER
+#define LED_BLINK_USE_APP_TIMER     1                                   /**< Drive the blink cadence from app_timer on RTC1 (1) or from TIMER1 with a PPI toggle (0). */
+#endif
+#ifndef LED_SYNC_BLINK
+#define LED_SYNC_BLINK              1                                   /**< Align the LED writes of all links on a common connection event anchor (1) or send them at once (0). */
+#endif
+#define LED_SYNC_MARGIN_MS          5                                   /**< Lead time added to the longest connection interval before the common anchor. */
+
+NRF_BLE_SCAN_DEF(m_scan);                                       /**< Scanning module instance. */
+BLE_LBS_C_ARRAY_DEF(m_ble_lbs_c, NRF_SDH_BLE_CENTRAL_LINK_COUNT);  /**< LBS client instances, indexed by connection handle. */
+NRF_BLE_GATT_DEF(m_gatt);                                       /**< GATT module instance. */
+BLE_DB_DISCOVERY_ARRAY_DEF(m_db_disc, NRF_SDH_BLE_CENTRAL_LINK_COUNT);  /**< DB discovery module instances, indexed by connection handle. */
+
+static char const m_target_periph_name[] = "Nordic_Blinky";     /**< Name of the device we try to connect to. This name is searched in the scan report data*/
+static uint8_t const m_target_periph_uuid[UUID128_LEN] =          /**< LBS service UUID 00001523-1212-EFDE-1523-785FEABCD123, little-endian as sent over the air. */
+{
+    0x23, 0xD1, 0xBC, 0xEA, 0x5F, 0x78, 0x23, 0x15,
+    0xDE, 0xEF, 0x12, 0x12, 0x23, 0x15, 0x00, 0x00
+};
+
+#if LED_BLINK_USE_APP_TIMER
+APP_TIMER_DEF(m_led_timer_id);                                  /**< Blink timer, runs from the LFCLK so the HFCLK can stop between blinks. */
+#endif
+#if LED_SYNC_BLINK
+APP_TIMER_DEF(m_led_sync_timer_id);                             /**< Releases the synchronized LED writes, one link after the other. */
+#endif
+#if !LED_BLINK_USE_APP_TIMER
+const nrf_drv_timer_t TIMER_LED = NRF_DRV_TIMER_INSTANCE(1);
+static nrf_ppi_channel_t m_led_ppi_channel;                     /**< PPI channel from the TIMER_LED compare event to the LED toggle task. */
+#endif
+
+uint8_t ledStatus = 0;
+
+/**@brief Connection lifecycle states.
+ *
+ * @details The central itself is SCANNING, CONNECTING or in BACKOFF before a connection retry,
+ *          so only one connection attempt is ever pending. Each link is IDLE, DISCOVERING,
+ *          ACTIVE or DISCONNECTING.
+ */
+typedef enum
+{
+    CONN_STATE_IDLE,                                /**< Link entry not in use. */
+    CONN_STATE_SCANNING,                            /**< No connection attempt pending. */
+    CONN_STATE_CONNECTING,                          /**< sd_ble_gap_connect pending. */
+    CONN_STATE_BACKOFF,                             /**< Waiting before retrying a timed-out connection attempt. */
+    CONN_STATE_DISCOVERING,                         /**< Connected, LBS handles not known yet. */
+    CONN_STATE_ACTIVE,                              /**< LED writes can be sent. */
+    CONN_STATE_DISCONNECTING,                       /**< sd_ble_gap_disconnect called, waiting for BLE_GAP_EVT_DISCONNECTED. */
+    CONN_STATE_COUNT
+} conn_state_t;
+
+/**@brief Connection attempt of the central.
+ */
+typedef struct
+{
+    conn_state_t   state;                           /**< SCANNING, CONNECTING or BACKOFF. */
+    uint32_t       state_since;                     /**< app_timer counter value when state was entered. */
+    ble_gap_addr_t peer_addr;                       /**< Peer of the pending or retried attempt. */
+    uint8_t        attempts;                        /**< Attempts made to peer_addr. */
+} central_connect_t;
+
+/**@brief State of one central link, indexed by connection handle.
+ */
+typedef struct
+{
+    conn_state_t   state;                           /**< Lifecycle state of the link. */
+    uint32_t       state_since;                     /**< app_timer counter value when state was entered. */
+    bool           connected;                       /**< A peripheral is connected on this handle. */
+    bool           lbs_ready;                       /**< LED Button service discovered, LED writes can be sent. */
+    bool           led_written;                     /**< At least one LED write was sent on this connection. */
+    bool           handles_cached;                  /**< LBS handles were taken from the cache instead of a DB discovery. */
+    bool           led_write_cmd;                   /**< The LED characteristic accepts write commands (write without response). */
+    bool           led_pending;                     /**< led_value is waiting for a free SoftDevice TX buffer or for the previous write response. */
+    bool           led_in_flight;                   /**< An LED write request waits for its write response. */
+    bool           led_sent_valid;                  /**< led_sent holds the last value given to the SoftDevice. */
+    uint8_t        led_value;                       /**< Latest LED value requested for the link. */
+    uint8_t        led_sent;                        /**< Last LED value given to the SoftDevice. */
+    ble_gap_addr_t peer_addr;                       /**< Address of the connected peripheral. */
+    uint32_t       connected_at;                    /**< app_timer counter value at BLE_GAP_EVT_CONNECTED. */
+    uint16_t       conn_interval;                   /**< Connection interval in 1.25 ms units. */
+    uint8_t        phy;                             /**< Current TX PHY of the link. */
+    uint8_t        phy_preferred;                   /**< PHY requested for the link, also given to peer PHY update requests. */
+    uint8_t        phy_wanted;                      /**< PHY to request for the link, retried while it differs from phy_preferred. */
+    uint8_t        phy_refused;                     /**< PHYs the peer did not take on this connection, BLE_GAP_PHY_* mask. */
+    uint16_t       att_mtu;                         /**< Negotiated ATT MTU. */
+    uint8_t        data_length;                     /**< Negotiated link layer data length in bytes. */
+#if THROUGHPUT_TEST_ENABLED
+    uint32_t       tput_seq;                        /**< Sequence number of the next streamed write. */
+    uint32_t       tput_writes;                     /**< Streamed writes sent since tput_since. */
+    uint32_t       tput_full;                       /**< Times the SoftDevice TX queue was full since tput_since. */
+    uint32_t       tput_since;                      /**< app_timer counter value at the start of the measurement window. */
+#endif
+#if LATENCY_BENCH_ENABLED
+    bool           bench_in_flight;                 /**< A timed write waits for its write response. */
+    uint32_t       bench_tick_at;                   /**< app_timer counter value of the blink tick of the timed write. */
+    uint32_t       bench_sent_at;                   /**< app_timer counter value when the timed write was given to the SoftDevice. */
+#endif
+    bool           anchor_valid;                    /**< event_anchor matches the current connection interval. */
+    uint32_t       event_anchor;                    /**< app_timer counter value just after a recent connection event of the link. */
+    bool           sync_pending;                    /**< sync_value waits for sync_release before it is queued. */
+    bool           sync_in_flight;                  /**< The last synchronized write was given to the SoftDevice and is not acknowledged yet. */
+    uint8_t        sync_value;                      /**< LED value of the current synchronized blink. */
+    uint32_t       sync_release;                    /**< app_timer counter value at which sync_value is queued. */
+} central_link_t;
+
+/**@brief Counters of the LED command queues of all links.
+ */
+typedef struct
+{
+    uint32_t sent;                                  /**< Writes given to the SoftDevice. */
+    uint32_t merged;                                /**< Requests absorbed by a pending write or equal to the last value sent. */
+    uint32_t dropped;                               /**< Requests lost because the write failed. */
+} led_write_stats_t;
+
+/**@brief LBS attribute handles of a peer, kept to skip DB discovery on reconnection.
+ */
+typedef struct
+{
+    bool           in_use;                          /**< Entry holds the handles of a peer. */
+    ble_gap_addr_t addr;                            /**< Address of the peer, key of the entry. */
+    lbs_db_t       handles;                         /**< Handles found by the last discovery on the peer. */
+    bool           led_write_cmd;                   /**< The LED characteristic accepts write commands. */
+    uint32_t       last_used;                       /**< Value of m_lbs_handle_cache_clock at the last use, used to pick the entry to evict. */
+} lbs_handle_cache_entry_t;
+
+static central_link_t m_links[NRF_SDH_BLE_CENTRAL_LINK_COUNT];  /**< Link table, the LED timer fans out to every ready link. */
+static bool           m_led_timer_running;                      /**< The blink timer is running. */
+static led_write_stats_t m_led_write_stats;                     /**< Counters of the LED command queues. */
+
+/**@brief Time spent in the LED timer interrupt, measured with the DWT cycle counter.
+ */
+typedef struct
+{
+    uint32_t count;                                 /**< Interrupts measured since the last report. */
+    uint32_t cycles_total;                          /**< Sum of the cycles of those interrupts. */
+    uint32_t cycles_max;                            /**< Longest of those interrupts in cycles. */
+    uint32_t work_dropped;                          /**< LED work items lost because the scheduler queue was full. */
+} isr_stats_t;
+
+/**@brief Connection parameter profiles.
+ */
+typedef enum
+{
+    CONN_PROFILE_LOW_LATENCY,                       /**< Shortest intervals that still fit one event of every link. */
+    CONN_PROFILE_LOW_POWER,                         /**< Long intervals, the LED writes may lag by a few hundred milliseconds. */
+    CONN_PROFILE_MANY_LINKS,                        /**< Medium intervals leaving radio time for scanning with all links up. */
+    CONN_PROFILE_COUNT
+} conn_profile_t;
+
+static ble_gap_conn_params_t const m_conn_profiles[CONN_PROFILE_COUNT] =  /**< Parameter ranges of the profiles, indexed by @ref conn_profile_t. */
+{
+    [CONN_PROFILE_LOW_LATENCY] =
+    {
+        .min_conn_interval = MIN_CONNECTION_INTERVAL,
+        .max_conn_interval = MAX_CONNECTION_INTERVAL,
+        .slave_latency     = SLAVE_LATENCY,
+        .conn_sup_timeout  = SUPERVISION_TIMEOUT,
+    },
+    [CONN_PROFILE_LOW_POWER] =
+    {
+        .min_conn_interval = MAX(MSEC_TO_UNITS(100, UNIT_1_25_MS), LINKS_AIRTIME),
+        .max_conn_interval = MAX(MSEC_TO_UNITS(250, UNIT_1_25_MS), LINKS_AIRTIME),
+        .slave_latency     = 0,
+        .conn_sup_timeout  = SUPERVISION_TIMEOUT,
+    },
+    [CONN_PROFILE_MANY_LINKS] =
+    {
+        .min_conn_interval = MAX(MSEC_TO_UNITS(30, UNIT_1_25_MS), LINKS_AIRTIME),
+        .max_conn_interval = MAX(MSEC_TO_UNITS(75, UNIT_1_25_MS), 2 * LINKS_AIRTIME),
+        .slave_latency     = 0,
+        .conn_sup_timeout  = SUPERVISION_TIMEOUT,
+    },
+};
+
+/**@brief Outcome of the peer connection parameter update requests.
+ */
+typedef struct
+{
+    uint32_t accepted;                              /**< Requests accepted as asked. */
+    uint32_t clamped;                               /**< Requests answered with parameters narrowed to the profile or the airtime budget. */
+    uint32_t rejected;                              /**< Requests that could not fit the profile and the airtime budget. */
+} conn_param_stats_t;
+
+static conn_param_stats_t m_conn_param_stats;       /**< Counters of the connection parameter policy. */
+
+/**@brief PHYs counted separately by the PHY statistics.
+ */
+typedef enum
+{
+    PHY_STATS_1M,
+    PHY_STATS_2M,
+    PHY_STATS_CODED,
+    PHY_STATS_COUNT
+} phy_stats_idx_t;
+
+/**@brief LED writes and link drops on one PHY.
+ */
+typedef struct
+{
+    uint32_t writes;                                /**< LED writes sent. */
+    uint32_t airtime_us;                            /**< On-air time of those writes. */
+    uint32_t drops;                                 /**< Links lost to a supervision timeout. */
+} phy_stats_t;
+
+static phy_stats_t m_phy_stats[PHY_STATS_COUNT];    /**< Statistics per PHY, indexed by @ref phy_stats_idx_t. */
+
+#if LATENCY_BENCH_ENABLED
+/**@brief Latency of the LED writes on links using one connection interval.
+ */
+typedef struct
+{
+    uint16_t conn_interval;                         /**< Connection interval of the slot in 1.25 ms units, 0 if unused. */
+    uint32_t count;                                 /**< Writes measured. */
+    uint64_t queue_us_total;                        /**< Sum of the times from the blink tick to the SoftDevice. */
+    uint64_t air_us_total;                          /**< Sum of the times from the SoftDevice to the write response. */
+    uint32_t max_us;                                /**< Longest time from the blink tick to the write response. */
+    uint32_t hist[LATENCY_BENCH_BUCKET_COUNT];      /**< Writes per LATENCY_BENCH_BUCKET_US wide bucket of tick to response time. */
+} latency_bench_slot_t;
+
+static latency_bench_slot_t m_latency_bench[LATENCY_BENCH_SLOT_COUNT];  /**< Latency histograms, one per connection interval. */
+static volatile uint32_t    m_led_tick_at;                               /**< app_timer counter value of the last blink tick. */
+#endif
+
+/**@brief Scan interval and window of one duty cycle level, in units of 0.625 millisecond.
+ */
+typedef struct
+{
+    uint16_t interval;
+    uint16_t window;
+} scan_level_t;
+
+static scan_level_t const m_scan_levels[] =                    /**< Duty cycle levels, from the fastest to the lowest. */
+{
+    {SCAN_INTERVAL, SCAN_WINDOW},                               /**< 100 ms every 200 ms (50 %). */
+    {0x0140,        0x0050},                                    /**< 50 ms every 200 ms (25 %). */
+    {0x0640,        0x0050},                                    /**< 50 ms every second (5 %). */
+    {0x0C80,        0x0050},                                    /**< 50 ms every two seconds (2.5 %). */
+};
+
+/**@brief State of the adaptive scanner.
+ */
+typedef struct
+{
+    uint8_t  level;                                 /**< Index in m_scan_levels. */
+    bool     scanning;                              /**< The scanner is running. */
+    uint32_t since;                                 /**< app_timer counter value of the last accounting. */
+    uint32_t last_sighting;                         /**< app_timer counter value of the last target report. */
+    uint64_t radio_on_ticks;                        /**< Sum of the scan windows, in app_timer ticks. */
+    uint32_t wakeups;                               /**< Sightings that brought the scanner back to the fastest level. */
+    uint32_t checks;                                /**< Duty cycle checks since the last report. */
+} scan_adapt_t;
+
+static scan_adapt_t m_scan_adapt;                   /**< Adaptive scanner. */
+APP_TIMER_DEF(m_scan_adapt_timer_id);               /**< Periodic duty cycle check. */
+
+static central_connect_t m_connect = { .state = CONN_STATE_SCANNING };  /**< Connection attempt state machine. */
+static uint64_t          m_conn_state_ticks[CONN_STATE_COUNT];          /**< Time spent in each state by the central and all links, in app_timer ticks. */
+APP_TIMER_DEF(m_connect_retry_timer_id);                                /**< Ends CONN_STATE_BACKOFF. */
+
+static isr_stats_t m_led_isr_stats;                 /**< Residency statistics of timer_led_event_handler. */
+static isr_stats_t m_ble_evt_stats;                 /**< Residency statistics of the BLE observer. */
+
+#if BLE_EVT_CAPTURE_ENABLED
+static uint8_t  m_ble_evt_capture_buf[BLE_EVT_CAPTURE_BUF_SIZE];        /**< RTT buffer of the capture channel, drained by the debugger. */
+static uint8_t  m_ble_evt_capture_record[sizeof(uint16_t) + sizeof(uint32_t) +
+                                         BLE_EVT_CAPTURE_EVT_SIZE_MAX + BLE_GAP_ADV_SET_DATA_SIZE_MAX];  /**< One record, assembled before it is written. */
+static uint32_t m_ble_evt_capture_dropped;                               /**< Records lost because the capture channel was full. */
+#endif
+
+#if EVT_PROFILER_ENABLED
+/**@brief Event handlers followed by the profiler.
+ */
+typedef enum
+{
+    EVT_PROF_SRC_BLE,                               /**< ble_evt_handler, keyed by the SoftDevice event ID. */
+    EVT_PROF_SRC_LBS_C,                             /**< lbs_c_evt_handler, keyed by the LBS client event type. */
+    EVT_PROF_SRC_SCAN,                              /**< scan_evt_handler, keyed by the scanning module event ID. */
+} evt_prof_src_t;
+
+/**@brief Cycle statistics of one event of one handler.
+ */
+typedef struct
+{
+    bool     in_use;                                /**< The slot follows an event. */
+    uint8_t  src;                                   /**< Handler of the event, see @ref evt_prof_src_t. */
+    uint16_t evt_id;                                /**< Event ID within the handler. */
+    uint32_t count;                                 /**< Calls measured. */
+    uint32_t cycles_min;                            /**< Shortest call in cycles. */
+    uint32_t cycles_max;                            /**< Longest call in cycles. */
+    uint64_t cycles_total;                          /**< Sum of the cycles of all calls. */
+    uint32_t hist[EVT_PROFILER_BUCKET_COUNT];       /**< Calls per bucket, bucket b holds calls shorter than 2^b cycles. */
+} evt_prof_slot_t;
+
+static evt_prof_slot_t m_evt_prof[EVT_PROFILER_SLOT_COUNT];  /**< Profiler slots, allocated on the first call of each event. */
+static uint32_t        m_evt_prof_overflow;                  /**< Calls not measured because every slot was taken. */
+APP_TIMER_DEF(m_evt_prof_timer_id);                          /**< Periodic profiler report. */
+
+#define EVT_PROFILE_BEGIN()             uint32_t evt_prof_start = EVT_PROFILER_CYCLES()
+#define EVT_PROFILE_END(src, evt_id)    evt_profiler_record((src), (evt_id), evt_prof_start)
+#else
+#define EVT_PROFILE_BEGIN()
+#define EVT_PROFILE_END(src, evt_id)
+#endif
+
+/**@brief Spread between the links of the times the synchronized LED writes were acknowledged.
+ */
+typedef struct
+{
+    uint32_t round_first;                           /**< First acknowledgement of the current blink, in app_timer ticks. */
+    uint32_t round_last;                            /**< Last acknowledgement of the current blink, in app_timer ticks. */
+    uint32_t round_count;                           /**< Links that acknowledged the current blink. */
+    uint32_t rounds;                                /**< Blinks measured since the last report. */
+    uint32_t jitter_total_us;                       /**< Sum of the spreads of those blinks. */
+    uint32_t jitter_max_us;                         /**< Largest of those spreads. */
+} led_sync_stats_t;
+
+static led_sync_stats_t m_led_sync_stats;           /**< Cross-link jitter of the synchronized blink. */
+
+static lbs_handle_cache_entry_t m_lbs_handle_cache[LBS_HANDLE_CACHE_SIZE];  /**< RAM cache of discovered LBS handles. */
+static uint32_t                 m_lbs_handle_cache_clock;                   /**< Incremented on every cache use, orders the entries by last use. */
+
+/**@brief Cursor over the AD structures of an advertising or scan response payload.
+ */
+typedef struct
+{
+    uint8_t const * p_data;                         /**< Payload being walked, owned by the SoftDevice. */
+    uint16_t        len;                            /**< Length of the payload. */
+    uint16_t        offset;                         /**< Offset of the next AD structure. */
+} ad_iter_t;
+
+/**@brief One AD structure, pointing into the payload it was found in.
+ */
+typedef struct
+{
+    uint8_t         type;                           /**< AD type, one of BLE_GAP_AD_TYPE_*. */
+    uint8_t         len;                            /**< Length of the value. */
+    uint8_t const * p_value;                        /**< Value of the AD structure. */
+} ad_element_t;
+
+//RSSI filter configuration
+#define RSSI_FILTER_MODE            0                                   /**< Most frequent value of the last MAX_RSSI_BUFF_SIZE samples. */
+#define RSSI_FILTER_MEDIAN          1                                   /**< Median of the last MAX_RSSI_BUFF_SIZE samples. */
+#define RSSI_FILTER_EWMA            2                                   /**< Exponentially weighted moving average. */
+#define RSSI_FILTER_KALMAN          3                                   /**< One-dimensional Kalman filter with a constant-value model. */
+
+#ifndef RSSI_FILTER_TYPE
+#define RSSI_FILTER_TYPE            RSSI_FILTER_MODE                    /**< RSSI filter back-end used for proximity decisions. */
+#endif
+
+#define RSSI_EWMA_WEIGHT_SHIFT      3                                   /**< A new sample weighs 1/2^n in the EWMA filter. */
+#define RSSI_KALMAN_PROCESS_NOISE   0.05f                               /**< Variance added to the Kalman estimate per sample, in dBm^2. */
+#define RSSI_KALMAN_MEASURE_NOISE   9.0f                                /**< Variance of a single RSSI measurement, in dBm^2. */
+
+#define RSSI_MODE_MIN_DBM           -127                                /**< Lowest RSSI tracked by the mode filter, smaller samples are clamped. */
+#define RSSI_MODE_MAX_DBM           0                                   /**< Highest RSSI tracked by the mode filter, larger samples are clamped. */
+#define RSSI_MODE_BINS              (RSSI_MODE_MAX_DBM - RSSI_MODE_MIN_DBM + 1)
+#define RSSI_MODE_NIL               0xFF                                /**< End of a count list. */
+#define RSSI_PEER_POOL_SIZE         8                                   /**< Number of advertisers whose RSSI history is tracked at the same time. */
+
+STATIC_ASSERT(RSSI_MODE_BINS < RSSI_MODE_NIL);
+
+#if (RSSI_FILTER_TYPE == RSSI_FILTER_MODE)
+/**@brief Sliding-window RSSI mode filter.
+ *
+ * @details Keeps a histogram of the samples in the window plus, for every occurrence count,
+ *          a doubly linked list of the RSSI values seen exactly that many times. Adding or
+ *          evicting a sample moves one value to the neighbouring list, so both the update
+ *          and the mode lookup take constant time whatever MAX_RSSI_BUFF_SIZE is.
+ */
+typedef struct
+{
+    int8_t   window[MAX_RSSI_BUFF_SIZE];            /**< Ring buffer with the samples currently in the window. */
+    uint16_t head;                                  /**< Position where the next sample is stored. */
+    uint16_t fill;                                  /**< Number of valid samples in the window. */
+    uint16_t max_count;                             /**< Highest occurrence count in the window. */
+    uint16_t count[RSSI_MODE_BINS];                 /**< Occurrences of every RSSI value in the window. */
+    uint8_t  next[RSSI_MODE_BINS];                  /**< Next value in the same count list. */
+    uint8_t  prev[RSSI_MODE_BINS];                  /**< Previous value in the same count list. */
+    uint8_t  list[MAX_RSSI_BUFF_SIZE + 1];          /**< First value of the list of values seen n times. */
+} rssi_mode_filter_t;
+
+typedef rssi_mode_filter_t   rssi_filter_t;
+#elif (RSSI_FILTER_TYPE == RSSI_FILTER_MEDIAN)
+/**@brief Sliding-window RSSI median filter.
+ *
+ * @details The window is mirrored in a sorted array. Every sample costs one removal and one
+ *          insertion in that array, and the median is read from its middle element.
+ */
+typedef struct
+{
+    int8_t   window[MAX_RSSI_BUFF_SIZE];            /**< Ring buffer with the samples currently in the window. */
+    int8_t   sorted[MAX_RSSI_BUFF_SIZE];            /**< Samples of the window in ascending order. */
+    uint16_t head;                                  /**< Position where the next sample is stored. */
+    uint16_t fill;                                  /**< Number of valid samples in the window. */
+} rssi_median_filter_t;
+
+typedef rssi_median_filter_t rssi_filter_t;
+#elif (RSSI_FILTER_TYPE == RSSI_FILTER_EWMA)
+/**@brief Exponentially weighted moving average of the RSSI.
+ */
+typedef struct
+{
+    int32_t  average;                               /**< Current average in 1/256 dBm. */
+    bool     valid;                                 /**< At least one sample has been received. */
+} rssi_ewma_filter_t;
+
+typedef rssi_ewma_filter_t   rssi_filter_t;
+#elif (RSSI_FILTER_TYPE == RSSI_FILTER_KALMAN)
+/**@brief One-dimensional Kalman filter tracking a slowly varying RSSI.
+ */
+typedef struct
+{
+    float    estimate;                              /**< Current RSSI estimate in dBm. */
+    float    variance;                              /**< Variance of the estimate in dBm^2. */
+    bool     valid;                                 /**< At least one sample has been received. */
+} rssi_kalman_filter_t;
+
+typedef rssi_kalman_filter_t rssi_filter_t;
+#else
+#error "Unsupported RSSI_FILTER_TYPE."
+#endif
+
+/**@brief Proximity of a peer, decided with hysteresis on the filtered RSSI.
+ */
+typedef enum
+{
+    PROXIMITY_FAR,                                  /**< Filtered RSSI stayed at or below DISCONNECTION_RSSI_THRESHOLD. The peer must not be connected. */
+    PROXIMITY_NEAR,                                 /**< Filtered RSSI stayed above RSSI_THRESHOLD. The peer should be connected. */
+} proximity_state_t;
+
+/**@brief Counters of the proximity state machine.
+ */
+typedef struct
+{
+    uint32_t near_transitions;                      /**< Far to near transitions, each one allows a connection. */
+    uint32_t far_transitions;                       /**< Near to far transitions, each one ends a connection. */
+    uint32_t cycles_saved;                          /**< Drops below RSSI_THRESHOLD that a single threshold would have turned into a disconnection. */
+} proximity_stats_t;
+
+/**@brief RSSI history of one peer, shared by its advertising and connected RSSI paths.
+ */
+typedef struct
+{
+    bool               in_use;                      /**< Entry holds a peer. */
+    ble_gap_addr_t     addr;                        /**< Address of the peer, key of the entry. */
+    uint16_t           conn_handle;                 /**< Connection handle of the peer, BLE_CONN_HANDLE_INVALID when not connected. */
+    uint16_t           sample_count;                /**< Samples received, saturates at MAX_RSSI_BUFF_SIZE once the window is warm. */
+    uint32_t           last_seen;                   /**< Value of m_rssi_peer_clock at the last sample, used to pick the entry to evict. */
+    proximity_state_t  proximity;                   /**< Current near/far state of the peer. */
+    bool               transition_pending;          /**< Filtered RSSI is past the threshold that leaves the current state. */
+    uint32_t           transition_start;            /**< app_timer counter value when transition_pending was set. */
+    uint32_t           last_update;                 /**< app_timer counter value of the last proximity decision. */
+    bool               above_threshold;             /**< Filtered RSSI was above RSSI_THRESHOLD at the last decision. */
+    rssi_filter_t      filter;                      /**< RSSI filter of the peer. */
+} rssi_peer_t;
+
+static rssi_peer_t m_rssi_peers[RSSI_PEER_POOL_SIZE];  /**< Fixed pool of per-peer RSSI contexts. */
+static uint32_t    m_rssi_peer_clock;                  /**< Incremented on every sample, orders the entries by last use. */
+static proximity_stats_t m_proximity_stats;            /**< Counters of the proximity state machine for all peers. */
+
+/**@brief Function to handle asserts in the SoftDevice.
+ *
+ * @details This function will be called in case of an assert in the SoftDevice.
+ *
+ * @warning This handler is an example only and does not fit a final product. You need to analyze
+ *          how your product is supposed to react in case of Assert.
+ * @warning On assert from the SoftDevice, the system can only recover on reset.
+ *
+ * @param[in] line_num     Line number of the failing ASSERT call.
+ * @param[in] p_file_name  File name of the failing ASSERT call.
+ */
+void assert_nrf_callback(uint16_t line_num, const uint8_t * p_file_name)
+{
+    app_error_handler(0xDEADBEEF, line_num, p_file_name);
+}
+
+#if EVT_PROFILER_ENABLED
+/**@brief Function for accounting one call of an event handler.
+ *
+ * @param[in]   src         Handler that was called.
+ * @param[in]   evt_id      Event given to the handler.
+ * @param[in]   start       Cycle counter value at the handler entry.
+ */
+static void evt_profiler_record(evt_prof_src_t src, uint16_t evt_id, uint32_t start)
+{
+    uint32_t          cycles = EVT_PROFILER_CYCLES() - start;
+    evt_prof_slot_t * p_slot = NULL;
+    uint32_t          bucket;
+
+    for (uint32_t i = 0; i < EVT_PROFILER_SLOT_COUNT; i++)
+    {
+        if (!m_evt_prof[i].in_use)
+        {
+            p_slot             = &m_evt_prof[i];
+            p_slot->in_use     = true;
+            p_slot->src        = src;
+            p_slot->evt_id     = evt_id;
+            p_slot->cycles_min = UINT32_MAX;
+            break;
+        }
+        if ((m_evt_prof[i].src == src) && (m_evt_prof[i].evt_id == evt_id))
+        {
+            p_slot = &m_evt_prof[i];
+            break;
+        }
+    }
+    if (p_slot == NULL)
+    {
+        m_evt_prof_overflow++;
+        return;
+    }
+
+    bucket = (cycles == 0) ? 0 : (32 - __CLZ(cycles));
+    bucket = MIN(bucket, EVT_PROFILER_BUCKET_COUNT - 1);
+
+    p_slot->count++;
+    p_slot->cycles_total += cycles;
+    p_slot->cycles_min    = MIN(p_slot->cycles_min, cycles);
+    p_slot->cycles_max    = MAX(p_slot->cycles_max, cycles);
+    p_slot->hist[bucket]++;
+}
+
+/**@brief Function for estimating the 99th percentile of a slot from its histogram.
+ *
+ * @return Upper bound of the bucket holding the 99th percentile, in cycles.
+ */
+static uint32_t evt_profiler_p99(evt_prof_slot_t const * p_slot)
+{
+    uint32_t needed = (uint32_t)(((uint64_t)p_slot->count * 99 + 99) / 100);
+    uint32_t seen   = 0;
+
+    for (uint32_t b = 0; b < EVT_PROFILER_BUCKET_COUNT - 1; b++)
+    {
+        seen += p_slot->hist[b];
+        if (seen >= needed)
+        {
+            return MIN((uint32_t)1 << b, p_slot->cycles_max);
+        }
+    }
+    return p_slot->cycles_max;
+}
+
+/**@brief Function for reporting the profiler slots on RTT.
+ */
+static void evt_profiler_dump(void * p_event_data, uint16_t event_size)
+{
+    static char const * const src_names[] = {"ble", "lbs_c", "scan"};
+
+    for (uint32_t i = 0; i < EVT_PROFILER_SLOT_COUNT; i++)
+    {
+        evt_prof_slot_t slot;
+
+        CRITICAL_REGION_ENTER();
+        slot = m_evt_prof[i];
+        CRITICAL_REGION_EXIT();
+
+        if (!slot.in_use)
+        {
+            break;
+        }
+        // nrf_log takes at most 6 arguments per entry.
+        NRF_LOG_RAW_INFO("prof %s 0x%02x: n %d, min %d, mean %d cycles\n",
+                         src_names[slot.src], slot.evt_id, slot.count, slot.cycles_min,
+                         (uint32_t)(slot.cycles_total / slot.count));
+        NRF_LOG_RAW_INFO("prof %s 0x%02x: max %d, p99 <= %d cycles\n",
+                         src_names[slot.src], slot.evt_id, slot.cycles_max, evt_profiler_p99(&slot));
+    }
+    if (m_evt_prof_overflow != 0)
+    {
+        NRF_LOG_RAW_INFO("prof: %d calls not measured, no free slot\n", m_evt_prof_overflow);
+    }
+}
+
+/**@brief Function for handling the profiler report timeout.
+ */
+static void evt_profiler_timer_handler(void * p_context)
+{
+    UNUSED_RETURN_VALUE(app_sched_event_put(NULL, 0, evt_profiler_dump));
+}
+
+/**@brief Function for starting the periodic profiler report.
+ */
+static void evt_profiler_init(void)
+{
+    ret_code_t err_code;
+
+    err_code = app_timer_create(&m_evt_prof_timer_id, APP_TIMER_MODE_REPEATED, evt_profiler_timer_handler);
+    APP_ERROR_CHECK(err_code);
+    err_code = app_timer_start(m_evt_prof_timer_id, APP_TIMER_TICKS(EVT_PROFILER_DUMP_INTERVAL_MS), NULL);
+    APP_ERROR_CHECK(err_code);
+}
+#endif // EVT_PROFILER_ENABLED
+
+#if (RSSI_FILTER_TYPE == RSSI_FILTER_MODE)
+/**@brief Function for resetting a mode filter to an empty window.
+ *
+ * @param[out] p_filter  Filter to reset.
+ */
+static void rssi_mode_filter_init(rssi_mode_filter_t * p_filter)
+{
+    memset(p_filter, 0, sizeof(rssi_mode_filter_t));
+    memset(p_filter->list, RSSI_MODE_NIL, sizeof(p_filter->list));
+}
+
+/**@brief Function for unlinking a value from the list matching its current count.
+ */
+static void rssi_mode_list_remove(rssi_mode_filter_t * p_filter, uint8_t bin)
+{
+    uint8_t next = p_filter->next[bin];
+    uint8_t prev = p_filter->prev[bin];
+
+    if (prev == RSSI_MODE_NIL)
+    {
+        p_filter->list[p_filter->count[bin]] = next;
+    }
+    else
+    {
+        p_filter->next[prev] = next;
+    }
+
+    if (next != RSSI_MODE_NIL)
+    {
+        p_filter->prev[next] = prev;
+    }
+}
+
+/**@brief Function for linking a value at the front of the list matching its current count.
+ *
+ * @details Inserting at the front makes the most recently promoted value win a tie.
+ */
+static void rssi_mode_list_insert(rssi_mode_filter_t * p_filter, uint8_t bin)
+{
+    uint8_t head = p_filter->list[p_filter->count[bin]];
+
+    p_filter->prev[bin] = RSSI_MODE_NIL;
+    p_filter->next[bin] = head;
+    if (head != RSSI_MODE_NIL)
+    {
+        p_filter->prev[head] = bin;
+    }
+    p_filter->list[p_filter->count[bin]] = bin;
+}
+
+/**@brief Function for adding a sample to the window, evicting the oldest one when it is full.
+ *
+ * @param[in,out] p_filter  Filter to update.
+ * @param[in]     rssi      New RSSI sample in dBm.
+ */
+static void rssi_mode_filter_push(rssi_mode_filter_t * p_filter, int8_t rssi)
+{
+    uint8_t bin;
+
+    if (rssi < RSSI_MODE_MIN_DBM)
+    {
+        rssi = RSSI_MODE_MIN_DBM;
+    }
+    else if (rssi > RSSI_MODE_MAX_DBM)
+    {
+        rssi = RSSI_MODE_MAX_DBM;
+    }
+
+    if (p_filter->fill == MAX_RSSI_BUFF_SIZE)
+    {
+        // Evict the oldest sample, which is the one about to be overwritten.
+        bin = (uint8_t)(p_filter->window[p_filter->head] - RSSI_MODE_MIN_DBM);
+
+        rssi_mode_list_remove(p_filter, bin);
+        if ((p_filter->count[bin] == p_filter->max_count) &&
+            (p_filter->list[p_filter->max_count] == RSSI_MODE_NIL))
+        {
+            p_filter->max_count--;
+        }
+        if (--p_filter->count[bin] > 0)
+        {
+            rssi_mode_list_insert(p_filter, bin);
+        }
+    }
+    else
+    {
+        p_filter->fill++;
+    }
+
+    p_filter->window[p_filter->head] = rssi;
+    p_filter->head = (p_filter->head + 1) % MAX_RSSI_BUFF_SIZE;
+
+    bin = (uint8_t)(rssi - RSSI_MODE_MIN_DBM);
+    if (p_filter->count[bin] > 0)
+    {
+        rssi_mode_list_remove(p_filter, bin);
+    }
+    p_filter->count[bin]++;
+    rssi_mode_list_insert(p_filter, bin);
+    if (p_filter->count[bin] > p_filter->max_count)
+    {
+        p_filter->max_count = p_filter->count[bin];
+    }
+}
+
+/**@brief Function for getting the most frequent RSSI value in the window.
+ *
+ * @param[in] p_filter  Filter to query.
+ *
+ * @return Mode of the window in dBm, or 0 if the window is empty.
+ */
+static int8_t rssi_mode_filter_get(rssi_mode_filter_t const * p_filter)
+{
+    if (p_filter->max_count == 0)
+    {
+        return 0;
+    }
+    return (int8_t)(p_filter->list[p_filter->max_count] + RSSI_MODE_MIN_DBM);
+}
+#endif // RSSI_FILTER_TYPE == RSSI_FILTER_MODE
+
+#if (RSSI_FILTER_TYPE == RSSI_FILTER_MEDIAN)
+/**@brief Function for resetting a median filter to an empty window.
+ */
+static void rssi_median_filter_init(rssi_median_filter_t * p_filter)
+{
+    memset(p_filter, 0, sizeof(rssi_median_filter_t));
+}
+
+/**@brief Function for finding the first position in the sorted window not smaller than a value.
+ */
+static uint16_t rssi_median_lower_bound(rssi_median_filter_t const * p_filter, int8_t rssi)
+{
+    uint16_t low  = 0;
+    uint16_t high = p_filter->fill;
+
+    while (low < high)
+    {
+        uint16_t mid = (low + high) / 2;
+
+        if (p_filter->sorted[mid] < rssi)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+/**@brief Function for adding a sample to the median window, evicting the oldest one when it is full.
+ */
+static void rssi_median_filter_push(rssi_median_filter_t * p_filter, int8_t rssi)
+{
+    uint16_t pos;
+
+    if (p_filter->fill == MAX_RSSI_BUFF_SIZE)
+    {
+        pos = rssi_median_lower_bound(p_filter, p_filter->window[p_filter->head]);
+        memmove(&p_filter->sorted[pos], &p_filter->sorted[pos + 1], p_filter->fill - pos - 1);
+        p_filter->fill--;
+    }
+
+    p_filter->window[p_filter->head] = rssi;
+    p_filter->head = (p_filter->head + 1) % MAX_RSSI_BUFF_SIZE;
+
+    pos = rssi_median_lower_bound(p_filter, rssi);
+    memmove(&p_filter->sorted[pos + 1], &p_filter->sorted[pos], p_filter->fill - pos);
+    p_filter->sorted[pos] = rssi;
+    p_filter->fill++;
+}
+
+/**@brief Function for getting the median RSSI of the window, 0 if the window is empty.
+ */
+static int8_t rssi_median_filter_get(rssi_median_filter_t const * p_filter)
+{
+    if (p_filter->fill == 0)
+    {
+        return 0;
+    }
+    return p_filter->sorted[p_filter->fill / 2];
+}
+#endif // RSSI_FILTER_TYPE == RSSI_FILTER_MEDIAN
+
+#if (RSSI_FILTER_TYPE == RSSI_FILTER_EWMA)
+/**@brief Function for resetting an EWMA filter.
+ */
+static void rssi_ewma_filter_init(rssi_ewma_filter_t * p_filter)
+{
+    p_filter->average = 0;
+    p_filter->valid   = false;
+}
+
+/**@brief Function for adding a sample to an EWMA filter.
+ */
+static void rssi_ewma_filter_push(rssi_ewma_filter_t * p_filter, int8_t rssi)
+{
+    int32_t sample = (int32_t)rssi * 256;
+
+    if (!p_filter->valid)
+    {
+        p_filter->average = sample;
+        p_filter->valid   = true;
+        return;
+    }
+    p_filter->average += (sample - p_filter->average) / (1 << RSSI_EWMA_WEIGHT_SHIFT);
+}
+
+/**@brief Function for getting the EWMA of the RSSI rounded to the nearest dBm.
+ */
+static int8_t rssi_ewma_filter_get(rssi_ewma_filter_t const * p_filter)
+{
+    int32_t average = p_filter->average;
+
+    return (int8_t)((average < 0) ? ((average - 128) / 256) : ((average + 128) / 256));
+}
+#endif // RSSI_FILTER_TYPE == RSSI_FILTER_EWMA
+
+#if (RSSI_FILTER_TYPE == RSSI_FILTER_KALMAN)
+/**@brief Function for resetting a Kalman filter.
+ */
+static void rssi_kalman_filter_init(rssi_kalman_filter_t * p_filter)
+{
+    p_filter->estimate = 0.0f;
+    p_filter->variance = 0.0f;
+    p_filter->valid    = false;
+}
+
+/**@brief Function for adding a sample to a Kalman filter.
+ */
+static void rssi_kalman_filter_push(rssi_kalman_filter_t * p_filter, int8_t rssi)
+{
+    float gain;
+
+    if (!p_filter->valid)
+    {
+        p_filter->estimate = rssi;
+        p_filter->variance = RSSI_KALMAN_MEASURE_NOISE;
+        p_filter->valid    = true;
+        return;
+    }
+
+    p_filter->variance += RSSI_KALMAN_PROCESS_NOISE;
+    gain                = p_filter->variance / (p_filter->variance + RSSI_KALMAN_MEASURE_NOISE);
+    p_filter->estimate += gain * ((float)rssi - p_filter->estimate);
+    p_filter->variance *= (1.0f - gain);
+}
+
+/**@brief Function for getting the Kalman RSSI estimate rounded to the nearest dBm.
+ */
+static int8_t rssi_kalman_filter_get(rssi_kalman_filter_t const * p_filter)
+{
+    float estimate = p_filter->estimate;
+
+    return (int8_t)((estimate < 0.0f) ? (estimate - 0.5f) : (estimate + 0.5f));
+}
+#endif // RSSI_FILTER_TYPE == RSSI_FILTER_KALMAN
+
+/**@brief Function for resetting the RSSI filter selected by RSSI_FILTER_TYPE.
+ */
+static void rssi_filter_init(rssi_filter_t * p_filter)
+{
+#if (RSSI_FILTER_TYPE == RSSI_FILTER_MODE)
+    rssi_mode_filter_init(p_filter);
+#elif (RSSI_FILTER_TYPE == RSSI_FILTER_MEDIAN)
+    rssi_median_filter_init(p_filter);
+#elif (RSSI_FILTER_TYPE == RSSI_FILTER_EWMA)
+    rssi_ewma_filter_init(p_filter);
+#else
+    rssi_kalman_filter_init(p_filter);
+#endif
+}
+
+/**@brief Function for adding a sample to the RSSI filter selected by RSSI_FILTER_TYPE.
+ */
+static void rssi_filter_push(rssi_filter_t * p_filter, int8_t rssi)
+{
+#if (RSSI_FILTER_TYPE == RSSI_FILTER_MODE)
+    rssi_mode_filter_push(p_filter, rssi);
+#elif (RSSI_FILTER_TYPE == RSSI_FILTER_MEDIAN)
+    rssi_median_filter_push(p_filter, rssi);
+#elif (RSSI_FILTER_TYPE == RSSI_FILTER_EWMA)
+    rssi_ewma_filter_push(p_filter, rssi);
+#else
+    rssi_kalman_filter_push(p_filter, rssi);
+#endif
+}
+
+/**@brief Function for getting the filtered RSSI in dBm from the filter selected by RSSI_FILTER_TYPE.
+ */
+static int8_t rssi_filter_get(rssi_filter_t const * p_filter)
+{
+#if (RSSI_FILTER_TYPE == RSSI_FILTER_MODE)
+    return rssi_mode_filter_get(p_filter);
+#elif (RSSI_FILTER_TYPE == RSSI_FILTER_MEDIAN)
+    return rssi_median_filter_get(p_filter);
+#elif (RSSI_FILTER_TYPE == RSSI_FILTER_EWMA)
+    return rssi_ewma_filter_get(p_filter);
+#else
+    return rssi_kalman_filter_get(p_filter);
+#endif
+}
+
+/**@brief Function for starting a walk over the AD structures of a report payload.
+ */
+static void ad_iter_init(ad_iter_t * p_iter, ble_data_t const * p_data)
+{
+    p_iter->p_data = p_data->p_data;
+    p_iter->len    = p_data->len;
+    p_iter->offset = 0;
+}
+
+/**@brief Function for getting the next AD structure of a payload without copying it.
+ *
+ * @details Stops at the first zero length field, which marks the start of the padding, and at
+ *          the first structure that does not fit in the payload.
+ *
+ * @param[in,out] p_iter     Cursor, advanced past the returned structure.
+ * @param[out]    p_element  Next AD structure.
+ *
+ * @return true if an AD structure was returned, false at the end of the payload.
+ */
+static bool ad_iter_next(ad_iter_t * p_iter, ad_element_t * p_element)
+{
+    uint16_t remaining = p_iter->len - p_iter->offset;
+    uint8_t  field_len;
+
+    if (p_iter->offset >= p_iter->len)
+    {
+        return false;
+    }
+
+    field_len = p_iter->p_data[p_iter->offset];
+    if ((field_len == 0) || (field_len >= remaining))
+    {
+        p_iter->offset = p_iter->len;
+        return false;
+    }
+
+    p_element->type    = p_iter->p_data[p_iter->offset + 1];
+    p_element->len     = field_len - 1;
+    p_element->p_value = &p_iter->p_data[p_iter->offset + 2];
+    p_iter->offset    += field_len + 1;
+    return true;
+}
+
+/**@brief Function for finding the first AD structure of a given type in a report payload.
+ *
+ * @param[in]  p_data     Advertising or scan response payload.
+ * @param[in]  type       AD type to look for.
+ * @param[out] p_element  Matching AD structure.
+ *
+ * @return true if the payload contains a well-formed structure of the given type.
+ */
+static bool ad_find(ble_data_t const * p_data, uint8_t type, ad_element_t * p_element)
+{
+    ad_iter_t iter;
+
+    ad_iter_init(&iter, p_data);
+    while (ad_iter_next(&iter, p_element))
+    {
+        if (p_element->type == type)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**@brief Function for checking whether a report payload carries the target complete local name.
+ */
+static bool ad_name_match(ble_data_t const * p_data)
+{
+    ad_element_t name;
+
+    return ad_find(p_data, BLE_GAP_AD_TYPE_COMPLETE_LOCAL_NAME, &name) &&
+           (name.len == (sizeof(m_target_periph_name) - 1)) &&
+           (memcmp(name.p_value, m_target_periph_name, name.len) == 0);
+}
+
+/**@brief Function for checking whether a report payload lists the target 128-bit service UUID.
+ *
+ * @details Each UUID of the list is compared in one pass over its 16 bytes, without an early
+ *          exit, against the binary m_target_periph_uuid.
+ */
+static bool ad_uuid_match(ble_data_t const * p_data)
+{
+    ad_iter_t    iter;
+    ad_element_t uuids;
+
+    ad_iter_init(&iter, p_data);
+    while (ad_iter_next(&iter, &uuids))
+    {
+        if ((uuids.type != BLE_GAP_AD_TYPE_128BIT_SERVICE_UUID_COMPLETE) &&
+            (uuids.type != BLE_GAP_AD_TYPE_128BIT_SERVICE_UUID_MORE_AVAILABLE))
+        {
+            continue;
+        }
+        for (uint32_t offset = 0; offset + UUID128_LEN <= uuids.len; offset += UUID128_LEN)
+        {
+            uint8_t diff = 0;
+
+            for (uint32_t i = 0; i < UUID128_LEN; i++)
+            {
+                diff |= uuids.p_value[offset + i] ^ m_target_periph_uuid[i];
+            }
+            if (diff == 0)
+            {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+/**@brief Function for comparing two BLE addresses, ignoring the identity resolution flag.
+ */
+static bool ble_addr_equal(ble_gap_addr_t const * p_addr1, ble_gap_addr_t const * p_addr2)
+{
+    return (p_addr1->addr_type == p_addr2->addr_type) &&
+           (memcmp(p_addr1->addr, p_addr2->addr, BLE_GAP_ADDR_LEN) == 0);
+}
+
+/**@brief Function for finding the RSSI context of a connected peer.
+ *
+ * @param[in] conn_handle  Connection handle of the peer.
+ *
+ * @return Context of the peer, or NULL if no context is bound to the connection.
+ */
+static rssi_peer_t * rssi_peer_find_by_conn(uint16_t conn_handle)
+{
+    for (uint32_t i = 0; i < RSSI_PEER_POOL_SIZE; i++)
+    {
+        if (m_rssi_peers[i].in_use && (m_rssi_peers[i].conn_handle == conn_handle))
+        {
+            return &m_rssi_peers[i];
+        }
+    }
+    return NULL;
+}
+
+/**@brief Function for getting the RSSI context of a peer, allocating one if the peer is new.
+ *
+ * @details When the pool is full, the least recently updated peer that is not connected is
+ *          evicted. Existing contexts keep their history across connections.
+ *
+ * @param[in] p_addr  Address of the peer.
+ *
+ * @return Context of the peer, or NULL if every entry belongs to a connected peer.
+ */
+static rssi_peer_t * rssi_peer_get(ble_gap_addr_t const * p_addr)
+{
+    rssi_peer_t * p_victim = NULL;
+
+    for (uint32_t i = 0; i < RSSI_PEER_POOL_SIZE; i++)
+    {
+        rssi_peer_t * p_peer = &m_rssi_peers[i];
+
+        if (!p_peer->in_use)
+        {
+            if ((p_victim == NULL) || p_victim->in_use)
+            {
+                p_victim = p_peer;
+            }
+            continue;
+        }
+        if (ble_addr_equal(&p_peer->addr, p_addr))
+        {
+            return p_peer;
+        }
+        if ((p_peer->conn_handle == BLE_CONN_HANDLE_INVALID) &&
+            ((p_victim == NULL) || (p_victim->in_use && (p_peer->last_seen < p_victim->last_seen))))
+        {
+            p_victim = p_peer;
+        }
+    }
+
+    if (p_victim != NULL)
+    {
+        p_victim->in_use         = true;
+        p_victim->addr           = *p_addr;
+        p_victim->conn_handle    = BLE_CONN_HANDLE_INVALID;
+        p_victim->sample_count   = 0;
+        p_victim->last_seen      = m_rssi_peer_clock;
+        p_victim->proximity          = PROXIMITY_FAR;
+        p_victim->transition_pending = false;
+        p_victim->above_threshold    = false;
+        rssi_filter_init(&p_victim->filter);
+    }
+    return p_victim;
+}
+
+/**@brief Function for adding an RSSI sample to the history of a peer.
+ *
+ * @details The window slides by one sample at a time, so once it is warm every new sample
+ *          can produce a proximity decision.
+ *
+ * @return true when the window holds MAX_RSSI_BUFF_SIZE samples and a decision can be made.
+ */
+static bool rssi_peer_sample_add(rssi_peer_t * p_peer, int8_t rssi)
+{
+    p_peer->last_seen = ++m_rssi_peer_clock;
+    rssi_filter_push(&p_peer->filter, rssi);
+    if (p_peer->sample_count < MAX_RSSI_BUFF_SIZE)
+    {
+        p_peer->sample_count++;
+    }
+    return (p_peer->sample_count == MAX_RSSI_BUFF_SIZE);
+}
+
+/**@brief Function for updating the near/far state of a peer with a new filtered RSSI.
+ *
+ * @details A far peer becomes near when the filtered RSSI stays above RSSI_THRESHOLD for
+ *          PROXIMITY_DWELL_MS, and a near peer becomes far when it stays at or below
+ *          DISCONNECTION_RSSI_THRESHOLD for the same time. Values between the two thresholds
+ *          keep the current state. A gap of PROXIMITY_DWELL_MS or more between two samples
+ *          restarts the dwell, since nothing is known about the RSSI in between.
+ *
+ * @param[in,out] p_peer  Peer to update.
+ * @param[in]     rssi    Filtered RSSI of the peer in dBm.
+ *
+ * @return New proximity state of the peer.
+ */
+static proximity_state_t proximity_update(rssi_peer_t * p_peer, int8_t rssi)
+{
+    bool     above_threshold = (rssi > RSSI_THRESHOLD);
+    bool     leaving;
+    uint32_t now = app_timer_cnt_get();
+
+    if (p_peer->proximity == PROXIMITY_NEAR)
+    {
+        leaving = (rssi <= DISCONNECTION_RSSI_THRESHOLD);
+        if (p_peer->above_threshold && !above_threshold)
+        {
+            // A single threshold would disconnect here, so this connection cycle is saved
+            // unless the peer actually ends up far.
+            m_proximity_stats.cycles_saved++;
+        }
+    }
+    else
+    {
+        leaving = above_threshold;
+    }
+    p_peer->above_threshold = above_threshold;
+
+    if (p_peer->transition_pending &&
+        (app_timer_cnt_diff_compute(now, p_peer->last_update) >= APP_TIMER_TICKS(PROXIMITY_DWELL_MS)))
+    {
+        p_peer->transition_pending = false;
+    }
+    p_peer->last_update = now;
+
+    if (!leaving)
+    {
+        p_peer->transition_pending = false;
+        return p_peer->proximity;
+    }
+    if (!p_peer->transition_pending)
+    {
+        p_peer->transition_pending = true;
+        p_peer->transition_start   = now;
+    }
+    if (app_timer_cnt_diff_compute(now, p_peer->transition_start) < APP_TIMER_TICKS(PROXIMITY_DWELL_MS))
+    {
+        return p_peer->proximity;
+    }
+
+    p_peer->transition_pending = false;
+    if (p_peer->proximity == PROXIMITY_NEAR)
+    {
+        p_peer->proximity = PROXIMITY_FAR;
+        m_proximity_stats.far_transitions++;
+        if (m_proximity_stats.cycles_saved > 0)
+        {
+            m_proximity_stats.cycles_saved--;
+        }
+    }
+    else
+    {
+        p_peer->proximity = PROXIMITY_NEAR;
+        m_proximity_stats.near_transitions++;
+    }
+    NRF_LOG_RAW_INFO("proximity %s: near %d, far %d, cycles saved %d\n",
+                     (p_peer->proximity == PROXIMITY_NEAR) ? "near" : "far",
+                     m_proximity_stats.near_transitions,
+                     m_proximity_stats.far_transitions,
+                     m_proximity_stats.cycles_saved);
+    return p_peer->proximity;
+}
+
+/**@brief Function for the LEDs initialization.
+ *
+ * @details Initializes all LEDs used by the application.
+ */
+static void leds_init(void)
+{
+    bsp_board_init(BSP_INIT_LEDS);
+}
+
+/**@brief Function for accounting the time spent so far in the current states.
+ *
+ * @details The RTC counter wraps every 512 seconds, so this has to run well within that period
+ *          for a state that lasts longer to be accounted in full.
+ */
+static void conn_state_account(void)
+{
+    uint32_t now = app_timer_cnt_get();
+
+    m_conn_state_ticks[m_connect.state] += app_timer_cnt_diff_compute(now, m_connect.state_since);
+    m_connect.state_since = now;
+    for (uint32_t i = 0; i < NRF_SDH_BLE_CENTRAL_LINK_COUNT; i++)
+    {
+        m_conn_state_ticks[m_links[i].state] += app_timer_cnt_diff_compute(now, m_links[i].state_since);
+        m_links[i].state_since = now;
+    }
+}
+
+/**@brief Function for accounting the scan radio time up to now.
+ */
+static void scan_adapt_account(void)
+{
+    uint32_t now     = app_timer_cnt_get();
+    uint32_t elapsed = app_timer_cnt_diff_compute(now, m_scan_adapt.since);
+
+    if (m_scan_adapt.scanning)
+    {
+        m_scan_adapt.radio_on_ticks += (uint64_t)elapsed * m_scan_levels[m_scan_adapt.level].window /
+                                       m_scan_levels[m_scan_adapt.level].interval;
+    }
+    m_scan_adapt.since = now;
+}
+
+/**@brief Function to start scanning.
+ *
+ * @details Uses the duty cycle of the current adaptive scanner level.
+ */
+static void scan_start(void) {
+    ret_code_t            err_code;
+    ble_gap_scan_params_t scan_params;
+
+    memset(&scan_params, 0, sizeof(scan_params));
+    scan_params.active    = 1;
+    scan_params.interval  = m_scan_levels[m_scan_adapt.level].interval;
+    scan_params.window    = m_scan_levels[m_scan_adapt.level].window;
+    scan_params.timeout   = SCAN_DURATION;
+    scan_params.scan_phys = BLE_GAP_PHY_1MBPS;
+
+    scan_adapt_account();
+    m_scan_adapt.scanning = true;
+
+    err_code = nrf_ble_scan_params_set(&m_scan, &scan_params);
+    APP_ERROR_CHECK(err_code);
+    err_code = nrf_ble_scan_start(&m_scan);
+    APP_ERROR_CHECK(err_code);
+}
+
+/**@brief Function for accounting that the SoftDevice stopped the scanner.
+ */
+static void scan_stopped(void)
+{
+    scan_adapt_account();
+    m_scan_adapt.scanning = false;
+}
+
+/**@brief Function for moving the scanner to another duty cycle level.
+ */
+static void scan_adapt_level_set(uint8_t level)
+{
+    scan_adapt_account();
+    m_scan_adapt.level = level;
+    if (m_scan_adapt.scanning)
+    {
+        scan_start();
+    }
+}
+
+/**@brief Function for handling a report from a target.
+ *
+ * @details Any target brings the scanner back to the fastest level.
+ */
+static void scan_adapt_sighting(void)
+{
+    m_scan_adapt.last_sighting = app_timer_cnt_get();
+    if (m_scan_adapt.level != 0)
+    {
+        m_scan_adapt.wakeups++;
+        scan_adapt_level_set(0);
+    }
+}
+
+/**@brief Function for lowering the scan duty cycle after a while without sightings.
+ *
+ * @details Runs from the main loop. The scanner is restarted from the BLE event handler as well,
+ *          so the level change is done with the BLE interrupt held off. The scanner statistics
+ *          are reported from here every SCAN_ADAPT_REPORT_CHECKS checks, including while no link
+ *          is up.
+ */
+static void scan_adapt_check_work(void * p_event_data, uint16_t event_size)
+{
+    scan_adapt_t stats;
+
+    CRITICAL_REGION_ENTER();
+    // The periodic check also keeps the state times from missing an RTC counter wrap.
+    conn_state_account();
+    // Same for the radio time, nothing else accounts it while the lowest level idles.
+    scan_adapt_account();
+    if (SCAN_ADAPT_ENABLED && (m_scan_adapt.level + 1 < ARRAY_SIZE(m_scan_levels)) &&
+        (app_timer_cnt_diff_compute(app_timer_cnt_get(), m_scan_adapt.last_sighting) >= APP_TIMER_TICKS(SCAN_IDLE_STEP_MS)))
+    {
+        // Restart the idle time so the next level is reached one step later.
+        m_scan_adapt.last_sighting = app_timer_cnt_get();
+        scan_adapt_level_set(m_scan_adapt.level + 1);
+    }
+    m_scan_adapt.checks++;
+    stats = m_scan_adapt;
+    if (m_scan_adapt.checks >= SCAN_ADAPT_REPORT_CHECKS)
+    {
+        m_scan_adapt.checks = 0;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (stats.checks >= SCAN_ADAPT_REPORT_CHECKS)
+    {
+        NRF_LOG_RAW_INFO("Scan: level %d, radio on %d ms, %d wake-ups\n", stats.level,
+                         TICKS_TO_MS(stats.radio_on_ticks), stats.wakeups);
+    }
+}
+
+/**@brief Function for handling the timeout of the duty cycle check.
+ */
+static void scan_adapt_timer_handler(void * p_context)
+{
+    UNUSED_RETURN_VALUE(app_sched_event_put(NULL, 0, scan_adapt_check_work));
+}
+
+/**@brief Function for getting the link table entry of a connection.
+ *
+ * @return Entry of the link, or NULL if the handle is outside the link table.
+ */
+static central_link_t * link_get(uint16_t conn_handle)
+{
+    if (conn_handle >= NRF_SDH_BLE_CENTRAL_LINK_COUNT)
+    {
+        return NULL;
+    }
+    return &m_links[conn_handle];
+}
+
+/**@brief Function for counting the connected links.
+ */
+static uint32_t link_connected_count(void)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < NRF_SDH_BLE_CENTRAL_LINK_COUNT; i++)
+    {
+        if (m_links[i].connected)
+        {
+            count++;
+        }
+    }
+    return count;
+}
+
+/**@brief Function for moving the central or a link to a new lifecycle state.
+ *
+ * @param[in,out] p_state       Current state, set to new_state.
+ * @param[in,out] p_since       Time the current state was entered, set to now.
+ * @param[in]     new_state     State to enter.
+ */
+static void conn_state_enter(conn_state_t * p_state, uint32_t * p_since, conn_state_t new_state)
+{
+    uint32_t now = app_timer_cnt_get();
+
+    m_conn_state_ticks[*p_state] += app_timer_cnt_diff_compute(now, *p_since);
+    *p_state = new_state;
+    *p_since = now;
+}
+
+/**@brief Function for moving a link to a new lifecycle state.
+ */
+static void link_state_set(central_link_t * p_link, conn_state_t new_state)
+{
+    conn_state_enter(&p_link->state, &p_link->state_since, new_state);
+}
+
+/**@brief Function for disconnecting a link once.
+ *
+ * @details Further requests while the disconnection is pending are ignored.
+ */
+static void link_disconnect(uint16_t conn_handle)
+{
+    ret_code_t       err_code;
+    central_link_t * p_link = link_get(conn_handle);
+
+    if ((p_link != NULL) && (p_link->state == CONN_STATE_DISCONNECTING))
+    {
+        return;
+    }
+    err_code = sd_ble_gap_disconnect(conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+    APP_ERROR_CHECK(err_code);
+    if (p_link != NULL)
+    {
+        link_state_set(p_link, CONN_STATE_DISCONNECTING);
+    }
+}
+
+/**@brief Function for getting the statistics entry of a PHY.
+ */
+static phy_stats_t * phy_stats_get(uint8_t phy)
+{
+    switch (phy)
+    {
+        case BLE_GAP_PHY_2MBPS:
+            return &m_phy_stats[PHY_STATS_2M];
+        case BLE_GAP_PHY_CODED:
+            return &m_phy_stats[PHY_STATS_CODED];
+        default:
+            return &m_phy_stats[PHY_STATS_1M];
+    }
+}
+
+/**@brief Function for computing the on-air time of an unencrypted link layer data packet.
+ *
+ * @param[in] phy       PHY of the link.
+ * @param[in] pdu_len   Length of the packet payload.
+ *
+ * @return Time on air of the packet in microseconds.
+ */
+static uint32_t phy_pdu_airtime_us(uint8_t phy, uint32_t pdu_len)
+{
+    switch (phy)
+    {
+        case BLE_GAP_PHY_2MBPS:
+            // Preamble, access address, header, payload and CRC at 2 Mbps.
+            return (2 + 4 + 2 + pdu_len + 3) * 4;
+        case BLE_GAP_PHY_CODED:
+            // Preamble, then access address, CI and TERM1 at S=8, then header, payload, CRC and TERM2 at S=8.
+            return 80 + (32 + 2 + 3) * 8 + ((2 + pdu_len + 3) * 8 + 3) * 8;
+        default:
+            return (1 + 4 + 2 + pdu_len + 3) * 8;
+    }
+}
+
+/**@brief Function for computing the on-air time of an ATT write in a single packet.
+ *
+ * @param[in] phy       PHY of the link.
+ * @param[in] value_len Length of the written value.
+ *
+ * @return Time on air of the data packet in microseconds, without the empty packet of the peer.
+ */
+static uint32_t phy_write_airtime_us(uint8_t phy, uint16_t value_len)
+{
+    // L2CAP header and ATT opcode and handle.
+    return phy_pdu_airtime_us(phy, value_len + 4 + 3);
+}
+
+/**@brief Function for estimating the write command payload a link carries in one connection event.
+ *
+ * @details Counts full length packets, each answered by an empty packet of the peer, that fit
+ *          in NRF_SDH_BLE_GAP_EVENT_LENGTH. Write commands of att_mtu bytes are split over as
+ *          many packets as the data length needs.
+ */
+static uint32_t link_bytes_per_event(central_link_t const * p_link)
+{
+    uint32_t pair_us   = phy_pdu_airtime_us(p_link->phy, p_link->data_length) + 150 +
+                         phy_pdu_airtime_us(p_link->phy, 0) + 150;
+    uint32_t packets   = (NRF_SDH_BLE_GAP_EVENT_LENGTH * UNIT_1_25_MS) / pair_us;
+    uint32_t fragments = CEIL_DIV(p_link->att_mtu + 4, p_link->data_length);
+
+    return (packets * (p_link->att_mtu - 3)) / fragments;
+}
+
+/**@brief Function for logging the negotiated packet sizes of a link.
+ */
+static void link_sizes_report(uint16_t conn_handle)
+{
+    central_link_t * p_link = link_get(conn_handle);
+
+    if (p_link == NULL)
+    {
+        return;
+    }
+    NRF_LOG_RAW_INFO("conn_handle 0x%x MTU %d, data length %d, PHY %d: %d bytes per connection event\n",
+                     conn_handle, p_link->att_mtu, p_link->data_length, p_link->phy,
+                     link_bytes_per_event(p_link));
+}
+
+/**@brief Function for asking the peer to move a link to another PHY.
+ *
+ * @details If the SoftDevice is busy with another procedure, the PHY is kept in phy_wanted and
+ *          requested again by @ref link_phy_retry. A PHY the peer refused is not asked for
+ *          again on the same connection.
+ */
+static void link_phy_request(uint16_t conn_handle, uint8_t phy)
+{
+    ret_code_t       err_code;
+    central_link_t * p_link = link_get(conn_handle);
+
+    if ((p_link == NULL) || (p_link->phy_refused & phy))
+    {
+        return;
+    }
+    p_link->phy_wanted = phy;
+    if (p_link->phy_preferred == phy)
+    {
+        return;
+    }
+
+    ble_gap_phys_t const phys =
+    {
+        .rx_phys = phy,
+        .tx_phys = phy,
+    };
+    err_code = sd_ble_gap_phy_update(conn_handle, &phys);
+    if ((err_code == NRF_ERROR_BUSY) || (err_code == NRF_ERROR_INVALID_STATE))
+    {
+        // Another procedure is running or the link is going down, try again on a later event.
+        return;
+    }
+    APP_ERROR_CHECK(err_code);
+    p_link->phy_preferred = phy;
+}
+
+/**@brief Function for requesting the PHY of a link again after the SoftDevice was busy.
+ *
+ * @details Called when a GATT procedure finished and on RSSI samples. The request done at
+ *          connection usually collides with the MTU and data length procedures that
+ *          nrf_ble_gatt starts first.
+ */
+static void link_phy_retry(uint16_t conn_handle)
+{
+    central_link_t * p_link = link_get(conn_handle);
+
+    if ((p_link != NULL) && (p_link->phy_wanted != p_link->phy_preferred))
+    {
+        link_phy_request(conn_handle, p_link->phy_wanted);
+    }
+}
+
+/**@brief Function for answering a connection parameter update request of a peer.
+ *
+ * @details The requested interval range is narrowed to the range of CONN_PROFILE. The shortest
+ *          interval left must also keep the connection events of all links within
+ *          CONN_AIRTIME_BUDGET_PERMILLE of the radio time, else it is raised until it does. The
+ *          request is rejected when no interval of the profile fits.
+ */
+static void conn_param_request_handle(uint16_t conn_handle, ble_gap_conn_params_t const * p_req)
+{
+    ret_code_t                    err_code;
+    ble_gap_conn_params_t const * p_profile  = &m_conn_profiles[CONN_PROFILE];
+    ble_gap_conn_params_t         params;
+    uint32_t                      others     = 0;
+    uint32_t                      budget_min = 0;
+
+    for (uint16_t i = 0; i < NRF_SDH_BLE_CENTRAL_LINK_COUNT; i++)
+    {
+        if (m_links[i].connected && (i != conn_handle))
+        {
+            uint32_t interval = (m_links[i].conn_interval != 0) ? m_links[i].conn_interval : p_profile->min_conn_interval;
+            others += (NRF_SDH_BLE_GAP_EVENT_LENGTH * 1000) / interval;
+        }
+    }
+
+    if (others < CONN_AIRTIME_BUDGET_PERMILLE)
+    {
+        budget_min = CEIL_DIV(NRF_SDH_BLE_GAP_EVENT_LENGTH * 1000, CONN_AIRTIME_BUDGET_PERMILLE - others);
+    }
+
+    params.min_conn_interval = MAX(MAX(p_req->min_conn_interval, p_profile->min_conn_interval), budget_min);
+    params.max_conn_interval = MIN(p_req->max_conn_interval, p_profile->max_conn_interval);
+    params.slave_latency     = MIN(p_req->slave_latency, p_profile->slave_latency);
+    params.conn_sup_timeout  = MAX(p_req->conn_sup_timeout, p_profile->conn_sup_timeout);
+    if (params.min_conn_interval > params.max_conn_interval)
+    {
+        // The request is outside the profile, offer the whole profile range instead.
+        params.min_conn_interval = MAX(p_profile->min_conn_interval, budget_min);
+        params.max_conn_interval = p_profile->max_conn_interval;
+    }
+
+    if ((others >= CONN_AIRTIME_BUDGET_PERMILLE) || (params.min_conn_interval > params.max_conn_interval))
+    {
+        m_conn_param_stats.rejected++;
+        NRF_LOG_RAW_INFO("conn_handle 0x%x params %d-%d rejected\n", conn_handle,
+                         p_req->min_conn_interval, p_req->max_conn_interval);
+        // NULL rejects the request of the peer.
+        err_code = sd_ble_gap_conn_param_update(conn_handle, NULL);
+    }
+    else
+    {
+        if (memcmp(&params, p_req, sizeof(params)) == 0)
+        {
+            m_conn_param_stats.accepted++;
+        }
+        else
+        {
+            m_conn_param_stats.clamped++;
+        }
+        NRF_LOG_RAW_INFO("conn_handle 0x%x params %d-%d, answered %d-%d latency %d\n", conn_handle,
+                         p_req->min_conn_interval, p_req->max_conn_interval,
+                         params.min_conn_interval, params.max_conn_interval, params.slave_latency);
+        err_code = sd_ble_gap_conn_param_update(conn_handle, &params);
+    }
+    // NRF_ERROR_INVALID_STATE: the link is going down already.
+    if (err_code != NRF_ERROR_INVALID_STATE)
+    {
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+/**@brief Function for starting a connection attempt to the peer in m_connect.
+ *
+ * @details The SoftDevice stops scanning while the attempt is pending.
+ */
+static void connect_start(void)
+{
+    ret_code_t            err_code;
+    ble_gap_scan_params_t scan_params;
+
+    memset(&scan_params, 0, sizeof(ble_gap_scan_params_t));
+    scan_params.interval = SCAN_INTERVAL;
+    scan_params.window = SCAN_WINDOW;
+    scan_params.timeout = CONNECT_TIMEOUT;
+
+    m_connect.attempts++;
+    err_code = sd_ble_gap_connect(&m_connect.peer_addr, &scan_params, &m_conn_profiles[CONN_PROFILE], APP_BLE_CONN_CFG_TAG);
+    if (err_code == NRF_SUCCESS)
+    {
+        scan_stopped();
+        conn_state_enter(&m_connect.state, &m_connect.state_since, CONN_STATE_CONNECTING);
+        return;
+    }
+
+    // No free link or connection configuration, try again on a later report.
+    NRF_LOG_RAW_INFO("sd_ble_gap_connect failed 0x%x\n", err_code);
+    conn_state_enter(&m_connect.state, &m_connect.state_since, CONN_STATE_SCANNING);
+    scan_start();
+}
+
+/**@brief Function for retrying a timed-out connection attempt.
+ *
+ * @details Runs from the main loop. The scanner and the state statistics are updated from the
+ *          BLE event handler as well, so the retry is done with the BLE interrupt held off.
+ */
+static void connect_retry_work(void * p_event_data, uint16_t event_size)
+{
+    CRITICAL_REGION_ENTER();
+    if (m_connect.state == CONN_STATE_BACKOFF)
+    {
+        connect_start();
+    }
+    CRITICAL_REGION_EXIT();
+}
+
+/**@brief Function for handling the end of the connection retry backoff.
+ */
+static void connect_retry_timer_handler(void * p_context)
+{
+    if (app_sched_event_put(NULL, 0, connect_retry_work) != NRF_SUCCESS)
+    {
+        // Do not stay in CONN_STATE_BACKOFF for good, try again once the queue has drained.
+        UNUSED_RETURN_VALUE(app_timer_start(m_connect_retry_timer_id, APP_TIMER_TICKS(CONNECT_BACKOFF_MS), NULL));
+    }
+}
+
+/**@brief Function for handling the timeout of a connection attempt.
+ *
+ * @details Retries the same peer with an exponential backoff, then gives up and scans again.
+ */
+static void connect_timeout_handle(void)
+{
+    ret_code_t err_code;
+
+    if (m_connect.attempts >= CONNECT_RETRY_MAX + 1)
+    {
+        NRF_LOG_RAW_INFO("connection failed after %d attempts\n", m_connect.attempts);
+        conn_state_enter(&m_connect.state, &m_connect.state_since, CONN_STATE_SCANNING);
+        scan_start();
+        return;
+    }
+
+    conn_state_enter(&m_connect.state, &m_connect.state_since, CONN_STATE_BACKOFF);
+    err_code = app_timer_start(m_connect_retry_timer_id,
+                               APP_TIMER_TICKS(CONNECT_BACKOFF_MS << (m_connect.attempts - 1)), NULL);
+    APP_ERROR_CHECK(err_code);
+    // Keep the peer histories up to date meanwhile.
+    scan_start();
+}
+
+/**@brief Function for running the blink timer only while at least one link can receive LED writes.
+ */
+static void led_timer_update(void)
+{
+    bool any_ready = false;
+
+    for (uint32_t i = 0; i < NRF_SDH_BLE_CENTRAL_LINK_COUNT; i++)
+    {
+        any_ready |= m_links[i].lbs_ready;
+    }
+
+    if (any_ready && !m_led_timer_running)
+    {
+        nrf_drv_gpiote_out_task_enable(BLINK_LED_PIN);
+#if LED_BLINK_USE_APP_TIMER
+        ret_code_t err_code = app_timer_start(m_led_timer_id, APP_TIMER_TICKS(BLINK_TIME_INTERVAL_MS), NULL);
+        APP_ERROR_CHECK(err_code);
+#else
+        nrf_drv_timer_enable(&TIMER_LED);
+#endif
+    }
+    else if (!any_ready && m_led_timer_running)
+    {
+#if LED_BLINK_USE_APP_TIMER
+        ret_code_t err_code = app_timer_stop(m_led_timer_id);
+        APP_ERROR_CHECK(err_code);
+#else
+        nrf_drv_timer_disable(&TIMER_LED);
+#endif
+        // Give the pin back to the GPIO peripheral so it can be switched off.
+        nrf_drv_gpiote_out_task_disable(BLINK_LED_PIN);
+        bsp_board_led_off(BSP_BOARD_LED_0);
+    }
+    m_led_timer_running = any_ready;
+}
+
+/**@brief Function for looking up the cached LBS handles of a peer.
+ *
+ * @return Cache entry of the peer, or NULL if the peer was never discovered.
+ */
+static lbs_handle_cache_entry_t * lbs_handle_cache_find(ble_gap_addr_t const * p_addr)
+{
+    for (uint32_t i = 0; i < LBS_HANDLE_CACHE_SIZE; i++)
+    {
+        if (m_lbs_handle_cache[i].in_use && ble_addr_equal(&m_lbs_handle_cache[i].addr, p_addr))
+        {
+            m_lbs_handle_cache[i].last_used = ++m_lbs_handle_cache_clock;
+            return &m_lbs_handle_cache[i];
+        }
+    }
+    return NULL;
+}
+
+/**@brief Function for remembering the LBS handles of a peer, replacing the least recently used entry if needed.
+ */
+static void lbs_handle_cache_store(ble_gap_addr_t const * p_addr, lbs_db_t const * p_handles, bool led_write_cmd)
+{
+    lbs_handle_cache_entry_t * p_entry = lbs_handle_cache_find(p_addr);
+
+    if (p_entry == NULL)
+    {
+        p_entry = &m_lbs_handle_cache[0];
+        for (uint32_t i = 0; i < LBS_HANDLE_CACHE_SIZE; i++)
+        {
+            if (!m_lbs_handle_cache[i].in_use)
+            {
+                p_entry = &m_lbs_handle_cache[i];
+                break;
+            }
+            if (m_lbs_handle_cache[i].last_used < p_entry->last_used)
+            {
+                p_entry = &m_lbs_handle_cache[i];
+            }
+        }
+    }
+
+    p_entry->in_use    = true;
+    p_entry->addr      = *p_addr;
+    p_entry->handles   = *p_handles;
+    p_entry->led_write_cmd = led_write_cmd;
+    p_entry->last_used = ++m_lbs_handle_cache_clock;
+}
+
+/**@brief Function for forgetting the LBS handles of a peer, e.g. after its GATT table changed.
+ */
+static void lbs_handle_cache_invalidate(ble_gap_addr_t const * p_addr)
+{
+    lbs_handle_cache_entry_t * p_entry = lbs_handle_cache_find(p_addr);
+
+    if (p_entry != NULL)
+    {
+        p_entry->in_use = false;
+    }
+}
+
+#if THROUGHPUT_TEST_ENABLED
+/**@brief Function for filling the SoftDevice TX queue of a link with streamed writes.
+ *
+ * @details Each write command carries the largest value the ATT MTU allows, starting with a
+ *          little-endian sequence number. The LBS peripheral drops the values, which does not
+ *          matter for the link layer throughput.
+ */
+static void tput_pump(uint16_t conn_handle)
+{
+    static uint8_t   payload[NRF_SDH_BLE_GATT_MAX_MTU_SIZE - 3];
+    ret_code_t       err_code;
+    central_link_t * p_link = link_get(conn_handle);
+
+    if ((p_link == NULL) || !p_link->lbs_ready)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        ble_gattc_write_params_t const write_params =
+        {
+            .write_op = BLE_GATT_OP_WRITE_CMD,
+            .flags    = 0,
+            .handle   = m_ble_lbs_c[conn_handle].peer_lbs_db.led_handle,
+            .offset   = 0,
+            .len      = p_link->att_mtu - 3,
+            .p_value  = payload,
+        };
+
+        memcpy(payload, &p_link->tput_seq, sizeof(p_link->tput_seq));
+        err_code = sd_ble_gattc_write(conn_handle, &write_params);
+        if (err_code == NRF_ERROR_RESOURCES)
+        {
+            p_link->tput_full++;
+            return;
+        }
+        if (err_code != NRF_SUCCESS)
+        {
+            // The link is going down, BLE_GAP_EVT_DISCONNECTED follows.
+            return;
+        }
+        p_link->tput_seq++;
+    }
+}
+
+/**@brief Function for reporting the throughput of every streaming link.
+ *
+ * @details Reports bytes per second and link layer packets per connection event for the current
+ *          combination of ATT MTU, data length and PHY of each link, then starts a new window.
+ */
+static void tput_report(void)
+{
+    uint32_t now = app_timer_cnt_get();
+
+    for (uint16_t i = 0; i < NRF_SDH_BLE_CENTRAL_LINK_COUNT; i++)
+    {
+        central_link_t * p_link     = &m_links[i];
+        uint32_t         elapsed_us = TICKS_TO_US(app_timer_cnt_diff_compute(now, p_link->tput_since));
+        uint32_t         events;
+        uint32_t         packets;
+
+        if (!p_link->lbs_ready || (elapsed_us == 0) || (p_link->conn_interval == 0) || (p_link->data_length == 0))
+        {
+            continue;
+        }
+        events  = elapsed_us / (p_link->conn_interval * UNIT_1_25_MS);
+        // Each write is an L2CAP PDU of the ATT value plus 4 bytes of L2CAP header, fragmented by data length.
+        packets = p_link->tput_writes * CEIL_DIV(p_link->att_mtu + 4, p_link->data_length);
+
+        NRF_LOG_RAW_INFO("tput 0x%x MTU %d, data length %d, PHY %d: %d B/s\n", i,
+                         p_link->att_mtu, p_link->data_length, p_link->phy,
+                         (uint32_t)((uint64_t)p_link->tput_writes * (p_link->att_mtu - 3) * 1000000 / elapsed_us));
+        NRF_LOG_RAW_INFO("tput 0x%x: %d writes, %d.%02d packets per connection event, TX queue full %d times\n", i,
+                         p_link->tput_writes,
+                         (events != 0) ? (packets / events) : 0,
+                         (events != 0) ? ((packets * 100 / events) % 100) : 0,
+                         p_link->tput_full);
+
+        p_link->tput_writes = 0;
+        p_link->tput_full   = 0;
+        p_link->tput_since  = now;
+    }
+}
+#endif // THROUGHPUT_TEST_ENABLED
+
+/**@brief Function for starting to use the LED Button service of a link once its handles are known.
+ *
+ * @param[in] p_lbs_c  LBS client instance of the link, with its handles assigned.
+ */
+static void link_lbs_start(ble_lbs_c_t * p_lbs_c)
+{
+    ret_code_t       err_code;
+    central_link_t * p_link = link_get(p_lbs_c->conn_handle);
+
+    err_code = app_button_enable();
+    APP_ERROR_CHECK(err_code);
+
+    // LED Button service discovered. Enable notification of Button.
+    err_code = ble_lbs_c_button_notif_enable(p_lbs_c);
+    APP_ERROR_CHECK(err_code);
+
+    if (p_link != NULL)
+    {
+        link_state_set(p_link, CONN_STATE_ACTIVE);
+        p_link->lbs_ready = true;
+#if THROUGHPUT_TEST_ENABLED
+        p_link->tput_writes = 0;
+        p_link->tput_full   = 0;
+        p_link->tput_since  = app_timer_cnt_get();
+        tput_pump(p_lbs_c->conn_handle);
+#endif
+        NRF_LOG_RAW_INFO("conn_handle 0x%x ready %d ms after connection\n", p_lbs_c->conn_handle,
+                         TICKS_TO_MS(app_timer_cnt_diff_compute(app_timer_cnt_get(), p_link->connected_at)));
+    }
+    led_timer_update();
+}
+
+/**@brief Function for giving the pending LED value of a link to the SoftDevice.
+ *
+ * @details Uses a write command when the peer allows it, so the value goes out in the next
+ *          connection event without waiting for a write response. When the SoftDevice has no
+ *          free TX buffer the value stays pending and is retried on
+ *          BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE. Otherwise the value is written with a write
+ *          request, one at a time per link: a newer value stays pending until
+ *          BLE_GATTC_EVT_WRITE_RSP of the previous one.
+ */
+static void led_cmd_flush(uint16_t conn_handle)
+{
+    ret_code_t       err_code;
+    central_link_t * p_link = link_get(conn_handle);
+
+    if ((p_link == NULL) || !p_link->led_pending || p_link->led_in_flight)
+    {
+        return;
+    }
+
+    ble_gattc_write_params_t const write_params =
+    {
+        .write_op = (p_link->led_write_cmd && !LATENCY_BENCH_ENABLED) ? BLE_GATT_OP_WRITE_CMD
+                                                                      : BLE_GATT_OP_WRITE_REQ,
+        .flags    = 0,
+        .handle   = m_ble_lbs_c[conn_handle].peer_lbs_db.led_handle,
+        .offset   = 0,
+        .len      = sizeof(p_link->led_value),
+        .p_value  = &p_link->led_value,
+    };
+
+    // The LBS client queue would take a write request while one is outstanding and report
+    // success, so the request goes to the SoftDevice directly and a busy link keeps the value.
+    err_code = sd_ble_gattc_write(conn_handle, &write_params);
+    if ((err_code == NRF_ERROR_RESOURCES) || (err_code == NRF_ERROR_BUSY))
+    {
+        return;
+    }
+
+    p_link->led_pending = false;
+    if (err_code != NRF_SUCCESS)
+    {
+        p_link->led_sent_valid = false;
+        m_led_write_stats.dropped++;
+        return;
+    }
+
+    p_link->led_in_flight  = (write_params.write_op == BLE_GATT_OP_WRITE_REQ);
+    p_link->led_sent       = p_link->led_value;
+    p_link->led_sent_valid = true;
+    m_led_write_stats.sent++;
+    phy_stats_get(p_link->phy)->writes++;
+#if LATENCY_BENCH_ENABLED
+    p_link->bench_in_flight = true;
+    p_link->bench_tick_at   = m_led_tick_at;
+    p_link->bench_sent_at   = app_timer_cnt_get();
+#endif
+    phy_stats_get(p_link->phy)->airtime_us += phy_write_airtime_us(p_link->phy, sizeof(p_link->led_value));
+    if (!p_link->led_written)
+    {
+        p_link->led_written = true;
+        NRF_LOG_RAW_INFO("conn_handle 0x%x first LED write %d ms after connection\n", conn_handle,
+                         TICKS_TO_MS(app_timer_cnt_diff_compute(app_timer_cnt_get(), p_link->connected_at)));
+    }
+}
+
+/**@brief Function for queueing an LED value for a link.
+ *
+ * @details Each link holds at most one pending value: a new request replaces a value that has
+ *          not been sent yet, and a value equal to the last one sent is not written again.
+ */
+static void led_cmd_request(uint16_t conn_handle, uint8_t value)
+{
+    central_link_t * p_link = link_get(conn_handle);
+
+    if ((p_link == NULL) || !p_link->lbs_ready)
+    {
+        return;
+    }
+
+    if (p_link->led_pending)
+    {
+        m_led_write_stats.merged++;
+    }
+    else if (p_link->led_sent_valid && (p_link->led_sent == value))
+    {
+        m_led_write_stats.merged++;
+        return;
+    }
+
+    p_link->led_value   = value;
+    p_link->led_pending = true;
+    led_cmd_flush(conn_handle);
+}
+
+/**@brief Function for retrying a pending LED write from the main loop.
+ *
+ * @details The BLE event handler clears the pending value of a link as well, so the retry is
+ *          done with the BLE interrupt held off.
+ *
+ * @param[in] p_event_data  Connection handle of the link.
+ */
+static void led_cmd_flush_work(void * p_event_data, uint16_t event_size)
+{
+    CRITICAL_REGION_ENTER();
+    led_cmd_flush(*(uint16_t *)p_event_data);
+    CRITICAL_REGION_EXIT();
+}
+
+#if LATENCY_BENCH_ENABLED
+/**@brief Function for accounting the write response of a timed LED write.
+ */
+static void latency_bench_record(uint16_t conn_handle)
+{
+    central_link_t       * p_link = link_get(conn_handle);
+    latency_bench_slot_t * p_slot = NULL;
+    uint32_t               now    = app_timer_cnt_get();
+    uint32_t               queue_us;
+    uint32_t               air_us;
+
+    if ((p_link == NULL) || !p_link->bench_in_flight)
+    {
+        return;
+    }
+    p_link->bench_in_flight = false;
+
+    for (uint32_t i = 0; i < LATENCY_BENCH_SLOT_COUNT; i++)
+    {
+        if ((m_latency_bench[i].conn_interval == p_link->conn_interval) || (m_latency_bench[i].conn_interval == 0))
+        {
+            p_slot                = &m_latency_bench[i];
+            p_slot->conn_interval = p_link->conn_interval;
+            break;
+        }
+    }
+    if (p_slot == NULL)
+    {
+        return;
+    }
+
+    queue_us = TICKS_TO_US(app_timer_cnt_diff_compute(p_link->bench_sent_at, p_link->bench_tick_at));
+    air_us   = TICKS_TO_US(app_timer_cnt_diff_compute(now, p_link->bench_sent_at));
+
+    p_slot->count++;
+    p_slot->queue_us_total += queue_us;
+    p_slot->air_us_total   += air_us;
+    p_slot->max_us          = MAX(p_slot->max_us, queue_us + air_us);
+    p_slot->hist[MIN((queue_us + air_us) / LATENCY_BENCH_BUCKET_US, LATENCY_BENCH_BUCKET_COUNT - 1)]++;
+}
+
+/**@brief Function for finding a percentile in a latency histogram.
+ *
+ * @return Upper bound of the bucket holding the percentile, in microseconds.
+ */
+static uint32_t latency_bench_percentile(latency_bench_slot_t const * p_slot, uint32_t percent)
+{
+    uint32_t needed = (uint32_t)(((uint64_t)p_slot->count * percent + 99) / 100);
+    uint32_t seen   = 0;
+
+    for (uint32_t b = 0; b < LATENCY_BENCH_BUCKET_COUNT - 1; b++)
+    {
+        seen += p_slot->hist[b];
+        if (seen >= needed)
+        {
+            return MIN((b + 1) * LATENCY_BENCH_BUCKET_US, p_slot->max_us);
+        }
+    }
+    return p_slot->max_us;
+}
+
+/**@brief Function for logging the latency histograms.
+ */
+static void latency_bench_report(void)
+{
+    for (uint32_t i = 0; i < LATENCY_BENCH_SLOT_COUNT; i++)
+    {
+        latency_bench_slot_t const * p_slot = &m_latency_bench[i];
+
+        if (p_slot->count == 0)
+        {
+            continue;
+        }
+        NRF_LOG_RAW_INFO("Latency at %d us interval: %d writes, queue mean %d us, air mean %d us\n",
+                         p_slot->conn_interval * UNIT_1_25_MS, p_slot->count,
+                         (uint32_t)(p_slot->queue_us_total / p_slot->count),
+                         (uint32_t)(p_slot->air_us_total / p_slot->count));
+        NRF_LOG_RAW_INFO("Latency at %d us interval: p50 <= %d us, p99 <= %d us, max %d us\n",
+                         p_slot->conn_interval * UNIT_1_25_MS,
+                         latency_bench_percentile(p_slot, 50), latency_bench_percentile(p_slot, 99),
+                         p_slot->max_us);
+    }
+}
+#endif // LATENCY_BENCH_ENABLED
+
+/**@brief Function for recording that a connection event of a link has just ended.
+ *
+ * @details Connection events repeat every conn_interval from this anchor, which is what the
+ *          synchronized blink aligns the LED writes on. The acknowledgement of a synchronized
+ *          write is also accounted for the cross-link jitter here.
+ */
+static void link_event_note(uint16_t conn_handle)
+{
+    central_link_t * p_link = link_get(conn_handle);
+    uint32_t         now    = app_timer_cnt_get();
+
+    if (p_link == NULL)
+    {
+        return;
+    }
+    p_link->event_anchor = now;
+    p_link->anchor_valid = true;
+
+    if (p_link->sync_in_flight)
+    {
+        // BLE events arrive in time order, the first acknowledgement opens the spread.
+        p_link->sync_in_flight = false;
+        if (m_led_sync_stats.round_count == 0)
+        {
+            m_led_sync_stats.round_first = now;
+        }
+        m_led_sync_stats.round_last = now;
+        m_led_sync_stats.round_count++;
+    }
+}
+
+#if LED_SYNC_BLINK
+/**@brief Function for closing the jitter measurement of the previous blink.
+ */
+static void led_sync_round_close(void)
+{
+    if (m_led_sync_stats.round_count > 1)
+    {
+        uint32_t jitter_us = TICKS_TO_US(app_timer_cnt_diff_compute(m_led_sync_stats.round_last,
+                                                                    m_led_sync_stats.round_first));
+
+        m_led_sync_stats.rounds++;
+        m_led_sync_stats.jitter_total_us += jitter_us;
+        m_led_sync_stats.jitter_max_us    = MAX(m_led_sync_stats.jitter_max_us, jitter_us);
+    }
+    m_led_sync_stats.round_count = 0;
+}
+
+/**@brief Function for arming the release timer on the earliest pending synchronized write.
+ */
+static void led_sync_timer_arm(uint32_t now)
+{
+    uint32_t   next_ticks = UINT32_MAX;
+    ret_code_t err_code;
+
+    for (uint32_t i = 0; i < NRF_SDH_BLE_CENTRAL_LINK_COUNT; i++)
+    {
+        if (m_links[i].sync_pending)
+        {
+            uint32_t ticks = app_timer_cnt_diff_compute(m_links[i].sync_release, now);
+            if (ticks > APP_TIMER_MAX_CNT_VAL / 2)
+            {
+                // Already due.
+                ticks = 0;
+            }
+            next_ticks = MIN(next_ticks, ticks);
+        }
+    }
+
+    err_code = app_timer_stop(m_led_sync_timer_id);
+    APP_ERROR_CHECK(err_code);
+    if (next_ticks != UINT32_MAX)
+    {
+        err_code = app_timer_start(m_led_sync_timer_id, MAX(next_ticks, APP_TIMER_MIN_TIMEOUT_TICKS), NULL);
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+/**@brief Function for queueing the synchronized writes whose release time has come.
+ *
+ * @details Runs from the main loop. The BLE event handler marks the acknowledged writes of the
+ *          link state, so the release is done with the BLE interrupt held off.
+ */
+static void led_sync_release_work(void * p_event_data, uint16_t event_size)
+{
+    uint32_t now;
+
+    CRITICAL_REGION_ENTER();
+    now = app_timer_cnt_get();
+    for (uint16_t i = 0; i < NRF_SDH_BLE_CENTRAL_LINK_COUNT; i++)
+    {
+        central_link_t * p_link = &m_links[i];
+
+        if (p_link->sync_pending &&
+            (app_timer_cnt_diff_compute(now, p_link->sync_release) <= APP_TIMER_MAX_CNT_VAL / 2))
+        {
+            p_link->sync_pending = false;
+            led_cmd_request(i, p_link->sync_value);
+            // Only a write taken by the SoftDevice now lands in the aligned connection event.
+            p_link->sync_in_flight = !p_link->led_pending && p_link->led_sent_valid &&
+                                     (p_link->led_sent == p_link->sync_value);
+        }
+    }
+    led_sync_timer_arm(now);
+    CRITICAL_REGION_EXIT();
+}
+
+/**@brief Function for handling the timeout of the release timer.
+ */
+static void led_sync_timer_handler(void * p_context)
+{
+    if (app_sched_event_put(NULL, 0, led_sync_release_work) != NRF_SUCCESS)
+    {
+        m_led_isr_stats.work_dropped++;
+    }
+}
+
+/**@brief Function for sending an LED value to every ready link in the same connection event slot.
+ *
+ * @details The peripherals apply a write in the connection event that carries it, so the
+ *          blink is aligned by picking, for each link, the connection event closest to a common
+ *          anchor and queueing the write half a connection interval before it. The anchor is
+ *          the first connection event of a reference link at least one connection interval
+ *          ahead, so every link still has an event to release before. Links without a known
+ *          connection event timing are written at once.
+ */
+static void led_sync_schedule(uint8_t value)
+{
+    uint32_t now       = app_timer_cnt_get();
+    uint32_t lead_us   = 0;
+    int32_t  ref       = -1;
+    uint32_t target_us = 0;
+
+    led_sync_round_close();
+
+    for (uint32_t i = 0; i < NRF_SDH_BLE_CENTRAL_LINK_COUNT; i++)
+    {
+        if (m_links[i].lbs_ready && m_links[i].anchor_valid)
+        {
+            lead_us = MAX(lead_us, (uint32_t)m_links[i].conn_interval * UNIT_1_25_MS);
+        }
+    }
+    lead_us += LED_SYNC_MARGIN_MS * 1000;
+
+    for (uint16_t i = 0; i < NRF_SDH_BLE_CENTRAL_LINK_COUNT; i++)
+    {
+        central_link_t * p_link = &m_links[i];
+        uint32_t         interval_us;
+        uint32_t         since_anchor_us;
+        uint32_t         event_us;
+
+        if (!p_link->lbs_ready)
+        {
+            continue;
+        }
+        if (!p_link->anchor_valid)
+        {
+            p_link->sync_pending = false;
+            led_cmd_request(i, value);
+            continue;
+        }
+
+        interval_us     = (uint32_t)p_link->conn_interval * UNIT_1_25_MS;
+        since_anchor_us = TICKS_TO_US(app_timer_cnt_diff_compute(now, p_link->event_anchor)) % interval_us;
+        if (ref < 0)
+        {
+            // Next connection event of the reference link at or after the lead time.
+            ref       = i;
+            target_us = lead_us + (interval_us - (since_anchor_us + lead_us) % interval_us) % interval_us;
+            event_us  = target_us;
+        }
+        else
+        {
+            // Connection event of this link closest to the anchor.
+            uint32_t phase_us = (since_anchor_us + target_us) % interval_us;
+            event_us = (phase_us <= interval_us / 2) ? (target_us - phase_us)
+                                                     : (target_us + interval_us - phase_us);
+        }
+
+        p_link->sync_value   = value;
+        p_link->sync_release = (now + US_TO_TICKS(event_us - interval_us / 2)) & APP_TIMER_MAX_CNT_VAL;
+        p_link->sync_pending = true;
+    }
+    led_sync_timer_arm(now);
+}
+#endif // LED_SYNC_BLINK
+
+/**@brief Handles events coming from the LED Button central module.
+ */
+static void lbs_c_evt_handler(ble_lbs_c_t * p_lbs_c, ble_lbs_c_evt_t * p_lbs_c_evt)
+{
+    EVT_PROFILE_BEGIN();
+
+    switch (p_lbs_c_evt->evt_type)
+    {
+        case BLE_LBS_C_EVT_DISCOVERY_COMPLETE:
+        {
+            ret_code_t err_code;
+
+            err_code = ble_lbs_c_handles_assign(p_lbs_c, p_lbs_c_evt->conn_handle, &p_lbs_c_evt->params.peer_db);
+            APP_ERROR_CHECK(err_code);
+            NRF_LOG_RAW_INFO("LED Button service discovered on conn_handle 0x%x.", p_lbs_c_evt->conn_handle);
+
+            central_link_t * p_link = link_get(p_lbs_c_evt->conn_handle);
+            if (p_link != NULL)
+            {
+                lbs_handle_cache_store(&p_link->peer_addr, &p_lbs_c_evt->params.peer_db, p_link->led_write_cmd);
+            }
+            link_lbs_start(p_lbs_c);
+        } break; // BLE_LBS_C_EVT_DISCOVERY_COMPLETE
+
+        case BLE_LBS_C_EVT_BUTTON_NOTIFICATION:
+            NRF_LOG_RAW_INFO("BLE_LBS_C_EVT_BUTTON_NOTIFICATION\n");
+        break;
+
+        default:
+            break;
+    }
+
+    EVT_PROFILE_END(EVT_PROF_SRC_LBS_C, p_lbs_c_evt->evt_type);
+}
+
+/**@brief Function for handling a report from a target peripheral.
+ *
+ * @details Feeds the report RSSI into the peer history and connects once the peer is near.
+ *
+ * @param[in] p_adv_report  Advertising or scan response report of the peer.
+ */
+static void target_adv_report_handle(ble_gap_evt_adv_report_t const * p_adv_report)
+{
+    scan_adapt_sighting();
+
+    rssi_peer_t * p_peer = rssi_peer_get(&p_adv_report->peer_addr);
+    if (p_peer == NULL)
+        return;
+    if (!rssi_peer_sample_add(p_peer, p_adv_report->rssi))
+        return;
+    int8_t mode = rssi_filter_get(&p_peer->filter);
+    NRF_LOG_RAW_INFO("rssi mode = %i\n", mode);
+    if (proximity_update(p_peer, mode) != PROXIMITY_NEAR)
+        return;
+    // One attempt at a time, and never to a peer that is already connected.
+    if ((m_connect.state != CONN_STATE_SCANNING) || (p_peer->conn_handle != BLE_CONN_HANDLE_INVALID))
+        return;
+
+    m_connect.peer_addr = p_adv_report->peer_addr;
+    m_connect.attempts  = 0;
+    connect_start();
+}
+
+/**@brief Function for dispatching BLE events.
+ *
+ * @param[in]   p_ble_evt   Bluetooth stack event.
+ * @param[in]   p_context   Unused.
+ */
+static void ble_evt_dispatch(ble_evt_t const * p_ble_evt, void * p_context)
+{
+    ret_code_t err_code;
+
+    // For readability.
+    ble_gap_evt_t const * p_gap_evt = &p_ble_evt->evt.gap_evt;
+
+    switch (p_ble_evt->header.evt_id)
+    {
+        // Upon connection, check which peripheral has connected (HR or RSC), initiate DB
+        // discovery, update LEDs status and resume scanning if necessary. */
+        case BLE_GAP_EVT_CONNECTED:
+        {
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_CONNECTED\n");
+            NRF_LOG_RAW_INFO("handle = 0x%X\n", p_gap_evt->conn_handle);
+            conn_state_enter(&m_connect.state, &m_connect.state_since, CONN_STATE_SCANNING);
+            central_link_t * p_link = link_get(p_gap_evt->conn_handle);
+            if (p_link == NULL)
+            {
+                err_code = sd_ble_gap_disconnect(p_gap_evt->conn_handle, BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION);
+                APP_ERROR_CHECK(err_code);
+                break;
+            }
+            link_state_set(p_link, CONN_STATE_DISCOVERING);
+            p_link->connected      = true;
+            p_link->lbs_ready      = false;
+            p_link->led_written    = false;
+            p_link->handles_cached = false;
+            p_link->led_write_cmd  = false;
+            p_link->led_pending    = false;
+            p_link->led_in_flight  = false;
+            p_link->led_sent_valid = false;
+            p_link->peer_addr      = p_gap_evt->params.connected.peer_addr;
+            p_link->connected_at   = app_timer_cnt_get();
+            p_link->conn_interval  = p_gap_evt->params.connected.conn_params.max_conn_interval;
+            p_link->event_anchor   = p_link->connected_at;
+            p_link->anchor_valid   = true;
+            p_link->phy            = BLE_GAP_PHY_1MBPS;
+            p_link->phy_preferred  = BLE_GAP_PHY_1MBPS;
+            p_link->phy_wanted     = BLE_GAP_PHY_1MBPS;
+            p_link->att_mtu        = BLE_GATT_ATT_MTU_DEFAULT;
+            p_link->data_length    = BLE_GAP_DATA_LENGTH_DEFAULT;
+            p_link->sync_pending   = false;
+            p_link->sync_in_flight = false;
+
+            lbs_handle_cache_entry_t * p_cached = lbs_handle_cache_find(&p_link->peer_addr);
+            if (p_cached != NULL)
+            {
+                // Handles known from a previous connection, skip the DB discovery.
+                p_link->handles_cached = true;
+                p_link->led_write_cmd  = p_cached->led_write_cmd;
+                err_code = ble_lbs_c_handles_assign(&m_ble_lbs_c[p_gap_evt->conn_handle], p_gap_evt->conn_handle, &p_cached->handles);
+                APP_ERROR_CHECK(err_code);
+                link_lbs_start(&m_ble_lbs_c[p_gap_evt->conn_handle]);
+            }
+            else
+            {
+                err_code = ble_lbs_c_handles_assign(&m_ble_lbs_c[p_gap_evt->conn_handle], p_gap_evt->conn_handle, NULL);
+                APP_ERROR_CHECK(err_code);
+
+                err_code = ble_db_discovery_start(&m_db_disc[p_gap_evt->conn_handle], p_gap_evt->conn_handle);
+                APP_ERROR_CHECK(err_code);
+            }
+            // Shorter packets on 2M leave more radio time to the other links.
+            link_phy_request(p_gap_evt->conn_handle, BLE_GAP_PHY_2MBPS);
+            //start receive rssi during connection
+            err_code = sd_ble_gap_rssi_start(p_gap_evt->conn_handle, 5, 1);
+            APP_ERROR_CHECK(err_code);
+            //keep the history collected while advertising for the connected rssi path
+            rssi_peer_t * p_peer = rssi_peer_get(&p_gap_evt->params.connected.peer_addr);
+            if (p_peer != NULL)
+            {
+                p_peer->conn_handle = p_gap_evt->conn_handle;
+            }
+            //keep looking for more peripherals while there are free links
+            if (link_connected_count() < NRF_SDH_BLE_CENTRAL_LINK_COUNT)
+            {
+                scan_start();
+            }
+        } 
+        break;
+
+        // Upon disconnection, reset the connection handle of the peer which disconnected, update
+        // the LEDs status and start scanning again.
+        case BLE_GAP_EVT_DISCONNECTED:
+        {
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_DISCONNECTED\n");
+            rssi_peer_t * p_peer = rssi_peer_find_by_conn(p_gap_evt->conn_handle);
+            if (p_peer != NULL)
+            {
+                p_peer->conn_handle = BLE_CONN_HANDLE_INVALID;
+            }
+            central_link_t * p_link = link_get(p_gap_evt->conn_handle);
+            if (p_link != NULL)
+            {
+                if (p_gap_evt->params.disconnected.reason == BLE_HCI_CONNECTION_TIMEOUT)
+                {
+                    phy_stats_get(p_link->phy)->drops++;
+                }
+                link_state_set(p_link, CONN_STATE_IDLE);
+                p_link->connected   = false;
+                p_link->lbs_ready   = false;
+                p_link->phy_refused = 0;
+            }
+            led_timer_update();
+            if (m_connect.state == CONN_STATE_SCANNING)
+            {
+                scan_start();
+            }
+        } break;
+
+        case BLE_GAP_EVT_TIMEOUT:
+        {
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_TIMEOUT\n");
+            // We have not specified a timeout for scanning, so only connection attemps can timeout.
+            if (p_gap_evt->params.timeout.src == BLE_GAP_TIMEOUT_SRC_CONN) {
+                connect_timeout_handle();
+            }
+        } 
+        break;
+
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE_REQUEST:
+        {
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_CONN_PARAM_UPDATE_REQUEST\n");
+            conn_param_request_handle(p_gap_evt->conn_handle, &p_gap_evt->params.conn_param_update_request.conn_params);
+        } break;
+
+        case BLE_GAP_EVT_PHY_UPDATE_REQUEST:
+        {
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_PHY_UPDATE_REQUEST\n");
+            // Answer with the PHY the link should be on, which may not be requested yet.
+            central_link_t * p_link = link_get(p_gap_evt->conn_handle);
+            uint8_t          phy    = (p_link != NULL) ? p_link->phy_wanted : BLE_GAP_PHY_AUTO;
+            ble_gap_phys_t const phys = {
+                .rx_phys = phy,
+                .tx_phys = phy,
+            };
+            err_code = sd_ble_gap_phy_update(p_ble_evt->evt.gap_evt.conn_handle, &phys);
+            APP_ERROR_CHECK(err_code);
+            if (p_link != NULL)
+            {
+                p_link->phy_preferred = phy;
+            }
+        } break;
+
+        case BLE_GAP_EVT_PHY_UPDATE:
+        {
+            ble_gap_evt_phy_update_t const * p_update = &p_gap_evt->params.phy_update;
+            central_link_t * p_link = link_get(p_gap_evt->conn_handle);
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_PHY_UPDATE status 0x%x, tx %d, rx %d\n",
+                             p_update->status, p_update->tx_phy, p_update->rx_phy);
+            if (p_link != NULL)
+            {
+                bool requested = (p_link->phy_preferred != p_link->phy);
+
+                if (p_update->status == BLE_HCI_STATUS_CODE_SUCCESS)
+                {
+                    p_link->phy = p_update->tx_phy;
+                    link_sizes_report(p_gap_evt->conn_handle);
+                }
+                if (requested && (p_link->phy != p_link->phy_preferred))
+                {
+                    // The peer refused or chose another PHY, do not ask again on this connection.
+                    p_link->phy_refused |= p_link->phy_preferred;
+                }
+                // Allow a new request for a PHY that was not refused, without retrying this one.
+                p_link->phy_preferred = p_link->phy;
+                p_link->phy_wanted    = p_link->phy;
+            }
+        } break;
+
+        case BLE_GATTC_EVT_WRITE_RSP:
+        {
+            link_event_note(p_ble_evt->evt.gattc_evt.conn_handle);
+
+            central_link_t * p_link = link_get(p_ble_evt->evt.gattc_evt.conn_handle);
+            if ((p_link != NULL) &&
+                (p_ble_evt->evt.gattc_evt.params.write_rsp.handle ==
+                 m_ble_lbs_c[p_ble_evt->evt.gattc_evt.conn_handle].peer_lbs_db.led_handle))
+            {
+                p_link->led_in_flight = false;
+#if LATENCY_BENCH_ENABLED
+                latency_bench_record(p_ble_evt->evt.gattc_evt.conn_handle);
+#endif
+            }
+
+            // A write rejected by the peer means the cached handles may no longer match its
+            // GATT table, so discover it again, once.
+            if ((p_link != NULL) && p_link->handles_cached &&
+                (p_ble_evt->evt.gattc_evt.gatt_status != BLE_GATT_STATUS_SUCCESS))
+            {
+                p_link->handles_cached = false;
+                NRF_LOG_RAW_INFO("BLE_GATTC_EVT_WRITE_RSP error 0x%x, rediscovering\n", p_ble_evt->evt.gattc_evt.gatt_status);
+                lbs_handle_cache_invalidate(&p_link->peer_addr);
+                link_state_set(p_link, CONN_STATE_DISCOVERING);
+                p_link->lbs_ready   = false;
+                p_link->led_pending = false;
+                led_timer_update();
+                err_code = ble_lbs_c_handles_assign(&m_ble_lbs_c[p_ble_evt->evt.gattc_evt.conn_handle],
+                                                    p_ble_evt->evt.gattc_evt.conn_handle, NULL);
+                APP_ERROR_CHECK(err_code);
+                err_code = ble_db_discovery_start(&m_db_disc[p_ble_evt->evt.gattc_evt.conn_handle],
+                                                  p_ble_evt->evt.gattc_evt.conn_handle);
+                APP_ERROR_CHECK(err_code);
+            }
+            else
+            {
+                // The write request is done, send an LED value that was held back meanwhile.
+                uint16_t conn_handle = p_ble_evt->evt.gattc_evt.conn_handle;
+                if (app_sched_event_put(&conn_handle, sizeof(conn_handle), led_cmd_flush_work) != NRF_SUCCESS)
+                {
+                    m_led_isr_stats.work_dropped++;
+                }
+            }
+        } break;
+
+        case BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE:
+        {
+            // TX buffers were freed, retry a pending LED write from the main loop.
+            uint16_t conn_handle = p_ble_evt->evt.gattc_evt.conn_handle;
+            link_event_note(conn_handle);
+#if THROUGHPUT_TEST_ENABLED
+            central_link_t * p_link = link_get(conn_handle);
+            if (p_link != NULL)
+            {
+                p_link->tput_writes += p_ble_evt->evt.gattc_evt.params.write_cmd_tx_complete.count;
+            }
+            // Refill from the event itself, a trip through the main loop would leave the queue idle.
+            tput_pump(conn_handle);
+#else
+            if (app_sched_event_put(&conn_handle, sizeof(conn_handle), led_cmd_flush_work) != NRF_SUCCESS)
+            {
+                // The next LED request flushes the link anyway.
+                m_led_isr_stats.work_dropped++;
+            }
+#endif
+        } break;
+
+        case BLE_GATTC_EVT_TIMEOUT:
+        {
+            // Disconnect on GATT Client timeout event.
+            NRF_LOG_RAW_INFO("BLE_GATTC_EVT_TIMEOUT\n");
+            link_disconnect(p_ble_evt->evt.gattc_evt.conn_handle);
+        } break;
+
+        case BLE_GATTS_EVT_TIMEOUT:
+        {
+            // Disconnect on GATT Server timeout event.
+            NRF_LOG_RAW_INFO("BLE_GATTS_EVT_TIMEOUT\n");
+            link_disconnect(p_ble_evt->evt.gatts_evt.conn_handle);
+        } break;
+
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+        {
+            ble_gap_conn_params_t const * p_params = &p_gap_evt->params.conn_param_update.conn_params;
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_CONN_PARAM_UPDATE\n");
+            NRF_LOG_RAW_INFO("conn_handle 0x%x interval %d us, LED latency up to %d us\n", p_gap_evt->conn_handle,
+                             p_params->max_conn_interval * UNIT_1_25_MS,
+                             p_params->max_conn_interval * UNIT_1_25_MS * (p_params->slave_latency + 1));
+            central_link_t * p_link = link_get(p_gap_evt->conn_handle);
+            if (p_link != NULL)
+            {
+                // The anchor moves with an update, wait for the next connection event to learn it.
+                p_link->conn_interval = p_params->max_conn_interval;
+                p_link->anchor_valid  = false;
+            }
+        } break;
+
+        case BLE_GAP_EVT_SEC_PARAMS_REQUEST:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_SEC_PARAMS_REQUEST\n");
+        break;
+
+        case BLE_GAP_EVT_SEC_INFO_REQUEST:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_SEC_INFO_REQUEST\n");
+        break;
+
+        case BLE_GAP_EVT_PASSKEY_DISPLAY:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_PASSKEY_DISPLAY\n");
+        break;
+
+        case BLE_GAP_EVT_KEY_PRESSED:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_KEY_PRESSED\n");
+        break;
+
+        case BLE_GAP_EVT_AUTH_KEY_REQUEST:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_AUTH_KEY_REQUEST\n");
+        break;
+
+        case BLE_GAP_EVT_LESC_DHKEY_REQUEST:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_LESC_DHKEY_REQUEST\n");
+        break;
+
+        case BLE_GAP_EVT_AUTH_STATUS :
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_AUTH_STATUS\n");
+        break;
+
+        case BLE_GAP_EVT_CONN_SEC_UPDATE:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_CONN_SEC_UPDATE\n");
+        break;
+
+        case BLE_GAP_EVT_RSSI_CHANGED:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_RSSI_CHANGED\n");
+            int8_t connectionRSSI;
+            uint8_t channelrssi_filter_counter;
+            uint32_t err_code = sd_ble_gap_rssi_get(p_ble_evt->evt.gatts_evt.conn_handle, &connectionRSSI, &channelrssi_filter_counter);
+            APP_ERROR_CHECK(err_code);
+            rssi_peer_t * p_peer = rssi_peer_find_by_conn(p_gap_evt->conn_handle);
+            if (p_peer == NULL)
+                return;
+            if (!rssi_peer_sample_add(p_peer, connectionRSSI))
+                return;
+            int mode = rssi_filter_get(&p_peer->filter);
+            NRF_LOG_RAW_INFO("connectionRSSI = %i\n", mode);
+            link_phy_retry(p_gap_evt->conn_handle);
+#if PHY_CODED_FALLBACK
+            // Trade on-air time for range before the link gets close to the disconnection threshold.
+            if (mode <= DISCONNECTION_RSSI_THRESHOLD + PHY_CODED_RSSI_MARGIN) {
+                link_phy_request(p_gap_evt->conn_handle, BLE_GAP_PHY_CODED);
+            } else if (mode >= DISCONNECTION_RSSI_THRESHOLD + PHY_CODED_RSSI_MARGIN + PHY_CODED_RSSI_HYSTERESIS) {
+                link_phy_request(p_gap_evt->conn_handle, BLE_GAP_PHY_2MBPS);
+            }
+#endif
+            if (proximity_update(p_peer, mode) == PROXIMITY_FAR) {
+                NRF_LOG_RAW_INFO("Disconnecting from slave, too far away\n");
+                link_disconnect(p_gap_evt->conn_handle);
+            }
+        break;
+
+        case BLE_GAP_EVT_ADV_REPORT: {
+            //advertising report. Get remote rssi value
+            const ble_gap_evt_adv_report_t *p_adv_report = &p_gap_evt->params.adv_report;
+
+            if (p_adv_report->type.status != BLE_GAP_ADV_DATA_STATUS_INCOMPLETE_MORE_DATA) {
+                if (PERIPH_MATCH_BY_UUID) {
+                    //check uuid on scan response
+                    if ((p_adv_report->type.scan_response == 1) && ad_uuid_match(&p_adv_report->data)) {
+                        target_adv_report_handle(p_adv_report);
+                    }
+                } else if (p_adv_report->type.scan_response == 0) {
+                    if (ad_name_match(&p_adv_report->data)) {
+                        //device name founded
+                        target_adv_report_handle(p_adv_report);
+                    }
+                }
+            }
+            //NRF_LOG_RAW_INFO("BLE_GAP_EVT_ADV_REPORT\n");
+        }
+        break;
+
+        case BLE_GAP_EVT_SEC_REQUEST:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_SEC_REQUEST\n");
+        break;
+        
+        case BLE_GAP_EVT_SCAN_REQ_REPORT:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_SCAN_REQ_REPORT\n");
+        break;
+
+        case BLE_GAP_EVT_DATA_LENGTH_UPDATE_REQUEST:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_DATA_LENGTH_UPDATE_REQUEST\n");
+        break;
+
+        case BLE_GAP_EVT_DATA_LENGTH_UPDATE:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_DATA_LENGTH_UPDATE\n");
+        break;
+
+        case BLE_GAP_EVT_QOS_CHANNEL_SURVEY_REPORT:
+            NRF_LOG_RAW_INFO("BLE_GAP_EVT_QOS_CHANNEL_SURVEY_REPORT\n");
+        break;
+
+        default:
+            break;
+    }
+}
+
+/**@brief Function for accounting the time spent in one interrupt handler.
+ *
+ * @param[in]   p_stats     Statistics of the handler.
+ * @param[in]   start       DWT cycle counter value at the handler entry.
+ */
+static void isr_stats_add(isr_stats_t * p_stats, uint32_t start)
+{
+    uint32_t cycles = DWT->CYCCNT - start;
+    p_stats->count++;
+    p_stats->cycles_total += cycles;
+    if (cycles > p_stats->cycles_max)
+    {
+        p_stats->cycles_max = cycles;
+    }
+}
+
+#if BLE_EVT_CAPTURE_ENABLED
+/**@brief Function for copying a BLE event to the capture channel.
+ *
+ * @details Each record is written at once, or dropped when the channel has no room for it:
+ *          - uint16_t  length of the rest of the record,
+ *          - uint32_t  app_timer counter value when the event was received,
+ *          - ble_evt_t the event, header.evt_len bytes,
+ *          - for BLE_GAP_EVT_ADV_REPORT, the advertising data the event points to.
+ *          All fields are little-endian. The data pointer inside a captured advertising report
+ *          is meaningless, a replay has to point it at the bytes that follow the event.
+ */
+static void ble_evt_capture(ble_evt_t const * p_ble_evt)
+{
+    uint32_t now      = app_timer_cnt_get();
+    uint16_t evt_len  = MIN(p_ble_evt->header.evt_len, BLE_EVT_CAPTURE_EVT_SIZE_MAX);
+    uint16_t data_len = 0;
+    uint16_t rec_len;
+
+    if (p_ble_evt->header.evt_id == BLE_GAP_EVT_ADV_REPORT)
+    {
+        data_len = MIN(p_ble_evt->evt.gap_evt.params.adv_report.data.len, BLE_GAP_ADV_SET_DATA_SIZE_MAX);
+    }
+    rec_len = sizeof(now) + evt_len + data_len;
+
+    memcpy(&m_ble_evt_capture_record[0], &rec_len, sizeof(rec_len));
+    memcpy(&m_ble_evt_capture_record[sizeof(rec_len)], &now, sizeof(now));
+    memcpy(&m_ble_evt_capture_record[sizeof(rec_len) + sizeof(now)], p_ble_evt, evt_len);
+    if (data_len != 0)
+    {
+        memcpy(&m_ble_evt_capture_record[sizeof(rec_len) + sizeof(now) + evt_len],
+               p_ble_evt->evt.gap_evt.params.adv_report.data.p_data, data_len);
+    }
+
+    if (SEGGER_RTT_Write(BLE_EVT_CAPTURE_RTT_CHANNEL, m_ble_evt_capture_record, sizeof(rec_len) + rec_len) == 0)
+    {
+        m_ble_evt_capture_dropped++;
+    }
+}
+
+/**@brief Function for setting up the RTT channel of the capture.
+ */
+static void ble_evt_capture_init(void)
+{
+    int err = SEGGER_RTT_ConfigUpBuffer(BLE_EVT_CAPTURE_RTT_CHANNEL, "ble_evt",
+                                        m_ble_evt_capture_buf, sizeof(m_ble_evt_capture_buf),
+                                        SEGGER_RTT_MODE_NO_BLOCK_SKIP);
+    APP_ERROR_CHECK((err < 0) ? NRF_ERROR_NO_MEM : NRF_SUCCESS);
+}
+#endif // BLE_EVT_CAPTURE_ENABLED
+
+/**@brief Function for handling BLE events.
+ *
+ * @details Runs in the SoftDevice event interrupt, the time spent there is reported with the
+ *          LED ISR statistics.
+ *
+ * @param[in]   p_ble_evt   Bluetooth stack event.
+ * @param[in]   p_context   Unused.
+ */
+static void ble_evt_handler(ble_evt_t const * p_ble_evt, void * p_context)
+{
+    uint32_t start = DWT->CYCCNT;
+    EVT_PROFILE_BEGIN();
+
+#if BLE_EVT_CAPTURE_ENABLED
+    ble_evt_capture(p_ble_evt);
+#endif
+    ble_evt_dispatch(p_ble_evt, p_context);
+    isr_stats_add(&m_ble_evt_stats, start);
+
+    EVT_PROFILE_END(EVT_PROF_SRC_BLE, p_ble_evt->header.evt_id);
+}
+
+/**@brief LED Button client initialization.
+ */
+static void lbs_c_init(void)
+{
+    ble_lbs_c_init_t lbs_c_init_obj;
+
+    lbs_c_init_obj.evt_handler = lbs_c_evt_handler;
+
+    for (uint32_t i = 0; i < NRF_SDH_BLE_CENTRAL_LINK_COUNT; i++)
+    {
+        ret_code_t err_code = ble_lbs_c_init(&m_ble_lbs_c[i], &lbs_c_init_obj);
+        APP_ERROR_CHECK(err_code);
+    }
+}
+
+/**@brief Function for initializing the BLE stack.
+ *
+ * @details Initializes the SoftDevice and the BLE event interrupts.
+ */
+static void ble_stack_init(void)
+{
+    ret_code_t err_code;
+
+    err_code = nrf_sdh_enable_request();
+    APP_ERROR_CHECK(err_code);
+
+    // Configure the BLE stack using the default settings.
+    // Fetch the start address of the application RAM.
+    uint32_t ram_start = 0;
+    err_code = nrf_sdh_ble_default_cfg_set(APP_BLE_CONN_CFG_TAG, &ram_start);
+    APP_ERROR_CHECK(err_code);
+
+#if THROUGHPUT_TEST_ENABLED
+    // Let the streamed writes queue up for several packets per connection event.
+    ble_cfg_t ble_cfg;
+    memset(&ble_cfg, 0, sizeof(ble_cfg));
+    ble_cfg.conn_cfg.conn_cfg_tag                                  = APP_BLE_CONN_CFG_TAG;
+    ble_cfg.conn_cfg.params.gattc_conn_cfg.write_cmd_tx_queue_size = THROUGHPUT_TX_QUEUE_SIZE;
+    err_code = sd_ble_cfg_set(BLE_CONN_CFG_GATTC, &ble_cfg, ram_start);
+    APP_ERROR_CHECK(err_code);
+#endif
+
+    // Enable BLE stack.
+    err_code = nrf_sdh_ble_enable(&ram_start);
+    APP_ERROR_CHECK(err_code);
+
+#if THROUGHPUT_TEST_ENABLED
+    // NRF_SDH_BLE_GAP_EVENT_LENGTH is sized for one short event of every link, let a streaming
+    // link extend its events into radio time the other links leave unused.
+    ble_opt_t ble_opt;
+    memset(&ble_opt, 0, sizeof(ble_opt));
+    ble_opt.common_opt.conn_evt_ext.enable = 1;
+    err_code = sd_ble_opt_set(BLE_COMMON_OPT_CONN_EVT_EXT, &ble_opt);
+    APP_ERROR_CHECK(err_code);
+#endif
+
+    // Register a handler for BLE events.
+    NRF_SDH_BLE_OBSERVER(m_ble_observer, APP_BLE_OBSERVER_PRIO, ble_evt_handler, NULL);
+}
+
+/**@brief Function for handling events from the button handler module.
+ *
+ * @param[in] pin_no        The pin that the event applies to.
+ * @param[in] button_action The button action (press/release).
+ */
+static void button_event_handler(uint8_t pin_no, uint8_t button_action)
+{
+    ret_code_t err_code;
+
+    switch (pin_no)
+    {
+        case LEDBUTTON_BUTTON_PIN:
+            NRF_LOG_RAW_INFO("LEDBUTTON_BUTTON_PIN\n");
+            /*
+            err_code = ble_lbs_led_status_send(&m_ble_lbs_c, button_action);
+            if (err_code != NRF_SUCCESS &&
+                err_code != BLE_ERROR_INVALID_CONN_HANDLE &&
+                err_code != NRF_ERROR_INVALID_STATE)
+            {
+                APP_ERROR_CHECK(err_code);
+            }
+            if (err_code == NRF_SUCCESS)
+            {
+                //NRF_LOG_RAW_INFO("LBS write LED state %d", button_action);
+            }
+            */
+            break;
+
+        default:
+            APP_ERROR_HANDLER(pin_no);
+            break;
+    }
+}
+
+/**@brief Function for handling Scaning events.
+ *
+ * @param[in]   p_scan_evt   Scanning event.
+ */
+static void scan_evt_handler(scan_evt_t const * p_scan_evt)
+{
+    ret_code_t err_code;
+    EVT_PROFILE_BEGIN();
+
+    switch(p_scan_evt->scan_evt_id)
+    {
+        case NRF_BLE_SCAN_EVT_CONNECTING_ERROR:
+            NRF_LOG_RAW_INFO("NRF_BLES_SCAN_EVT_CONNECTING_ERROR\n");
+            err_code = p_scan_evt->params.connecting_err.err_code;
+            APP_ERROR_CHECK(err_code);
+            break;
+        case NRF_BLE_SCAN_EVT_FILTER_MATCH:
+            //NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_FILTER_MATCH\n");
+        break;
+
+        case NRF_BLE_SCAN_EVT_WHITELIST_REQUEST:
+            NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_WHITELIST_REQUEST\n");
+        break;
+
+        case NRF_BLE_SCAN_EVT_WHITELIST_ADV_REPORT:
+            NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_WHITELIST_ADV_REPORT\n");
+        break;
+
+        case NRF_BLE_SCAN_EVT_NOT_FOUND:
+            //NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_NOT_FOUND\n");
+        break;
+
+        case NRF_BLE_SCAN_EVT_SCAN_TIMEOUT:
+            NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_SCAN_TIMEOUT\n");
+        break;
+
+        case NRF_BLE_SCAN_EVT_SCAN_REQ_REPORT:
+            NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_SCAN_REQ_REPORT\n");
+        break;
+
+        case NRF_BLE_SCAN_EVT_CONNECTED:
+            NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_CONNECTED\n");
+        break;
+
+        default:
+            NRF_LOG_RAW_INFO("NRF_BLE_SCAN_EVT_DEFAULT\n");
+        break;
+    }
+
+    EVT_PROFILE_END(EVT_PROF_SRC_SCAN, p_scan_evt->scan_evt_id);
+}
+
+/**@brief Function for initializing the button handler module.
+ */
+static void buttons_init(void)
+{
+    ret_code_t err_code;
+
+    //The array must be static because a pointer to it will be saved in the button handler module.
+    static app_button_cfg_t buttons[] = {
+        {LEDBUTTON_BUTTON_PIN, false, BUTTON_PULL, button_event_handler}
+    };
+
+    err_code = app_button_init(buttons, ARRAY_SIZE(buttons), BUTTON_DETECTION_DELAY);
+    APP_ERROR_CHECK(err_code);
+}
+
+/**@brief Function for handling database discovery events.
+ *
+ * @details This function is callback function to handle events from the database discovery module.
+ *          Depending on the UUIDs that are discovered, this function should forward the events
+ *          to their respective services.
+ *
+ * @param[in] p_event  Pointer to the database discovery event.
+ */
+static void db_disc_handler(ble_db_discovery_evt_t * p_evt)
+{
+    central_link_t * p_link = link_get(p_evt->conn_handle);
+
+    // Check whether the LED characteristic takes write commands before the LBS client
+    // reports the discovery, so the result is cached together with the handles.
+    if ((p_link != NULL) &&
+        (p_evt->evt_type == BLE_DB_DISCOVERY_COMPLETE) &&
+        (p_evt->params.discovered_db.srv_uuid.uuid == LBS_UUID_SERVICE))
+    {
+        for (uint32_t i = 0; i < p_evt->params.discovered_db.char_count; i++)
+        {
+            ble_gattc_char_t const * p_char = &p_evt->params.discovered_db.charateristics[i].characteristic;
+
+            if (p_char->uuid.uuid == LBS_UUID_LED_CHAR)
+            {
+                p_link->led_write_cmd = p_char->char_props.write_wo_resp;
+            }
+        }
+    }
+
+    ble_lbs_on_db_disc_evt(&m_ble_lbs_c[p_evt->conn_handle], p_evt);
+}
+
+/**@brief Database discovery initialization.
+ */
+static void db_discovery_init(void)
+{
+    ret_code_t err_code = ble_db_discovery_init(db_disc_handler);
+    APP_ERROR_CHECK(err_code);
+}
+
+/**@brief Function for initializing the log.
+ */
+static void log_init(void)
+{
+    ret_code_t err_code = NRF_LOG_INIT(NULL);
+    APP_ERROR_CHECK(err_code);
+
+    NRF_LOG_DEFAULT_BACKENDS_INIT();
+}
+
+/**@brief Function for initializing the timer.
+ */
+static void timer_init(void)
+{
+    ret_code_t err_code = app_timer_init();
+    APP_ERROR_CHECK(err_code);
+}
+
+
+/**@brief Function for initializing the event scheduler.
+ */
+static void scheduler_init(void)
+{
+    APP_SCHED_INIT(SCHED_MAX_EVENT_DATA_SIZE, SCHED_QUEUE_SIZE);
+}
+
+/**@brief Function for starting the DWT cycle counter used to time interrupt handlers.
+ */
+static void cycle_counter_init(void)
+{
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT       = 0;
+    DWT->CTRL        |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/**@brief Function for initializing the Power manager. */
+static void power_management_init(void)
+{
+    ret_code_t err_code;
+    err_code = nrf_pwr_mgmt_init();
+    APP_ERROR_CHECK(err_code);
+}
+
+static void scan_init(void)
+{
+    ret_code_t          err_code;
+    nrf_ble_scan_init_t init_scan;
+
+    memset(&init_scan, 0, sizeof(init_scan));
+
+    init_scan.connect_if_match = false;
+    init_scan.conn_cfg_tag     = APP_BLE_CONN_CFG_TAG;
+
+    err_code = nrf_ble_scan_init(&m_scan, &init_scan, scan_evt_handler);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = app_timer_create(&m_connect_retry_timer_id, APP_TIMER_MODE_SINGLE_SHOT, connect_retry_timer_handler);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = app_timer_create(&m_scan_adapt_timer_id, APP_TIMER_MODE_REPEATED, scan_adapt_timer_handler);
+    APP_ERROR_CHECK(err_code);
+    err_code = app_timer_start(m_scan_adapt_timer_id, APP_TIMER_TICKS(SCAN_ADAPT_CHECK_MS), NULL);
+    APP_ERROR_CHECK(err_code);
+
+    // Setting filters for scanning.
+    err_code = nrf_ble_scan_filters_enable(&m_scan, NRF_BLE_SCAN_NAME_FILTER, false);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = nrf_ble_scan_filter_set(&m_scan, SCAN_NAME_FILTER, m_target_periph_name);
+    APP_ERROR_CHECK(err_code);
+}
+
+
+/**@brief Function for handling events from the GATT module.
+ */
+static void gatt_evt_handler(nrf_ble_gatt_t * p_gatt, nrf_ble_gatt_evt_t const * p_evt)
+{
+    central_link_t * p_link = link_get(p_evt->conn_handle);
+
+    if (p_link == NULL)
+    {
+        return;
+    }
+
+    switch (p_evt->evt_id)
+    {
+        case NRF_BLE_GATT_EVT_ATT_MTU_UPDATED:
+            p_link->att_mtu = p_evt->params.att_mtu_effective;
+            break;
+
+        case NRF_BLE_GATT_EVT_DATA_LENGTH_UPDATED:
+            p_link->data_length = p_evt->params.data_length;
+            break;
+
+        default:
+            break;
+    }
+    link_sizes_report(p_evt->conn_handle);
+    // The procedure that kept the PHY request busy may have been this one.
+    link_phy_retry(p_evt->conn_handle);
+}
+
+/**@brief Function for initializing the GATT module.
+ */
+static void gatt_init(void)
+{
+    ret_code_t err_code = nrf_ble_gatt_init(&m_gatt, gatt_evt_handler);
+    APP_ERROR_CHECK(err_code);
+
+    // The GATT module negotiates both sizes on every new connection.
+    err_code = nrf_ble_gatt_att_mtu_central_set(&m_gatt, NRF_SDH_BLE_GATT_MAX_MTU_SIZE);
+    APP_ERROR_CHECK(err_code);
+
+    err_code = nrf_ble_gatt_data_length_set(&m_gatt, BLE_CONN_HANDLE_INVALID, NRF_SDH_BLE_GAP_DATA_LENGTH);
+    APP_ERROR_CHECK(err_code);
+}
+
+/**@brief Function for sending the current LED state to every ready link.
+ *
+ * @details Scheduled from the blink timer handler and executed from the main loop, so the GATT
+ *          writes do not run in the timer interrupt. The BLE event handler changes the link
+ *          state the writes depend on, so they are issued with the BLE interrupt held off.
+ */
+static void led_blink_work(void * p_event_data, uint16_t event_size)
+{
+    ledStatus = ~ledStatus;
+    // In the throughput build the links carry the streamed writes, only the local LED blinks.
+    if (!THROUGHPUT_TEST_ENABLED)
+    {
+#if LED_SYNC_BLINK
+        // The connection event anchors and the jitter measurement are updated by the BLE event
+        // handler.
+        CRITICAL_REGION_ENTER();
+        led_sync_schedule(ledStatus);
+        CRITICAL_REGION_EXIT();
+#else
+        CRITICAL_REGION_ENTER();
+        for (uint16_t i = 0; i < NRF_SDH_BLE_CENTRAL_LINK_COUNT; i++)
+        {
+            led_cmd_request(i, ledStatus);
+        }
+        CRITICAL_REGION_EXIT();
+#endif
+    }
+
+    if (m_led_isr_stats.count >= ISR_STATS_LOG_INTERVAL)
+    {
+        isr_stats_t       stats;
+        isr_stats_t       ble_stats;
+        led_write_stats_t write_stats;
+#if LED_SYNC_BLINK
+        led_sync_stats_t  sync_stats;
+#endif
+
+        CRITICAL_REGION_ENTER();
+        stats       = m_led_isr_stats;
+        ble_stats   = m_ble_evt_stats;
+        write_stats = m_led_write_stats;
+        memset(&m_led_isr_stats, 0, sizeof(m_led_isr_stats));
+        memset(&m_ble_evt_stats, 0, sizeof(m_ble_evt_stats));
+#if LED_SYNC_BLINK
+        sync_stats = m_led_sync_stats;
+        if (m_led_sync_stats.rounds != 0)
+        {
+            m_led_sync_stats.rounds          = 0;
+            m_led_sync_stats.jitter_total_us = 0;
+            m_led_sync_stats.jitter_max_us   = 0;
+        }
+#endif
+        CRITICAL_REGION_EXIT();
+
+        NRF_LOG_RAW_INFO("LED ISR: mean %d cycles, max %d cycles, %d dropped\n",
+                         stats.cycles_total / stats.count, stats.cycles_max, stats.work_dropped);
+        if (ble_stats.count != 0)
+        {
+            NRF_LOG_RAW_INFO("BLE observer: %d events, mean %d cycles, max %d cycles\n",
+                             ble_stats.count, ble_stats.cycles_total / ble_stats.count, ble_stats.cycles_max);
+        }
+#if BLE_EVT_CAPTURE_ENABLED
+        NRF_LOG_RAW_INFO("BLE capture: %d records dropped\n", m_ble_evt_capture_dropped);
+#endif
+        NRF_LOG_RAW_INFO("Conn params: %d accepted, %d clamped, %d rejected\n",
+                         m_conn_param_stats.accepted, m_conn_param_stats.clamped, m_conn_param_stats.rejected);
+        NRF_LOG_RAW_INFO("PHY 1M/2M/Coded: writes %d/%d/%d, drops %d/%d/%d\n",
+                         m_phy_stats[PHY_STATS_1M].writes, m_phy_stats[PHY_STATS_2M].writes, m_phy_stats[PHY_STATS_CODED].writes,
+                         m_phy_stats[PHY_STATS_1M].drops, m_phy_stats[PHY_STATS_2M].drops, m_phy_stats[PHY_STATS_CODED].drops);
+        NRF_LOG_RAW_INFO("PHY 1M/2M/Coded: write airtime %d/%d/%d us\n",
+                         m_phy_stats[PHY_STATS_1M].airtime_us, m_phy_stats[PHY_STATS_2M].airtime_us,
+                         m_phy_stats[PHY_STATS_CODED].airtime_us);
+#if LATENCY_BENCH_ENABLED
+        latency_bench_report();
+#endif
+#if THROUGHPUT_TEST_ENABLED
+        tput_report();
+#endif
+        NRF_LOG_RAW_INFO("State ms: scanning %d, connecting %d, backoff %d, discovering %d, active %d, disconnecting %d\n",
+                         TICKS_TO_MS(m_conn_state_ticks[CONN_STATE_SCANNING]),
+                         TICKS_TO_MS(m_conn_state_ticks[CONN_STATE_CONNECTING]),
+                         TICKS_TO_MS(m_conn_state_ticks[CONN_STATE_BACKOFF]),
+                         TICKS_TO_MS(m_conn_state_ticks[CONN_STATE_DISCOVERING]),
+                         TICKS_TO_MS(m_conn_state_ticks[CONN_STATE_ACTIVE]),
+                         TICKS_TO_MS(m_conn_state_ticks[CONN_STATE_DISCONNECTING]));
+        NRF_LOG_RAW_INFO("LED writes: %d sent, %d merged, %d dropped\n",
+                         write_stats.sent, write_stats.merged, write_stats.dropped);
+#if LED_SYNC_BLINK
+        if (sync_stats.rounds != 0)
+        {
+            NRF_LOG_RAW_INFO("LED sync: jitter mean %d us, max %d us over %d blinks\n",
+                             sync_stats.jitter_total_us / sync_stats.rounds,
+                             sync_stats.jitter_max_us, sync_stats.rounds);
+        }
+#endif
+    }
+}
+
+/**@brief Function for queuing the LED writes of one blink period.
+ */
+static void led_blink_schedule(void)
+{
+#if LATENCY_BENCH_ENABLED
+    m_led_tick_at = app_timer_cnt_get();
+#endif
+    if (app_sched_event_put(NULL, 0, led_blink_work) != NRF_SUCCESS)
+    {
+        m_led_isr_stats.work_dropped++;
+    }
+}
+
+#if LED_BLINK_USE_APP_TIMER
+/**@brief Function for handling the blink timer timeout.
+ *
+ * @details RTC1 has no PPI path of its own here, the toggle task is triggered from software.
+ */
+static void led_app_timer_handler(void * p_context)
+{
+    uint32_t start = DWT->CYCCNT;
+
+    nrf_drv_gpiote_out_task_trigger(BLINK_LED_PIN);
+    led_blink_schedule();
+
+    isr_stats_add(&m_led_isr_stats, start);
+}
+#else
+void timer_led_event_handler(nrf_timer_event_t event_type, void* p_context)
+{
+    uint32_t start = DWT->CYCCNT;
+
+    switch (event_type) {
+        case NRF_TIMER_EVENT_COMPARE0:
+            // The local LED is toggled by PPI, only the BLE writes need the CPU.
+            led_blink_schedule();
+        break;
+
+        default:
+            //Do nothing.
+            break;
+    }
+
+    isr_stats_add(&m_led_isr_stats, start);
+}
+#endif
+
+void config_led_timer (void) {
+    // Turn on the LED to signal scanning.
+    //bsp_board_led_on(CENTRAL_SCANNING_LED);
+    uint32_t err_code = NRF_SUCCESS;
+
+    //Configure all leds on board.
+    bsp_board_init(BSP_INIT_LEDS);
+
+    //The local LED is toggled through a GPIOTE task in both timer modes.
+    if (!nrf_drv_gpiote_is_init())
+    {
+        err_code = nrf_drv_gpiote_init();
+        APP_ERROR_CHECK(err_code);
+    }
+    nrf_drv_gpiote_out_config_t led_config = GPIOTE_CONFIG_OUT_TASK_TOGGLE(true);
+    err_code = nrf_drv_gpiote_out_init(BLINK_LED_PIN, &led_config);
+    APP_ERROR_CHECK(err_code);
+
+#if LED_BLINK_USE_APP_TIMER
+    //The blink period is long enough for the RTC, TIMER1 would keep the HFCLK running.
+    err_code = app_timer_create(&m_led_timer_id, APP_TIMER_MODE_REPEATED, led_app_timer_handler);
+    APP_ERROR_CHECK(err_code);
+#else
+    //Configure TIMER_LED for generating simple light effect - leds on board will invert his state one after the other.
+    nrf_drv_timer_config_t timer_cfg = NRF_DRV_TIMER_DEFAULT_CONFIG;
+    err_code = nrf_drv_timer_init(&TIMER_LED, &timer_cfg, timer_led_event_handler);
+
+    APP_ERROR_CHECK(err_code);
+    uint32_t time_ticks = nrf_drv_timer_ms_to_ticks(&TIMER_LED, BLINK_TIME_INTERVAL_MS);
+    nrf_drv_timer_extended_compare(&TIMER_LED, NRF_TIMER_CC_CHANNEL0, time_ticks, NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK, true);
+
+    //Toggle the local LED from the TIMER_LED compare event through PPI and GPIOTE, without waking the CPU.
+    err_code = nrf_drv_ppi_init();
+    APP_ERROR_CHECK(err_code);
+    err_code = nrf_drv_ppi_channel_alloc(&m_led_ppi_channel);
+    APP_ERROR_CHECK(err_code);
+    err_code = nrf_drv_ppi_channel_assign(m_led_ppi_channel,
+                                          nrf_drv_timer_event_address_get(&TIMER_LED, NRF_TIMER_EVENT_COMPARE0),
+                                          nrf_drv_gpiote_out_task_addr_get(BLINK_LED_PIN));
+    APP_ERROR_CHECK(err_code);
+    err_code = nrf_drv_ppi_channel_enable(m_led_ppi_channel);
+    APP_ERROR_CHECK(err_code);
+#endif
+
+#if LED_SYNC_BLINK
+    err_code = app_timer_create(&m_led_sync_timer_id, APP_TIMER_MODE_SINGLE_SHOT, led_sync_timer_handler);
+    APP_ERROR_CHECK(err_code);
+#endif
+}
+
+int main(void)
+{
+    // Initialize.
+    log_init();
+    timer_init();
+    scheduler_init();
+    cycle_counter_init();
+#if EVT_PROFILER_ENABLED
+    evt_profiler_init();
+#endif
+#if BLE_EVT_CAPTURE_ENABLED
+    ble_evt_capture_init();
+#endif
+    leds_init();
+    buttons_init();
+    power_management_init();
+    ble_stack_init();
+    scan_init();
+    gatt_init();
+    db_discovery_init();
+    lbs_c_init();
+    config_led_timer();
+    
+    // Start execution.
+    NRF_LOG_RAW_INFO("Blinky CENTRAL example started.\n");
+    NRF_LOG_RAW_INFO("%d links, %d x 1.25 ms radio time per connection interval\n",
+                     NRF_SDH_BLE_CENTRAL_LINK_COUNT, LINKS_AIRTIME);
+    scan_start();
+
+    bsp_board_led_off(BSP_BOARD_LED_0);
+
+    while (1) {
+        app_sched_execute();
+        // Format and send the deferred logs before sleeping.
+        if (NRF_LOG_PROCESS() == false)
+        {
+            nrf_pwr_mgmt_run();
+        }
+    }
+}
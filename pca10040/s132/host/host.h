@@ -0,0 +1,94 @@
+/**
+ * @file
+ * @brief Host build of the Blinky central: interfaces between the simulation modules.
+ *
+ * @details main.c and the SDK modules it uses are compiled unchanged against the SDK headers.
+ *          The simulation is a discrete event loop on a microsecond clock:
+ *          - host_sim.c     clock, action queue, interrupt delivery, register blocks and pins,
+ *          - host_sd.c      SoftDevice model: scanner, initiator, links and the peripherals,
+ *          - host_capture.c conversion of BLE_EVT_CAPTURE_ENABLED records to and from the target,
+ *          - host_feed.c    command line, scripted event feed, replay, fuzzing and the report,
+ *          - port/          the SDK modules that need the hardware, on the simulation.
+ */
+#ifndef HOST_H__
+#define HOST_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "ble.h"
+
+#define HOST_PEER_MAX                   16          /**< Peripherals a feed can declare. */
+#define HOST_US_PER_MS                  1000ULL
+
+/**@brief Step of the simulation, run at its time from host_wfe(). */
+typedef void (* host_action_t)(void * p_context, uint32_t arg);
+
+/**@brief Behavior of one simulated peripheral, set from the feed. */
+typedef struct
+{
+    char     name[32];                              /**< Complete local name in the advertising data. */
+    int8_t   rssi;                                  /**< Mean RSSI at the central in dBm. */
+    uint8_t  noise;                                 /**< Uniform noise added to every RSSI sample, +/- dB. */
+    uint8_t  loss;                                  /**< Packets lost, in percent. */
+    uint16_t adv_interval_ms;                       /**< Advertising interval, advDelay is added on top. */
+    uint16_t mtu;                                   /**< ATT_MTU the peripheral accepts. */
+    uint8_t  dl;                                    /**< Data length the peripheral accepts, in octets. */
+    uint8_t  phys;                                  /**< PHYs the peripheral supports, BLE_GAP_PHY_* mask. */
+    bool     wwr;                                   /**< The LED characteristic accepts write commands. */
+    bool     echo;                                  /**< Every LED write is notified back on the button characteristic. */
+    bool     lbs;                                   /**< The peripheral runs the LED Button service and lists it in its scan response. */
+} host_peer_cfg_t;
+
+// host_sim.c
+extern bool     host_quiet;                         /**< Drop the application log. */
+extern uint64_t host_end_us;                        /**< The run stops when the simulated time reaches it. */
+
+void     host_sim_init(void);
+uint64_t host_now_us(void);
+uint64_t host_ns(void);
+void     host_schedule(uint64_t at_us, host_action_t action, void * p_context, uint32_t arg);
+void     host_seed(uint32_t seed);
+uint32_t host_rand(void);
+int32_t  host_rand_range(int32_t min, int32_t max);
+void     host_pin_set(uint32_t pin, bool level);
+bool     host_pin_get(uint32_t pin);
+void     host_button_press(uint32_t button, uint32_t hold_ms);
+void     host_sim_report(void);
+void     host_finish(void);
+
+// host_sd.c
+void     host_sd_evt_put(ble_evt_t const * p_ble_evt, uint8_t const * p_data, uint16_t data_len);
+void     host_sd_passive_set(bool passive);
+void     host_sd_exact_adv_data_set(bool exact);
+void     host_sd_rssi_set(uint16_t conn_handle, int8_t rssi);
+void     host_sd_report(void);
+
+bool     host_peer_declare(uint32_t id, host_peer_cfg_t const * p_cfg);
+bool     host_peer_cfg_get(uint32_t id, host_peer_cfg_t * p_cfg);
+bool     host_peer_advertise(uint32_t id, bool on);
+bool     host_peer_rssi_set(uint32_t id, int8_t rssi);
+bool     host_peer_silent_set(uint32_t id, bool silent);
+bool     host_peer_disconnect(uint32_t id, uint8_t reason);
+bool     host_peer_conn_param_request(uint32_t id, ble_gap_conn_params_t const * p_params);
+bool     host_peer_phy_request(uint32_t id, uint8_t phys);
+bool     host_peer_notify(uint32_t id, uint8_t value);
+bool     host_peer_handles_move(uint32_t id, uint16_t offset);
+
+// port/
+void     host_log_report(void);
+void     host_sched_report(void);
+void     host_timer_report(void);
+void     host_gpiote_pin_changed(uint32_t pin, bool level);
+bool     host_gpiote_task(uint32_t address);
+void     host_gpiote_report(void);
+void     host_ppi_event(uint32_t eep);
+void     host_ppi_report(void);
+bool     host_capture_open(char const * p_path);
+void     host_rtt_report(void);
+
+// host_capture.c
+uint16_t host_capture_to_target(uint8_t const * p_record, uint16_t len, uint8_t * p_out, uint16_t out_size);
+bool     host_capture_replay_load(char const * p_path);
+
+#endif // HOST_H__
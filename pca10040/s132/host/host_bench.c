@@ -0,0 +1,383 @@
+/**
+ * @file
+ * @brief Host build: benchmark of the RSSI filter back-ends on an RSSI trace.
+ *
+ * @details main.c is compiled into this file, so the benchmark calls its static filter functions
+ *          directly, with the RSSI_FILTER_TYPE and MAX_RSSI_BUFF_SIZE of the build. The trace is
+ *          a text file with one RSSI sample per line in dBm. '#' starts a comment, and a "near"
+ *          or "far" line gives the true state of the peer from the next sample on; the trace
+ *          starts far.
+ *
+ *          - rssi_filter_push() and rssi_filter_get() are timed on their own, over as many
+ *            passes over the trace as it takes to run for about BENCH_RUN_NS, and reported in
+ *            nanoseconds per call.
+ *          - The samples go through rssi_peer_sample_add() and proximity_update(), so the
+ *            proximity decision is taken as in ble_evt_handler(), on every sample once the window
+ *            is full, with the dwell time on the simulated clock. The samples of a trace are
+ *            INTERVAL_MS apart, 100 ms unless given on the command line. For every change of
+ *            the true state, the benchmark reports how many samples it takes until the decision
+ *            follows. A change the decision misses before the next one is counted apart, and so
+ *            is a decision that flips away from the true state.
+ *          - For RSSI_FILTER_MODE, calcMode() of the original main.c is timed and run on a buffer
+ *            of the last MAX_RSSI_BUFF_SIZE samples every MAX_RSSI_BUFF_SIZE samples, as the
+ *            original main.c did, and its modes are compared with the filter.
+ */
+#include "../../../main.c"
+
+// The application main() is app_main(), this file provides the program entry.
+#undef main
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "host.h"
+
+#define BENCH_TRACE_MAX                 100000                  /**< Samples a trace can hold. */
+#define BENCH_TRUTH_MAX                 1000                    /**< Changes of the true state a trace can hold. */
+#define BENCH_RUN_NS                    100000000ULL            /**< Time each measurement runs for. */
+#define BENCH_INTERVAL_MS               100                     /**< Default time between two samples of a trace. */
+
+/**@brief Change of the true state of the peer in a trace. */
+typedef struct
+{
+    uint32_t at;                                                /**< Index of the first sample in the new state. */
+    bool     near;                                              /**< New state. */
+} bench_truth_t;
+
+static char const * const m_filter_names[] =
+{
+    [RSSI_FILTER_MODE]   = "mode",
+    [RSSI_FILTER_MEDIAN] = "median",
+    [RSSI_FILTER_EWMA]   = "ewma",
+    [RSSI_FILTER_KALMAN] = "kalman",
+};
+
+static int8_t           m_trace[BENCH_TRACE_MAX];               /**< Samples of the trace. */
+static uint32_t         m_trace_len;
+static bench_truth_t    m_truth[BENCH_TRUTH_MAX];               /**< Changes of the true state, in trace order. */
+static uint32_t         m_truth_count;
+static uint32_t         m_interval_ms = BENCH_INTERVAL_MS;      /**< Time between two samples of the trace. */
+static volatile int32_t m_sink;                                 /**< Keeps the results the compiler could drop. */
+
+
+static void trace_load(char const * p_path)
+{
+    FILE * p_file = fopen(p_path, "r");
+    char   line[64];
+
+    if (p_file == NULL)
+    {
+        fprintf(stderr, "bench: cannot open %s\n", p_path);
+        exit(2);
+    }
+    while (fgets(line, sizeof(line), p_file) != NULL)
+    {
+        char * p_end;
+        long   rssi = strtol(line, &p_end, 10);
+
+        if (p_end == line)
+        {
+            bool near = (strncmp(line, "near", 4) == 0);
+
+            if ((near || (strncmp(line, "far", 3) == 0)) && (m_truth_count < BENCH_TRUTH_MAX))
+            {
+                m_truth[m_truth_count].at   = m_trace_len;
+                m_truth[m_truth_count].near = near;
+                m_truth_count++;
+            }
+            continue;                                           // Comment, marker or blank line.
+        }
+        if ((rssi < INT8_MIN) || (rssi > INT8_MAX) || (m_trace_len == BENCH_TRACE_MAX))
+        {
+            fprintf(stderr, "bench: %s: sample %u out of range or too many samples\n",
+                    p_path, m_trace_len + 1);
+            exit(2);
+        }
+        m_trace[m_trace_len++] = (int8_t)rssi;
+    }
+    fclose(p_file);
+    if (m_trace_len < MAX_RSSI_BUFF_SIZE)
+    {
+        fprintf(stderr, "bench: %s has fewer samples than the window of %u\n", p_path, MAX_RSSI_BUFF_SIZE);
+        exit(2);
+    }
+}
+
+
+/**@brief Step of the simulation that only moves the clock to the next sample. */
+static void bench_tick(void * p_context, uint32_t arg)
+{
+    UNUSED_PARAMETER(p_context);
+    UNUSED_PARAMETER(arg);
+}
+
+
+/**@brief Function for timing rssi_filter_push() over whole passes of the trace.
+ *
+ * @return Nanoseconds per push.
+ */
+static double time_push(void)
+{
+    static rssi_filter_t filter;
+    uint64_t             calls = 0;
+    uint64_t             start = host_ns();
+    uint64_t             elapsed;
+
+    rssi_filter_init(&filter);
+    do
+    {
+        for (uint32_t i = 0; i < m_trace_len; i++)
+        {
+            rssi_filter_push(&filter, m_trace[i]);
+        }
+        calls  += m_trace_len;
+        elapsed = host_ns() - start;
+    } while (elapsed < BENCH_RUN_NS);
+
+    m_sink += rssi_filter_get(&filter);
+    return (double)elapsed / calls;
+}
+
+
+/**@brief Function for timing rssi_filter_get() on the window at every sample of the trace.
+ *
+ * @return Nanoseconds per get.
+ */
+static double time_get(void)
+{
+    static rssi_filter_t filter;
+    uint64_t             calls   = 0;
+    uint64_t             elapsed = 0;
+
+    rssi_filter_init(&filter);
+    do
+    {
+        for (uint32_t i = 0; i < m_trace_len; i++)
+        {
+            uint64_t start;
+
+            rssi_filter_push(&filter, m_trace[i]);
+            start = host_ns();
+            for (uint32_t n = 0; n < 64; n++)
+            {
+                // The filter may have changed as far as the compiler knows.
+                __asm__ volatile("" : : "r"(&filter) : "memory");
+                m_sink += rssi_filter_get(&filter);
+            }
+            elapsed += host_ns() - start;
+        }
+        calls += 64 * m_trace_len;
+    } while (elapsed < BENCH_RUN_NS);
+
+    return (double)elapsed / calls;
+}
+
+
+/**@brief Function for playing the trace through a peer context and scoring its decisions. */
+static void decisions_report(void)
+{
+    static rssi_peer_t peer;
+    bool               near        = false;
+    bool               truth       = false;
+    uint32_t           next        = 0;                         // Next change of the true state.
+    uint32_t           since       = 0;                         // First sample of the change being followed.
+    bool               following   = false;
+    uint32_t           followed    = 0;
+    uint32_t           missed      = 0;
+    uint32_t           false_flips = 0;
+    uint64_t           lag_sum     = 0;
+    uint32_t           lag_max     = 0;
+
+    rssi_filter_init(&peer.filter);
+    for (uint32_t i = 0; i < m_trace_len; i++)
+    {
+        while ((next < m_truth_count) && (m_truth[next].at == i))
+        {
+            if (m_truth[next].near != truth)
+            {
+                missed   += following ? 1 : 0;
+                truth     = m_truth[next].near;
+                following = (near != truth);
+                followed += following ? 0 : 1;                  // Already there after a false flip.
+                since     = i;
+            }
+            next++;
+        }
+        host_schedule(host_now_us() + m_interval_ms * HOST_US_PER_MS, bench_tick, NULL, 0);
+        host_wfe();
+        if (!rssi_peer_sample_add(&peer, m_trace[i]))
+        {
+            continue;
+        }
+        if ((proximity_update(&peer, rssi_filter_get(&peer.filter)) == PROXIMITY_NEAR) == near)
+        {
+            continue;
+        }
+        near = !near;
+        if (near != truth)
+        {
+            false_flips++;                                      // Flipping back is not a change followed.
+        }
+        else if (following)
+        {
+            uint32_t lag = i + 1 - since;
+
+            followed++;
+            lag_sum  += lag;
+            lag_max   = MAX(lag_max, lag);
+            following = false;
+        }
+    }
+    missed += following ? 1 : 0;
+
+    printf("bench:   decision follows %u changes after %.1f samples on average, %u at most, "
+           "%u missed, %u false flips\n",
+           followed, followed ? (double)lag_sum / followed : 0.0, lag_max, missed, false_flips);
+}
+
+
+#if (RSSI_FILTER_TYPE == RSSI_FILTER_MODE)
+/**@brief calcMode() of the original main.c, the reference of the benchmark.
+ *
+ * @details The indices and counts are int instead of int8_t, which wraps past 127 samples and
+ *          never ends for a window of 1000.
+ */
+static int8_t calc_mode_ref(int8_t const * rssi, int len)
+{
+    int8_t maxValue = 0;
+    int    maxCount = 0;
+
+    for (int i = 0; i < len; ++i)
+    {
+        int count = 0;
+
+        for (int j = 0; j < len; ++j)
+        {
+            if (rssi[j] == rssi[i])
+            {
+                ++count;
+            }
+        }
+        if (count > maxCount)
+        {
+            maxCount = count;
+            maxValue = rssi[i];
+        }
+    }
+    return maxValue;
+}
+
+
+/**@brief Function for counting the samples of a window with a given value. */
+static uint32_t window_count(int8_t const * p_window, int8_t rssi)
+{
+    uint32_t count = 0;
+
+    for (uint32_t i = 0; i < MAX_RSSI_BUFF_SIZE; i++)
+    {
+        count += (p_window[i] == rssi) ? 1 : 0;
+    }
+    return count;
+}
+
+
+/**@brief Function for timing calc_mode_ref() on windows of the trace.
+ *
+ * @return Nanoseconds per call.
+ */
+static double time_calc_mode(void)
+{
+    uint64_t calls = 0;
+    uint64_t start = host_ns();
+    uint64_t elapsed;
+
+    do
+    {
+        for (uint32_t i = 0; i + MAX_RSSI_BUFF_SIZE <= m_trace_len; i += MAX_RSSI_BUFF_SIZE)
+        {
+            __asm__ volatile("" : : "r"(&m_trace[i]) : "memory");
+            m_sink += calc_mode_ref(&m_trace[i], MAX_RSSI_BUFF_SIZE);
+            calls++;
+        }
+        elapsed = host_ns() - start;
+    } while (elapsed < BENCH_RUN_NS);
+
+    return (double)elapsed / calls;
+}
+
+
+/**@brief Function for comparing the mode filter with calcMode() at every decision. */
+static void calc_mode_report(void)
+{
+    static rssi_filter_t filter;
+    static int8_t        window[MAX_RSSI_BUFF_SIZE];        // Last samples in arrival order, as calcMode() saw them.
+    uint32_t             decisions = 0;
+    uint32_t             equal     = 0;
+    uint32_t             ties      = 0;
+    uint32_t             counter   = 0;
+    double               calc_ns   = time_calc_mode();
+
+    rssi_filter_init(&filter);
+    for (uint32_t i = 0; i < m_trace_len; i++)
+    {
+        rssi_filter_push(&filter, m_trace[i]);
+        window[counter] = m_trace[i];
+        if (++counter < MAX_RSSI_BUFF_SIZE)
+        {
+            continue;
+        }
+        counter = 0;
+
+        int8_t mode = rssi_filter_get(&filter);
+        int8_t ref  = calc_mode_ref(window, MAX_RSSI_BUFF_SIZE);
+
+        decisions++;
+        if (mode == ref)
+        {
+            equal++;
+        }
+        else if (window_count(window, mode) == window_count(window, ref))
+        {
+            ties++;
+        }
+    }
+
+    printf("bench:   calcMode %10.1f ns per call, %8.1f ns per sample with a decision every %u\n",
+           calc_ns, calc_ns / MAX_RSSI_BUFF_SIZE, MAX_RSSI_BUFF_SIZE);
+    printf("bench:   %u decisions, %u with the same mode as calcMode, %u on a tie broken the other way, "
+           "%u different\n", decisions, equal, ties, decisions - equal - ties);
+}
+#endif // RSSI_FILTER_TYPE == RSSI_FILTER_MODE
+
+
+int main(int argc, char * argv[])
+{
+    double push_ns;
+    double get_ns;
+
+    if ((argc < 2) || (argc > 3))
+    {
+        fprintf(stderr, "usage: %s TRACE [INTERVAL_MS]\n", argv[0]);
+        return 2;
+    }
+    if (argc == 3)
+    {
+        m_interval_ms = (uint32_t)strtoul(argv[2], NULL, 0);
+    }
+    trace_load(argv[1]);
+    host_sim_init();
+    host_quiet = true;                                          // proximity_update() logs every change.
+
+    push_ns = time_push();
+    get_ns  = time_get();
+
+    printf("bench: %s filter, MAX_RSSI_BUFF_SIZE %u, %s, %u samples %u ms apart\n",
+           m_filter_names[RSSI_FILTER_TYPE], MAX_RSSI_BUFF_SIZE, argv[1], m_trace_len, m_interval_ms);
+    printf("bench:   push %6.1f ns, get %6.1f ns, %6.1f ns per sample with a decision\n",
+           push_ns, get_ns, push_ns + get_ns);
+    decisions_report();
+#if (RSSI_FILTER_TYPE == RSSI_FILTER_MODE)
+    calc_mode_report();
+#endif
+    return 0;
+}
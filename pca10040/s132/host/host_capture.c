@@ -0,0 +1,385 @@
+/**
+ * @file
+ * @brief Host build: BLE_EVT_CAPTURE_ENABLED records, in the layout of the target.
+ *
+ * @details A capture file holds the records main.c writes to the RTT capture channel:
+ *          uint16_t length, uint32_t app_timer counter, ble_evt_t, advertising data.
+ *          The ble_evt_t of the target is the Cortex-M4 layout: 4-byte pointers, the event
+ *          union at offset 4 and the GAP parameters at offset 8. The host build converts its
+ *          events to that layout when it writes a capture, and back when it replays one, so a
+ *          file captured on the target replays on the host and the other way around.
+ *          Only the events the application handles are converted, others are skipped.
+ */
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_timer.h"
+#include "app_util.h"
+#include "ble.h"
+#include "nrf_sdh_ble.h"
+#include "host.h"
+
+#define TARGET_EVT_OFFSET               4                       /**< ble_evt_t.evt on the target. */
+#define TARGET_GAP_PARAMS_OFFSET        8                       /**< ble_evt_t.evt.gap_evt.params on the target. */
+#define TARGET_ADV_REPORT_DATA          24                      /**< ble_gap_evt_adv_report_t.data on the target. */
+#define TARGET_ADV_REPORT_AUX           32                      /**< ble_gap_evt_adv_report_t.aux_pointer on the target. */
+#define TARGET_ADV_REPORT_SIZE          36
+#define TARGET_CONNECTED_ADV_DATA       20                      /**< ble_gap_evt_connected_t.adv_data on the target. */
+#define TARGET_CONNECTED_SIZE           36
+#define TARGET_TIMEOUT_BUFFER           4                       /**< ble_gap_evt_timeout_t.params.adv_report_buffer on the target. */
+#define TARGET_TIMEOUT_SIZE             12
+#define TARGET_DATA_SIZE                8                       /**< ble_data_t on the target. */
+#define TARGET_EVT_SIZE_MAX             (NRF_SDH_BLE_EVT_BUF_SIZE)
+
+#define HOST_GAP_PARAMS_OFFSET          offsetof(ble_evt_t, evt.gap_evt.params)
+#define HOST_GATTC_SHIFT                (offsetof(ble_evt_t, evt) - TARGET_EVT_OFFSET)
+
+#define CAPTURE_RTC_FREQUENCY           (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))
+#define CAPTURE_CNT_MASK                0x00FFFFFF              /**< The RTC counter is 24 bits wide. */
+
+/**@brief Event of a replayed capture. */
+typedef struct
+{
+    uint64_t at_us;
+    uint16_t data_len;
+    uint8_t  data[BLE_GAP_SCAN_BUFFER_MAX];
+    uint64_t evt[CEIL_DIV(NRF_SDH_BLE_EVT_BUF_SIZE, sizeof(uint64_t))];
+} replay_evt_t;
+
+static replay_evt_t * m_replay;
+static uint32_t       m_replay_count;
+static uint32_t       m_replay_skipped;
+
+
+/**@brief Function for checking an event has the same parameters on the host and on the target,
+ *        apart from the offset of the event union.
+ */
+static bool evt_is_plain(uint16_t evt_id)
+{
+    switch (evt_id)
+    {
+        case BLE_GAP_EVT_DISCONNECTED:
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:
+        case BLE_GAP_EVT_RSSI_CHANGED:
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE_REQUEST:
+        case BLE_GAP_EVT_PHY_UPDATE_REQUEST:
+        case BLE_GAP_EVT_PHY_UPDATE:
+        case BLE_GAP_EVT_DATA_LENGTH_UPDATE_REQUEST:
+        case BLE_GAP_EVT_DATA_LENGTH_UPDATE:
+            return true;
+
+        default:
+            // The GATT client events hold no pointers.
+            return (evt_id >= BLE_GATTC_EVT_BASE) && (evt_id <= BLE_GATTC_EVT_LAST);
+    }
+}
+
+
+static void put16(uint8_t * p_dst, uint16_t value)
+{
+    memcpy(p_dst, &value, sizeof(value));
+}
+
+
+static uint16_t get16(uint8_t const * p_src)
+{
+    uint16_t value;
+
+    memcpy(&value, p_src, sizeof(value));
+    return value;
+}
+
+
+static void data_to_target(uint8_t * p_dst, ble_data_t const * p_data)
+{
+    memset(p_dst, 0, TARGET_DATA_SIZE);
+    put16(&p_dst[4], p_data->len);
+}
+
+
+/**@brief Function for converting a host event to the target layout.
+ *
+ * @return Length of the target event, or 0 if the event is not converted.
+ */
+static uint16_t evt_to_target(ble_evt_t const * p_evt, uint16_t evt_len, uint8_t * p_out)
+{
+    uint8_t const * p_in      = (uint8_t const *)p_evt;
+    uint8_t *       p_params  = &p_out[TARGET_GAP_PARAMS_OFFSET];
+    uint16_t        out_len;
+
+    memset(p_out, 0, TARGET_EVT_SIZE_MAX);
+    put16(&p_out[0], p_evt->header.evt_id);
+    switch (p_evt->header.evt_id)
+    {
+        case BLE_GAP_EVT_ADV_REPORT:
+        {
+            ble_gap_evt_adv_report_t const * p_report = &p_evt->evt.gap_evt.params.adv_report;
+
+            memcpy(p_params, p_report, offsetof(ble_gap_evt_adv_report_t, data));
+            data_to_target(&p_params[TARGET_ADV_REPORT_DATA], &p_report->data);
+            memcpy(&p_params[TARGET_ADV_REPORT_AUX], &p_report->aux_pointer, sizeof(p_report->aux_pointer));
+            out_len = TARGET_GAP_PARAMS_OFFSET + TARGET_ADV_REPORT_SIZE;
+        } break;
+
+        case BLE_GAP_EVT_CONNECTED:
+        {
+            ble_gap_evt_connected_t const * p_connected = &p_evt->evt.gap_evt.params.connected;
+
+            memcpy(p_params, p_connected, offsetof(ble_gap_evt_connected_t, adv_data));
+            data_to_target(&p_params[TARGET_CONNECTED_ADV_DATA], &p_connected->adv_data.adv_data);
+            data_to_target(&p_params[TARGET_CONNECTED_ADV_DATA + TARGET_DATA_SIZE], &p_connected->adv_data.scan_rsp_data);
+            out_len = TARGET_GAP_PARAMS_OFFSET + TARGET_CONNECTED_SIZE;
+        } break;
+
+        case BLE_GAP_EVT_TIMEOUT:
+            p_params[0] = p_evt->evt.gap_evt.params.timeout.src;
+            data_to_target(&p_params[TARGET_TIMEOUT_BUFFER], &p_evt->evt.gap_evt.params.timeout.params.adv_report_buffer);
+            out_len = TARGET_GAP_PARAMS_OFFSET + TARGET_TIMEOUT_SIZE;
+            break;
+
+        default:
+            if (!evt_is_plain(p_evt->header.evt_id))
+            {
+                return 0;
+            }
+            if ((p_evt->header.evt_id >= BLE_GAP_EVT_BASE) && (p_evt->header.evt_id <= BLE_GAP_EVT_LAST))
+            {
+                memcpy(p_params, &p_in[HOST_GAP_PARAMS_OFFSET], evt_len - HOST_GAP_PARAMS_OFFSET);
+                out_len = (uint16_t)(evt_len - HOST_GAP_PARAMS_OFFSET + TARGET_GAP_PARAMS_OFFSET);
+            }
+            else
+            {
+                memcpy(&p_out[TARGET_EVT_OFFSET], &p_in[offsetof(ble_evt_t, evt)], evt_len - offsetof(ble_evt_t, evt));
+                out_len = (uint16_t)(evt_len - HOST_GATTC_SHIFT);
+            }
+            break;
+    }
+
+    // The connection handle is the first member of every event.
+    put16(&p_out[TARGET_EVT_OFFSET], p_evt->evt.common_evt.conn_handle);
+    put16(&p_out[2], out_len);
+    return out_len;
+}
+
+
+/**@brief Function for converting a target event to the host layout.
+ *
+ * @return Length of the host event, or 0 if the event is not converted.
+ */
+static uint16_t evt_from_target(uint8_t const * p_in, uint16_t in_len, ble_evt_t * p_evt)
+{
+    uint8_t *       p_out    = (uint8_t *)p_evt;
+    uint8_t const * p_params = &p_in[TARGET_GAP_PARAMS_OFFSET];
+    uint16_t        evt_id   = get16(&p_in[0]);
+    uint16_t        out_len;
+
+    memset(p_evt, 0, NRF_SDH_BLE_EVT_BUF_SIZE);
+    p_evt->header.evt_id = evt_id;
+    switch (evt_id)
+    {
+        case BLE_GAP_EVT_ADV_REPORT:
+        {
+            ble_gap_evt_adv_report_t * p_report = &p_evt->evt.gap_evt.params.adv_report;
+
+            if (in_len < TARGET_GAP_PARAMS_OFFSET + TARGET_ADV_REPORT_SIZE)
+            {
+                return 0;
+            }
+            memcpy(p_report, p_params, offsetof(ble_gap_evt_adv_report_t, data));
+            p_report->data.len = get16(&p_params[TARGET_ADV_REPORT_DATA + 4]);
+            memcpy(&p_report->aux_pointer, &p_params[TARGET_ADV_REPORT_AUX], sizeof(p_report->aux_pointer));
+            out_len = (uint16_t)(HOST_GAP_PARAMS_OFFSET + sizeof(*p_report));
+        } break;
+
+        case BLE_GAP_EVT_CONNECTED:
+        {
+            ble_gap_evt_connected_t * p_connected = &p_evt->evt.gap_evt.params.connected;
+
+            if (in_len < TARGET_GAP_PARAMS_OFFSET + TARGET_CONNECTED_SIZE)
+            {
+                return 0;
+            }
+            memcpy(p_connected, p_params, offsetof(ble_gap_evt_connected_t, adv_data));
+            out_len = (uint16_t)(HOST_GAP_PARAMS_OFFSET + sizeof(*p_connected));
+        } break;
+
+        case BLE_GAP_EVT_TIMEOUT:
+            if (in_len < TARGET_GAP_PARAMS_OFFSET + TARGET_TIMEOUT_SIZE)
+            {
+                return 0;
+            }
+            p_evt->evt.gap_evt.params.timeout.src                         = p_params[0];
+            p_evt->evt.gap_evt.params.timeout.params.adv_report_buffer.len = get16(&p_params[TARGET_TIMEOUT_BUFFER + 4]);
+            out_len = (uint16_t)(HOST_GAP_PARAMS_OFFSET + sizeof(ble_gap_evt_timeout_t));
+            break;
+
+        default:
+            if (!evt_is_plain(evt_id))
+            {
+                return 0;
+            }
+            if ((evt_id >= BLE_GAP_EVT_BASE) && (evt_id <= BLE_GAP_EVT_LAST))
+            {
+                if ((in_len < TARGET_GAP_PARAMS_OFFSET) ||
+                    (in_len - TARGET_GAP_PARAMS_OFFSET + HOST_GAP_PARAMS_OFFSET > NRF_SDH_BLE_EVT_BUF_SIZE))
+                {
+                    return 0;
+                }
+                memcpy(&p_out[HOST_GAP_PARAMS_OFFSET], p_params, in_len - TARGET_GAP_PARAMS_OFFSET);
+                out_len = (uint16_t)(in_len - TARGET_GAP_PARAMS_OFFSET + HOST_GAP_PARAMS_OFFSET);
+            }
+            else
+            {
+                if ((in_len < TARGET_EVT_OFFSET) || (in_len + HOST_GATTC_SHIFT > NRF_SDH_BLE_EVT_BUF_SIZE))
+                {
+                    return 0;
+                }
+                memcpy(&p_out[offsetof(ble_evt_t, evt)], &p_in[TARGET_EVT_OFFSET], in_len - TARGET_EVT_OFFSET);
+                out_len = (uint16_t)(in_len + HOST_GATTC_SHIFT);
+            }
+            break;
+    }
+
+    p_evt->evt.common_evt.conn_handle = get16(&p_in[TARGET_EVT_OFFSET]);
+    p_evt->header.evt_len             = out_len;
+    return out_len;
+}
+
+
+/**@brief Function for converting a capture record of the host build to the target layout.
+ *
+ * @param[in]  p_record  Record as main.c writes it.
+ * @param[in]  len       Length of the record, with its length field.
+ * @param[out] p_out     Converted record.
+ * @param[in]  out_size  Size of p_out.
+ *
+ * @return Length of the converted record, or 0 if the record is skipped.
+ */
+uint16_t host_capture_to_target(uint8_t const * p_record, uint16_t len, uint8_t * p_out, uint16_t out_size)
+{
+    size_t const     head = sizeof(uint16_t) + sizeof(uint32_t);
+    uint64_t         evt[CEIL_DIV(NRF_SDH_BLE_EVT_BUF_SIZE, sizeof(uint64_t))];
+    ble_evt_t *      p_evt = (ble_evt_t *)evt;
+    uint16_t         evt_len;
+    uint16_t         data_len = 0;
+    uint16_t         out_len;
+
+    if (len < head + sizeof(ble_evt_hdr_t))
+    {
+        return 0;
+    }
+    memcpy(evt, &p_record[head], sizeof(ble_evt_hdr_t));
+    evt_len = MIN(p_evt->header.evt_len, NRF_SDH_BLE_EVT_BUF_SIZE);
+    if (len < head + evt_len)
+    {
+        return 0;
+    }
+    memcpy(evt, &p_record[head], evt_len);
+    if (p_evt->header.evt_id == BLE_GAP_EVT_ADV_REPORT)
+    {
+        data_len = (uint16_t)(len - head - evt_len);
+    }
+    if (out_size < head + TARGET_EVT_SIZE_MAX + data_len)
+    {
+        return 0;
+    }
+
+    out_len = evt_to_target(p_evt, evt_len, &p_out[head]);
+    if (out_len == 0)
+    {
+        return 0;
+    }
+    memcpy(&p_out[head + out_len], &p_record[head + evt_len], data_len);
+    put16(&p_out[0], (uint16_t)(sizeof(uint32_t) + out_len + data_len));
+    memcpy(&p_out[sizeof(uint16_t)], &p_record[sizeof(uint16_t)], sizeof(uint32_t));
+    return (uint16_t)(head + out_len + data_len);
+}
+
+
+static void replay_put(void * p_context, uint32_t arg)
+{
+    replay_evt_t const * p_replay = p_context;
+    ble_evt_t const *    p_evt    = (ble_evt_t const *)p_replay->evt;
+
+    if (p_evt->header.evt_id == BLE_GAP_EVT_RSSI_CHANGED)
+    {
+        // The application reads the sample back with sd_ble_gap_rssi_get().
+        host_sd_rssi_set(p_evt->evt.gap_evt.conn_handle, p_evt->evt.gap_evt.params.rssi_changed.rssi);
+    }
+    host_sd_evt_put(p_evt, p_replay->data, p_replay->data_len);
+}
+
+
+/**@brief Function for loading a capture file and scheduling its events.
+ *
+ * @details The events keep the spacing of their app_timer counter values, the first one is
+ *          replayed right after the application started. Without --end, the run ends one second
+ *          after the last event.
+ */
+bool host_capture_replay_load(char const * p_path)
+{
+    FILE *   p_file = fopen(p_path, "rb");
+    uint8_t  record[UINT16_MAX];
+    uint16_t rec_len;
+    uint32_t cnt;
+    uint32_t cnt_prev = 0;
+    uint64_t ticks    = 0;
+    uint32_t capacity = 0;
+
+    if (p_file == NULL)
+    {
+        return false;
+    }
+    while (fread(&rec_len, sizeof(rec_len), 1, p_file) == 1)
+    {
+        replay_evt_t * p_replay;
+        uint16_t       evt_len;
+
+        if ((rec_len < sizeof(cnt) + sizeof(ble_evt_hdr_t)) || (fread(record, 1, rec_len, p_file) != rec_len))
+        {
+            break;
+        }
+        if (m_replay_count == capacity)
+        {
+            capacity = MAX(2 * capacity, 256);
+            m_replay = realloc(m_replay, capacity * sizeof(*m_replay));
+            if (m_replay == NULL)
+            {
+                fclose(p_file);
+                return false;
+            }
+        }
+
+        memcpy(&cnt, record, sizeof(cnt));
+        ticks   += (m_replay_count == 0) ? 0 : ((cnt - cnt_prev) & CAPTURE_CNT_MASK);
+        cnt_prev = cnt;
+
+        p_replay = &m_replay[m_replay_count];
+        evt_len  = MIN(get16(&record[sizeof(cnt) + 2]), rec_len - sizeof(cnt));
+        if (evt_from_target(&record[sizeof(cnt)], evt_len, (ble_evt_t *)p_replay->evt) == 0)
+        {
+            m_replay_skipped++;
+            continue;
+        }
+        p_replay->at_us    = ticks * 1000000ULL / CAPTURE_RTC_FREQUENCY;
+        p_replay->data_len = (uint16_t)MIN(rec_len - sizeof(cnt) - evt_len, sizeof(p_replay->data));
+        memcpy(p_replay->data, &record[sizeof(cnt) + evt_len], p_replay->data_len);
+        m_replay_count++;
+    }
+    fclose(p_file);
+
+    // Schedule once the array stops moving.
+    for (uint32_t i = 0; i < m_replay_count; i++)
+    {
+        m_replay[i].at_us += host_now_us() + HOST_US_PER_MS;
+        host_schedule(m_replay[i].at_us, replay_put, &m_replay[i], 0);
+    }
+    if ((m_replay_count != 0) && (host_end_us == UINT64_MAX))
+    {
+        host_end_us = m_replay[m_replay_count - 1].at_us + 1000 * HOST_US_PER_MS;
+    }
+    printf("host: replaying %u events from %s, %u skipped\n", m_replay_count, p_path, m_replay_skipped);
+    return true;
+}
@@ -0,0 +1,696 @@
+/**
+ * @file
+ * @brief Host build: command line and scripted event feed.
+ *
+ * @details A feed is a text file, one command per line, in time order:
+ *
+ *              <ms> <command> [arguments]
+ *
+ *          peer <id> [name=<s>] [rssi=<dBm>] [noise=<dB>] [loss=<%>] [adv=<ms>]
+ *                    [mtu=<n>] [dl=<n>] [phys=1m|2m|1m2m] [wwr=0|1] [echo=0|1] [lbs=0|1]
+ *                                          declare a peripheral, or change one
+ *          advertise <id> on|off           start or stop its advertising
+ *          rssi <id> <dBm>                 move it nearer or farther
+ *          noise <id> <dB>                 RSSI noise, +/- dB
+ *          loss <id> <%>                   packet loss
+ *          silent <id> on|off              stop answering, links time out
+ *          disconnect <id> [reason]        the peripheral ends its link, HCI reason in hex
+ *          conn_param <id> <min ms> <max ms> <latency> <timeout ms>
+ *                                          the peripheral asks for connection parameters
+ *          phy <id> 1m|2m|1m2m             the peripheral asks for a PHY
+ *          notify <id> <value>             the peripheral notifies its button state
+ *          regatt <id> <offset>            the peripheral moves its GATT table
+ *          button <n> <hold ms>            press a board button
+ *          end                             end of the run
+ *
+ *          '#' starts a comment. Lines starting with the same time run in file order.
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_util.h"
+#include "ble.h"
+#include "ble_hci.h"
+#include "host.h"
+
+#define FEED_LINE_MAX                   256
+#define FEED_ARG_MAX                    12
+#define FEED_PEER_NAME                  "Nordic_Blinky"         /**< Default name of a peer, the one main.c filters on. */
+#define FUZZ_REPORT_INTERVAL_US         200                     /**< Between two reports of the fuzzer. */
+#define FUZZ_ADDR_COUNT                 12                      /**< Advertisers the fuzzer pretends to be. */
+
+typedef enum
+{
+    FEED_PEER,
+    FEED_ADVERTISE,
+    FEED_RSSI,
+    FEED_SILENT,
+    FEED_DISCONNECT,
+    FEED_CONN_PARAM,
+    FEED_PHY,
+    FEED_NOTIFY,
+    FEED_REGATT,
+    FEED_BUTTON,
+    FEED_END
+} feed_cmd_type_t;
+
+/**@brief Command of the feed, checked and resolved when the feed is loaded. */
+typedef struct
+{
+    feed_cmd_type_t       type;
+    uint32_t              id;
+    uint32_t              value;
+    host_peer_cfg_t       cfg;                              /**< FEED_PEER: the whole configuration. */
+    ble_gap_conn_params_t conn_params;                      /**< FEED_CONN_PARAM. */
+    uint32_t              line;
+    uint64_t              at_us;
+} feed_cmd_t;
+
+int app_main(void);
+
+static char const * m_feed_path;
+static feed_cmd_t * m_feed;
+static uint32_t     m_feed_count;
+static uint32_t     m_fuzz_reports;
+static uint32_t     m_fuzz_sent;
+static uint64_t     m_fuzz_start_ns;
+
+
+static void usage(char const * p_prog)
+{
+    fprintf(stderr,
+            "usage: %s [-q] [--seed N] [--end MS] [--capture FILE] [--replay FILE] [--fuzz N] [FEED]\n"
+            "  -q              drop the application log, print the report only\n"
+            "  --seed N        seed of the simulation, runs with the same seed are identical\n"
+            "  --end MS        simulated time of the end of the run\n"
+            "  --capture FILE  write the BLE event capture, build with BLE_EVT_CAPTURE_ENABLED=1\n"
+            "  --replay FILE   feed the events of a capture to the application\n"
+            "  --fuzz N        feed N random advertising reports, 200 us apart\n",
+            p_prog);
+    exit(2);
+}
+
+
+static void feed_error(uint32_t line, char const * p_msg, char const * p_arg)
+{
+    fprintf(stderr, "%s:%u: %s%s%s\n", m_feed_path, line, p_msg, (p_arg != NULL) ? ": " : "",
+            (p_arg != NULL) ? p_arg : "");
+    exit(2);
+}
+
+
+static long feed_number(uint32_t line, char const * p_arg, int base)
+{
+    char * p_end;
+    long   value;
+
+    if (p_arg == NULL)
+    {
+        feed_error(line, "missing argument", NULL);
+    }
+    value = strtol(p_arg, &p_end, base);
+    if ((*p_arg == '\0') || (*p_end != '\0'))
+    {
+        feed_error(line, "not a number", p_arg);
+    }
+    return value;
+}
+
+
+static bool feed_on_off(uint32_t line, char const * p_arg)
+{
+    if ((p_arg != NULL) && (strcmp(p_arg, "on") == 0))
+    {
+        return true;
+    }
+    if ((p_arg != NULL) && (strcmp(p_arg, "off") == 0))
+    {
+        return false;
+    }
+    feed_error(line, "expected on or off", p_arg);
+    return false;
+}
+
+
+static uint8_t feed_phys(uint32_t line, char const * p_arg)
+{
+    if (p_arg != NULL)
+    {
+        if (strcmp(p_arg, "1m") == 0)
+        {
+            return BLE_GAP_PHY_1MBPS;
+        }
+        if (strcmp(p_arg, "2m") == 0)
+        {
+            return BLE_GAP_PHY_2MBPS;
+        }
+        if (strcmp(p_arg, "1m2m") == 0)
+        {
+            return BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS;
+        }
+    }
+    feed_error(line, "expected 1m, 2m or 1m2m", p_arg);
+    return 0;
+}
+
+
+static void feed_peer_key_set(uint32_t line, host_peer_cfg_t * p_cfg, char * p_arg)
+{
+    char * p_value = strchr(p_arg, '=');
+
+    if (p_value == NULL)
+    {
+        feed_error(line, "expected key=value", p_arg);
+    }
+    *p_value++ = '\0';
+    if (strcmp(p_arg, "name") == 0)
+    {
+        if (strlen(p_value) >= sizeof(p_cfg->name))
+        {
+            feed_error(line, "name too long", p_value);
+        }
+        strcpy(p_cfg->name, p_value);
+    }
+    else if (strcmp(p_arg, "rssi") == 0)
+    {
+        p_cfg->rssi = (int8_t)feed_number(line, p_value, 10);
+    }
+    else if (strcmp(p_arg, "noise") == 0)
+    {
+        p_cfg->noise = (uint8_t)feed_number(line, p_value, 10);
+    }
+    else if (strcmp(p_arg, "loss") == 0)
+    {
+        p_cfg->loss = (uint8_t)MIN(feed_number(line, p_value, 10), 100);
+    }
+    else if (strcmp(p_arg, "adv") == 0)
+    {
+        p_cfg->adv_interval_ms = (uint16_t)feed_number(line, p_value, 10);
+    }
+    else if (strcmp(p_arg, "mtu") == 0)
+    {
+        p_cfg->mtu = (uint16_t)feed_number(line, p_value, 10);
+    }
+    else if (strcmp(p_arg, "dl") == 0)
+    {
+        p_cfg->dl = (uint8_t)MIN(feed_number(line, p_value, 10), BLE_GAP_DATA_LENGTH_MAX);
+    }
+    else if (strcmp(p_arg, "phys") == 0)
+    {
+        p_cfg->phys = feed_phys(line, p_value);
+    }
+    else if (strcmp(p_arg, "wwr") == 0)
+    {
+        p_cfg->wwr = feed_number(line, p_value, 10) != 0;
+    }
+    else if (strcmp(p_arg, "echo") == 0)
+    {
+        p_cfg->echo = feed_number(line, p_value, 10) != 0;
+    }
+    else if (strcmp(p_arg, "lbs") == 0)
+    {
+        p_cfg->lbs = feed_number(line, p_value, 10) != 0;
+    }
+    else
+    {
+        feed_error(line, "unknown peer setting", p_arg);
+    }
+}
+
+
+static void feed_run(void * p_context, uint32_t arg)
+{
+    feed_cmd_t const * p_cmd = p_context;
+    bool               done  = true;
+
+    switch (p_cmd->type)
+    {
+        case FEED_PEER:
+            done = host_peer_declare(p_cmd->id, &p_cmd->cfg);
+            break;
+
+        case FEED_ADVERTISE:
+            done = host_peer_advertise(p_cmd->id, p_cmd->value != 0);
+            break;
+
+        case FEED_RSSI:
+            done = host_peer_rssi_set(p_cmd->id, (int8_t)p_cmd->value);
+            break;
+
+        case FEED_SILENT:
+            done = host_peer_silent_set(p_cmd->id, p_cmd->value != 0);
+            break;
+
+        case FEED_DISCONNECT:
+            done = host_peer_disconnect(p_cmd->id, (uint8_t)p_cmd->value);
+            break;
+
+        case FEED_CONN_PARAM:
+            done = host_peer_conn_param_request(p_cmd->id, &p_cmd->conn_params);
+            break;
+
+        case FEED_PHY:
+            done = host_peer_phy_request(p_cmd->id, (uint8_t)p_cmd->value);
+            break;
+
+        case FEED_NOTIFY:
+            done = host_peer_notify(p_cmd->id, (uint8_t)p_cmd->value);
+            break;
+
+        case FEED_REGATT:
+            done = host_peer_handles_move(p_cmd->id, (uint16_t)p_cmd->value);
+            break;
+
+        case FEED_BUTTON:
+            host_button_press(p_cmd->id, p_cmd->value);
+            break;
+
+        case FEED_END:
+            host_end_us = host_now_us();
+            break;
+    }
+    if (!done && !host_quiet)
+    {
+        fprintf(stderr, "%s:%u: command has no effect now\n", m_feed_path, p_cmd->line);
+    }
+}
+
+
+/**@brief Function for loading a feed and scheduling its commands.
+ *
+ * @details Every line is checked before the application starts, a mistake ends the run
+ *          with its line number.
+ */
+static void feed_load(char const * p_path)
+{
+    static host_peer_cfg_t cfgs[HOST_PEER_MAX];
+    static bool            declared[HOST_PEER_MAX];
+    FILE *                 p_file = fopen(p_path, "r");
+    char                   text[FEED_LINE_MAX];
+    uint32_t               line = 0;
+    uint64_t               last_ms = 0;
+    uint32_t               capacity = 0;
+
+    m_feed_path = p_path;
+    if (p_file == NULL)
+    {
+        perror(p_path);
+        exit(2);
+    }
+    while (fgets(text, sizeof(text), p_file) != NULL)
+    {
+        char *       argv[FEED_ARG_MAX];
+        uint32_t     argc = 0;
+        char *       p_comment = strchr(text, '#');
+        feed_cmd_t * p_cmd;
+        uint64_t     at_ms;
+
+        line++;
+        if (p_comment != NULL)
+        {
+            *p_comment = '\0';
+        }
+        for (char * p_tok = strtok(text, " \t\r\n"); (p_tok != NULL) && (argc < FEED_ARG_MAX); p_tok = strtok(NULL, " \t\r\n"))
+        {
+            argv[argc++] = p_tok;
+        }
+        for (uint32_t i = argc; i < FEED_ARG_MAX; i++)
+        {
+            argv[i] = NULL;
+        }
+        if (argc == 0)
+        {
+            continue;
+        }
+        if (argc < 2)
+        {
+            feed_error(line, "expected <ms> <command>", NULL);
+        }
+        at_ms = (uint64_t)feed_number(line, argv[0], 10);
+        if (at_ms < last_ms)
+        {
+            feed_error(line, "time goes backwards", argv[0]);
+        }
+        last_ms = at_ms;
+
+        if (m_feed_count == capacity)
+        {
+            capacity = MAX(2 * capacity, 64);
+            m_feed   = realloc(m_feed, capacity * sizeof(*m_feed));
+            if (m_feed == NULL)
+            {
+                feed_error(line, "out of memory", NULL);
+            }
+        }
+        p_cmd = &m_feed[m_feed_count++];
+        memset(p_cmd, 0, sizeof(*p_cmd));
+        p_cmd->line  = line;
+        p_cmd->at_us = at_ms * HOST_US_PER_MS;
+        if ((strcmp(argv[1], "end") != 0) && (strcmp(argv[1], "button") != 0))
+        {
+            p_cmd->id = (uint32_t)feed_number(line, argv[2], 10);
+            if (p_cmd->id >= HOST_PEER_MAX)
+            {
+                feed_error(line, "peer id out of range", argv[2]);
+            }
+            if ((strcmp(argv[1], "peer") != 0) && !declared[p_cmd->id])
+            {
+                feed_error(line, "peer not declared", argv[2]);
+            }
+        }
+
+        if (strcmp(argv[1], "peer") == 0)
+        {
+            if (!declared[p_cmd->id])
+            {
+                // A Blinky peripheral of the SDK on a PCA10040.
+                cfgs[p_cmd->id] = (host_peer_cfg_t){
+                    .name            = FEED_PEER_NAME,
+                    .rssi            = -60,
+                    .noise           = 4,
+                    .adv_interval_ms = 40,
+                    .mtu             = 247,
+                    .dl              = 251,
+                    .phys            = BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS,
+                    .lbs             = true,
+                };
+                declared[p_cmd->id] = true;
+            }
+            for (uint32_t i = 3; i < argc; i++)
+            {
+                feed_peer_key_set(line, &cfgs[p_cmd->id], argv[i]);
+            }
+            p_cmd->type = FEED_PEER;
+            p_cmd->cfg  = cfgs[p_cmd->id];
+        }
+        else if ((strcmp(argv[1], "noise") == 0) || (strcmp(argv[1], "loss") == 0))
+        {
+            // Both change the configuration, the peer keeps its state.
+            long value = feed_number(line, argv[3], 10);
+
+            if (argv[1][0] == 'n')
+            {
+                cfgs[p_cmd->id].noise = (uint8_t)value;
+            }
+            else
+            {
+                cfgs[p_cmd->id].loss = (uint8_t)MIN(value, 100);
+            }
+            p_cmd->type = FEED_PEER;
+            p_cmd->cfg  = cfgs[p_cmd->id];
+        }
+        else if (strcmp(argv[1], "advertise") == 0)
+        {
+            p_cmd->type  = FEED_ADVERTISE;
+            p_cmd->value = feed_on_off(line, argv[3]);
+        }
+        else if (strcmp(argv[1], "rssi") == 0)
+        {
+            p_cmd->type          = FEED_RSSI;
+            p_cmd->value         = (uint32_t)feed_number(line, argv[3], 10);
+            cfgs[p_cmd->id].rssi = (int8_t)p_cmd->value;
+        }
+        else if (strcmp(argv[1], "silent") == 0)
+        {
+            p_cmd->type  = FEED_SILENT;
+            p_cmd->value = feed_on_off(line, argv[3]);
+        }
+        else if (strcmp(argv[1], "disconnect") == 0)
+        {
+            p_cmd->type  = FEED_DISCONNECT;
+            p_cmd->value = (argv[3] != NULL) ? (uint32_t)feed_number(line, argv[3], 16)
+                                             : BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION;
+        }
+        else if (strcmp(argv[1], "conn_param") == 0)
+        {
+            p_cmd->type                          = FEED_CONN_PARAM;
+            p_cmd->conn_params.min_conn_interval = (uint16_t)(feed_number(line, argv[3], 10) * 1000 / UNIT_1_25_MS);
+            p_cmd->conn_params.max_conn_interval = (uint16_t)(feed_number(line, argv[4], 10) * 1000 / UNIT_1_25_MS);
+            p_cmd->conn_params.slave_latency     = (uint16_t)feed_number(line, argv[5], 10);
+            p_cmd->conn_params.conn_sup_timeout  = (uint16_t)(feed_number(line, argv[6], 10) * 1000 / UNIT_10_MS);
+        }
+        else if (strcmp(argv[1], "phy") == 0)
+        {
+            p_cmd->type  = FEED_PHY;
+            p_cmd->value = feed_phys(line, argv[3]);
+        }
+        else if (strcmp(argv[1], "notify") == 0)
+        {
+            p_cmd->type  = FEED_NOTIFY;
+            p_cmd->value = (uint32_t)feed_number(line, argv[3], 0);
+        }
+        else if (strcmp(argv[1], "regatt") == 0)
+        {
+            p_cmd->type  = FEED_REGATT;
+            p_cmd->value = (uint32_t)feed_number(line, argv[3], 0);
+        }
+        else if (strcmp(argv[1], "button") == 0)
+        {
+            p_cmd->type  = FEED_BUTTON;
+            p_cmd->id    = (uint32_t)feed_number(line, argv[2], 10);
+            p_cmd->value = (uint32_t)feed_number(line, argv[3], 10);
+        }
+        else if (strcmp(argv[1], "end") == 0)
+        {
+            p_cmd->type = FEED_END;
+        }
+        else
+        {
+            feed_error(line, "unknown command", argv[1]);
+        }
+    }
+    fclose(p_file);
+
+    // Schedule once the array stops moving.
+    for (uint32_t i = 0; i < m_feed_count; i++)
+    {
+        host_schedule(m_feed[i].at_us, feed_run, &m_feed[i], 0);
+    }
+}
+
+
+/**@brief Function for appending an AD structure, truncated to the room left. */
+static uint16_t fuzz_ad_put(uint8_t * p_data, uint16_t len, uint8_t type, uint8_t const * p_value, uint8_t value_len)
+{
+    uint16_t room = BLE_GAP_ADV_SET_DATA_SIZE_MAX - len;
+
+    if (room < 2)
+    {
+        return len;
+    }
+    value_len = (uint8_t)MIN(value_len, room - 2);
+    p_data[len]     = value_len + 1;
+    p_data[len + 1] = type;
+    memcpy(&p_data[len + 2], p_value, value_len);
+    return (uint16_t)(len + 2 + value_len);
+}
+
+
+/**@brief Function for building random advertising data.
+ *
+ * @details A mix of valid data, target names with one byte off, truncated names and AD
+ *          structures whose length runs past the end of the data.
+ */
+static uint16_t fuzz_adv_data(uint8_t * p_data)
+{
+    static uint8_t const flags[]   = {0x06};
+    char                 name[sizeof(FEED_PEER_NAME)];
+    uint16_t             len       = 0;
+    uint32_t             kind      = host_rand() % 8;
+    uint8_t              name_len  = (uint8_t)strlen(FEED_PEER_NAME);
+
+    memcpy(name, FEED_PEER_NAME, sizeof(name));
+    if (host_rand() % 2)
+    {
+        len = fuzz_ad_put(p_data, len, 0x01, flags, sizeof(flags));
+    }
+    switch (kind)
+    {
+        case 0:
+            // The target.
+            break;
+
+        case 1:
+            name[host_rand() % name_len] ^= (uint8_t)(1U << (host_rand() % 7));
+            break;
+
+        case 2:
+            name_len = (uint8_t)(host_rand() % name_len);
+            break;
+
+        case 3:
+            // A shortened name is not a match.
+            len = fuzz_ad_put(p_data, len, 0x08, (uint8_t const *)name, name_len);
+            return len;
+
+        case 4:
+        {
+            uint8_t random[BLE_GAP_ADV_SET_DATA_SIZE_MAX];
+
+            for (uint32_t i = 0; i < sizeof(random); i++)
+            {
+                random[i] = (uint8_t)host_rand();
+            }
+            len = (uint16_t)(host_rand() % (BLE_GAP_ADV_SET_DATA_SIZE_MAX + 1));
+            memcpy(p_data, random, len);
+            return len;
+        }
+
+        case 5:
+            len = fuzz_ad_put(p_data, len, 0x09, (uint8_t const *)name, name_len);
+            if (len > 0)
+            {
+                // The last structure claims more bytes than the data holds.
+                p_data[len - name_len - 2] = (uint8_t)(name_len + 1 + 1 + host_rand() % 8);
+            }
+            return len;
+
+        default:
+        {
+            uint8_t manufacturer[24];
+
+            for (uint32_t i = 0; i < sizeof(manufacturer); i++)
+            {
+                manufacturer[i] = (uint8_t)host_rand();
+            }
+            len = fuzz_ad_put(p_data, len, 0xFF, manufacturer, (uint8_t)(host_rand() % sizeof(manufacturer)));
+        } break;
+    }
+    return fuzz_ad_put(p_data, len, 0x09, (uint8_t const *)name, name_len);
+}
+
+
+static void fuzz_report(void * p_context, uint32_t arg)
+{
+    uint64_t                   evt[CEIL_DIV(sizeof(ble_evt_t), sizeof(uint64_t))];
+    ble_evt_t *                p_evt    = (ble_evt_t *)evt;
+    ble_gap_evt_adv_report_t * p_report = &p_evt->evt.gap_evt.params.adv_report;
+    uint8_t                    data[BLE_GAP_ADV_SET_DATA_SIZE_MAX];
+    uint16_t                   data_len = fuzz_adv_data(data);
+    uint8_t                    addr     = (uint8_t)(host_rand() % FUZZ_ADDR_COUNT);
+
+    if (m_fuzz_sent == 0)
+    {
+        m_fuzz_start_ns = host_ns();
+    }
+    memset(evt, 0, sizeof(evt));
+    p_evt->header.evt_id           = BLE_GAP_EVT_ADV_REPORT;
+    p_evt->header.evt_len          = (uint16_t)(offsetof(ble_evt_t, evt.gap_evt.params.adv_report) + sizeof(*p_report));
+    p_evt->evt.gap_evt.conn_handle = BLE_CONN_HANDLE_INVALID;
+    p_report->type.connectable     = host_rand() % 2;
+    p_report->type.scannable       = host_rand() % 2;
+    p_report->type.scan_response   = (host_rand() % 4) == 0;
+    p_report->type.status          = (host_rand() % 8 == 0) ? BLE_GAP_ADV_DATA_STATUS_INCOMPLETE_MORE_DATA
+                                                            : BLE_GAP_ADV_DATA_STATUS_COMPLETE;
+    p_report->peer_addr.addr_type  = BLE_GAP_ADDR_TYPE_RANDOM_STATIC;
+    p_report->peer_addr.addr[0]    = addr;
+    p_report->peer_addr.addr[5]    = 0xC0;
+    p_report->primary_phy          = BLE_GAP_PHY_1MBPS;
+    p_report->secondary_phy        = BLE_GAP_PHY_NOT_SET;
+    p_report->tx_power             = 127;
+    p_report->rssi                 = (int8_t)host_rand_range(-100, -30);
+    p_report->ch_index             = (uint8_t)host_rand_range(37, 39);
+    p_report->set_id               = 0xFF;
+    host_sd_evt_put(p_evt, data, data_len);
+
+    if (++m_fuzz_sent < m_fuzz_reports)
+    {
+        host_schedule(host_now_us() + FUZZ_REPORT_INTERVAL_US, fuzz_report, NULL, 0);
+    }
+    else
+    {
+        host_end_us = host_now_us() + FUZZ_REPORT_INTERVAL_US;
+    }
+}
+
+
+static void fuzz_rate_print(void)
+{
+    uint64_t wall_ns = host_ns() - m_fuzz_start_ns;
+
+    if ((m_fuzz_sent != 0) && (wall_ns != 0))
+    {
+        printf("host: fuzz %u reports, %llu reports/s\n", m_fuzz_sent,
+               (unsigned long long)((uint64_t)m_fuzz_sent * 1000000000ULL / wall_ns));
+    }
+}
+
+
+int main(int argc, char * argv[])
+{
+    char const * p_feed    = NULL;
+    char const * p_capture = NULL;
+    char const * p_replay  = NULL;
+
+    host_sim_init();
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-q") == 0)
+        {
+            host_quiet = true;
+        }
+        else if ((strcmp(argv[i], "--seed") == 0) && (i + 1 < argc))
+        {
+            host_seed((uint32_t)strtoul(argv[++i], NULL, 0));
+        }
+        else if ((strcmp(argv[i], "--end") == 0) && (i + 1 < argc))
+        {
+            host_end_us = strtoull(argv[++i], NULL, 0) * HOST_US_PER_MS;
+        }
+        else if ((strcmp(argv[i], "--capture") == 0) && (i + 1 < argc))
+        {
+            p_capture = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--replay") == 0) && (i + 1 < argc))
+        {
+            p_replay = argv[++i];
+        }
+        else if ((strcmp(argv[i], "--fuzz") == 0) && (i + 1 < argc))
+        {
+            m_fuzz_reports = (uint32_t)strtoul(argv[++i], NULL, 0);
+        }
+        else if ((argv[i][0] != '-') && (p_feed == NULL))
+        {
+            p_feed = argv[i];
+        }
+        else
+        {
+            usage(argv[0]);
+        }
+    }
+
+    if ((p_feed == NULL) && (p_replay == NULL) && (m_fuzz_reports == 0))
+    {
+        usage(argv[0]);
+    }
+    if ((p_capture != NULL) && !host_capture_open(p_capture))
+    {
+        perror(p_capture);
+        return 2;
+    }
+    if (p_feed != NULL)
+    {
+        feed_load(p_feed);
+    }
+    if (p_replay != NULL)
+    {
+        // The replayed events stand for the SoftDevice, the model only answers the calls.
+        host_sd_passive_set(true);
+        if (!host_capture_replay_load(p_replay))
+        {
+            perror(p_replay);
+            return 2;
+        }
+    }
+    if (m_fuzz_reports != 0)
+    {
+        // Every report gets a buffer of its own size, a read past the data is caught.
+        host_sd_exact_adv_data_set(true);
+        host_schedule(10 * HOST_US_PER_MS, fuzz_report, NULL, 0);
+        atexit(fuzz_rate_print);
+    }
+
+    return app_main();
+}
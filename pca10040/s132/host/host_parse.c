@@ -0,0 +1,145 @@
+/**
+ * @file
+ * @brief Host build: benchmark of the advertising report parser on a corpus of reports.
+ *
+ * @details main.c is compiled into this file, so the benchmark calls its static parser directly.
+ *          A corpus is a text file with one report per line: A for advertising data or S for a
+ *          scan response, a space, then the data in hex. '#' starts a comment.
+ *
+ *          Every report gets the work of the ADV_REPORT case of ble_evt_handler():
+ *          ad_name_match() on advertising data, ad_find() of the 128-bit UUID list on a scan
+ *          response. The corpus is parsed over and over for about PARSE_RUN_NS, each report
+ *          from a buffer of its own size, and the rate is reported in reports per second.
+ */
+#include "../../../main.c"
+
+// The application main() is app_main(), this file provides the program entry.
+#undef main
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "host.h"
+
+#define PARSE_REPORT_MAX                10000                   /**< Reports a corpus can hold. */
+#define PARSE_RUN_NS                    500000000ULL            /**< Time the measurement runs for. */
+
+/**@brief Report of the corpus. */
+typedef struct
+{
+    bool       scan_response;
+    ble_data_t data;                                            /**< Points to an allocation of the exact data size. */
+} parse_report_t;
+
+static parse_report_t   m_reports[PARSE_REPORT_MAX];
+static uint32_t         m_report_count;
+static volatile int32_t m_sink;                                 /**< Keeps the results the compiler could drop. */
+
+
+static void corpus_load(char const * p_path)
+{
+    FILE *   p_file  = fopen(p_path, "r");
+    char     line[256];
+    uint32_t line_no = 0;
+
+    if (p_file == NULL)
+    {
+        fprintf(stderr, "parse: cannot open %s\n", p_path);
+        exit(2);
+    }
+    while (fgets(line, sizeof(line), p_file) != NULL)
+    {
+        parse_report_t * p_report = &m_reports[m_report_count];
+        uint8_t          data[BLE_GAP_ADV_SET_DATA_SIZE_MAX];
+        uint16_t         len = 0;
+        char const *     p_hex;
+
+        line_no++;
+        if (((line[0] != 'A') && (line[0] != 'S')) || (line[1] != ' '))
+        {
+            continue;                                           // Comment or blank line.
+        }
+        for (p_hex = &line[2]; isxdigit((unsigned char)p_hex[0]) && isxdigit((unsigned char)p_hex[1]); p_hex += 2)
+        {
+            char byte[3] = {p_hex[0], p_hex[1], '\0'};
+
+            if (len == sizeof(data))
+            {
+                fprintf(stderr, "parse: %s:%u: more than %u bytes\n", p_path, line_no, (unsigned)sizeof(data));
+                exit(2);
+            }
+            data[len++] = (uint8_t)strtoul(byte, NULL, 16);
+        }
+        if (m_report_count == PARSE_REPORT_MAX)
+        {
+            fprintf(stderr, "parse: %s: more than %u reports\n", p_path, PARSE_REPORT_MAX);
+            exit(2);
+        }
+        p_report->scan_response = (line[0] == 'S');
+        p_report->data.p_data   = malloc(MAX(len, 1));
+        p_report->data.len      = len;
+        memcpy(p_report->data.p_data, data, len);
+        m_report_count++;
+    }
+    fclose(p_file);
+    if (m_report_count == 0)
+    {
+        fprintf(stderr, "parse: no report in %s\n", p_path);
+        exit(2);
+    }
+}
+
+
+/**@brief Function for the parser work of ble_evt_handler() on one report.
+ *
+ * @return true if the advertising data has the target name, or the scan response a 128-bit UUID list.
+ */
+static bool report_parse(parse_report_t const * p_report)
+{
+    ad_element_t uuids;
+
+    if (!p_report->scan_response)
+    {
+        return ad_name_match(&p_report->data);
+    }
+    return ad_find(&p_report->data, BLE_GAP_AD_TYPE_128BIT_SERVICE_UUID_COMPLETE, &uuids);
+}
+
+
+int main(int argc, char * argv[])
+{
+    uint32_t matches = 0;
+    uint64_t reports = 0;
+    uint64_t start;
+    uint64_t elapsed;
+
+    if (argc != 2)
+    {
+        fprintf(stderr, "usage: %s CORPUS\n", argv[0]);
+        return 2;
+    }
+    corpus_load(argv[1]);
+
+    for (uint32_t i = 0; i < m_report_count; i++)
+    {
+        matches += report_parse(&m_reports[i]) ? 1 : 0;
+    }
+
+    start = host_ns();
+    do
+    {
+        for (uint32_t i = 0; i < m_report_count; i++)
+        {
+            __asm__ volatile("" : : "r"(&m_reports[i]) : "memory");
+            m_sink += report_parse(&m_reports[i]);
+        }
+        reports += m_report_count;
+        elapsed  = host_ns() - start;
+    } while (elapsed < PARSE_RUN_NS);
+
+    printf("parse: %s, %u reports, %u matches\n", argv[1], m_report_count, matches);
+    printf("parse:   %.1f ns per report, %.0f reports/s\n",
+           (double)elapsed / reports, (double)reports * 1e9 / elapsed);
+    return 0;
+}
@@ -0,0 +1,2428 @@
+/**
+ * @file
+ * @brief Host build: SoftDevice model, with the simulated peripherals on the other side of the radio.
+ *
+ * @details The SVCALLs are normal functions here (SVCALL_AS_NORMAL_FUNCTION). A queued event
+ *          pends SD_EVT_IRQn, and nrf_sdh.c pulls the events with sd_ble_evt_get() from its
+ *          handler after the action that raised them. What the model keeps from the S132 API:
+ *          - sd_ble_enable() fails with NRF_ERROR_NO_MEM below the RAM the configuration needs,
+ *          - one scanner that pauses after every report until sd_ble_gap_scan_start(NULL, ...),
+ *          - one initiator, which stops the scanner, and CONN_COUNT when every link is used,
+ *          - one ATT request and one link layer procedure per link at a time, NRF_ERROR_BUSY else,
+ *          - a write command TX queue per link, drained by connection event length and data length,
+ *          - RSSI_CHANGED by threshold and skip count, supervision timeout on lost packets.
+ *          In passive mode (replay) every call succeeds and only the captured events reach the
+ *          application.
+ */
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "app_util.h"
+#include "app_util_platform.h"
+#include "ble.h"
+#include "ble_hci.h"
+#include "ble_lbs_c.h"
+#include "nrf_sdm.h"
+#include "nrf_soc.h"
+#include "nrf_sdh_ble.h"
+#include "sdk_config.h"
+#include "host.h"
+
+#define HOST_EVT_QUEUE_SIZE             64                      /**< Events the SoftDevice can hold for the application. */
+#define HOST_EVT_ID_COUNT               0x80                    /**< Event IDs the statistics follow, every SoftDevice event is below. */
+#define HOST_LINK_COUNT                 NRF_SDH_BLE_CENTRAL_LINK_COUNT
+#define HOST_TXQ_MAX                    32                      /**< Largest write command TX queue the model keeps. */
+#define HOST_ATT_EVENTS                 2                       /**< Connection events from an ATT request to its response. */
+#define HOST_LL_PHY_EVENTS              6                       /**< Connection events from a PHY update to its instant. */
+#define HOST_LL_DL_EVENTS               2                       /**< Connection events of a data length update. */
+#define HOST_LL_CONN_PARAM_EVENTS       7                       /**< Connection events from a connection update to its instant. */
+#define HOST_LL_ANSWER_EVENTS           40                      /**< Connection events the peer waits for an answer to its request. */
+#define HOST_CONN_ESTABLISH_EVENTS      6                       /**< Connection events without a packet before the connection fails to be established. */
+#define HOST_SCAN_RSP_DELAY_US          500                     /**< From an advertising packet to the scan response of the peer. */
+#define HOST_ADV_DELAY_MAX_US           10000                   /**< advDelay added to every advertising interval. */
+#define HOST_LBS_BASE_HANDLE            0x0010                  /**< Service declaration of the LED Button service of a peer. */
+#define HOST_ATT_HANDLE_SIZE            2
+#define HOST_IFS_US                     150
+#define HOST_RAM_BASE                   0x20000000UL            /**< Start of the RAM, the SoftDevice takes it from here. */
+#define HOST_RAM_FIXED                  0x1400                  /**< SoftDevice RAM without links, approximated. */
+#define HOST_RAM_LINK                   0x80                    /**< Link context without buffers, approximated. */
+#define HOST_RAM_LL_OVERHEAD            13                      /**< Per link layer buffer on top of the data length. */
+#define HOST_RAM_LL_BUFFERS             4                       /**< Link layer TX and RX buffers of a link. */
+#define HOST_RAM_TXQ_OVERHEAD           13                      /**< Per write command TX queue slot on top of the ATT MTU. */
+
+#define HOST_EVT_LEN(member)                                                                \
+    ((uint16_t)(offsetof(ble_evt_t, evt.member) + sizeof(((ble_evt_t *)NULL)->evt.member)))
+
+/**@brief SoftDevice calls the report counts. */
+typedef enum
+{
+    SD_CALL_SCAN_START,
+    SD_CALL_SCAN_STOP,
+    SD_CALL_CONNECT,
+    SD_CALL_CONNECT_CANCEL,
+    SD_CALL_DISCONNECT,
+    SD_CALL_CONN_PARAM_UPDATE,
+    SD_CALL_PHY_UPDATE,
+    SD_CALL_DATA_LENGTH_UPDATE,
+    SD_CALL_RSSI_START,
+    SD_CALL_RSSI_STOP,
+    SD_CALL_RSSI_GET,
+    SD_CALL_EXCHANGE_MTU_REQUEST,
+    SD_CALL_PRIMARY_SERVICES_DISCOVER,
+    SD_CALL_CHARACTERISTICS_DISCOVER,
+    SD_CALL_DESCRIPTORS_DISCOVER,
+    SD_CALL_WRITE,
+    SD_CALL_UUID_VS_ADD,
+    SD_CALL_CFG_SET,
+    SD_CALL_OPT_SET,
+    SD_CALL_COUNT
+} sd_call_t;
+
+/**@brief ATT request waiting for the response of the peer. */
+typedef enum
+{
+    ATT_OP_NONE,
+    ATT_OP_MTU,
+    ATT_OP_PRIM,
+    ATT_OP_CHAR,
+    ATT_OP_DESC,
+    ATT_OP_WRITE
+} att_op_t;
+
+/**@brief Link layer procedure in progress. */
+typedef enum
+{
+    LL_PROC_NONE,
+    LL_PROC_PHY,
+    LL_PROC_DL,
+    LL_PROC_CONN_PARAM,
+    LL_PROC_PEER_PHY,                                   /**< The peer asked for a PHY, waiting for the answer of the application. */
+    LL_PROC_PEER_CONN_PARAM                             /**< The peer asked for parameters, waiting for the answer of the application. */
+} ll_proc_t;
+
+/**@brief Latencies measured from the last feed command that changed a peer. */
+typedef enum
+{
+    HOST_LAT_REPORT,                                    /**< First advertising report of the peer. */
+    HOST_LAT_CONNECT,                                   /**< sd_ble_gap_connect() to the peer. */
+    HOST_LAT_CONNECTED,                                 /**< BLE_GAP_EVT_CONNECTED of the peer. */
+    HOST_LAT_DISCONNECT,                                /**< sd_ble_gap_disconnect() of a connected peer. */
+    HOST_LAT_COUNT
+} host_lat_type_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint64_t total_us;
+    uint64_t max_us;
+} host_lat_t;
+
+typedef struct
+{
+    uint32_t count;
+    uint64_t total_ns;
+    uint64_t max_ns;
+} host_evt_stats_t;
+
+/**@brief Queued event, with the advertising data of a report. */
+typedef struct
+{
+    uint64_t evt[CEIL_DIV(NRF_SDH_BLE_EVT_BUF_SIZE, sizeof(uint64_t))];
+    uint8_t  data[BLE_GAP_SCAN_BUFFER_MAX];
+    uint16_t data_len;
+} host_evt_slot_t;
+
+/**@brief Scanner or initiator window. */
+typedef struct
+{
+    bool                  active;
+    ble_gap_scan_params_t params;
+    uint64_t              start_us;
+    uint64_t              since_us;                     /**< Radio time is accounted up to here. */
+    uint32_t              generation;                   /**< Cancels the timeout of an earlier start. */
+} host_window_t;
+
+typedef struct host_peer_s host_peer_t;
+
+/**@brief Write command waiting in the TX queue, the peer only needs the first byte. */
+typedef struct
+{
+    uint16_t handle;
+    uint16_t len;
+    uint8_t  value;
+} host_write_cmd_t;
+
+/**@brief Connection. */
+typedef struct
+{
+    bool                  connected;
+    host_peer_t *         p_peer;
+    ble_gap_conn_params_t params;
+    uint32_t              generation;
+    uint64_t              next_event_us;
+    uint64_t              last_rx_us;
+    uint32_t              events;
+    uint32_t              rx_events;
+    bool                  disconnecting;
+    uint8_t               phy;
+    uint8_t               data_length;
+    uint16_t              att_mtu;
+    bool                  mtu_exchanged;
+    att_op_t              att_op;
+    uint32_t              att_due;
+    uint16_t              att_client_mtu;
+    ble_gattc_handle_range_t att_range;
+    ble_uuid_t            att_uuid;
+    bool                  att_uuid_valid;
+    uint16_t              att_write_handle;
+    uint8_t               att_write_value;
+    host_write_cmd_t      txq[HOST_TXQ_MAX];
+    uint8_t               txq_start;
+    uint8_t               txq_count;
+    ll_proc_t             proc;
+    uint32_t              proc_due;
+    uint8_t               proc_phy;
+    uint8_t               proc_dl;
+    ble_gap_conn_params_t proc_params;
+    bool                  rssi_on;
+    uint8_t               rssi_threshold;
+    uint8_t               rssi_skip;
+    uint8_t               rssi_over;
+    bool                  rssi_valid;
+    bool                  rssi_reported_valid;
+    int8_t                rssi_last;
+    int8_t                rssi_reported;
+    uint8_t               ch_index;
+} host_link_t;
+
+/**@brief Simulated peripheral running the LED Button service. */
+struct host_peer_s
+{
+    bool            declared;
+    uint32_t        id;
+    host_peer_cfg_t cfg;
+    ble_gap_addr_t  addr;
+    bool            advertising;
+    bool            silent;
+    uint32_t        adv_generation;
+    uint16_t        conn_handle;
+    uint16_t        handle_offset;
+    bool            cccd_enabled;
+    uint8_t         led;
+    uint8_t         button;
+    uint8_t         notify_pending;
+    bool            disconnect_pending;
+    uint8_t         disconnect_reason;
+    bool            conn_param_pending;
+    ble_gap_conn_params_t conn_param_req;
+    bool            phy_pending;
+    uint8_t         phy_req;
+    uint64_t        mark_us;
+    bool            mark_valid;
+    bool            mark_connected;
+    uint8_t         mark_done;
+    host_lat_t      lat[HOST_LAT_COUNT];
+    uint32_t        reports;
+    uint32_t        connections;
+    uint32_t        led_writes;
+    uint32_t        notifications;
+};
+
+static char const * const m_sd_call_names[SD_CALL_COUNT] =
+{
+    [SD_CALL_SCAN_START]                = "sd_ble_gap_scan_start",
+    [SD_CALL_SCAN_STOP]                 = "sd_ble_gap_scan_stop",
+    [SD_CALL_CONNECT]                   = "sd_ble_gap_connect",
+    [SD_CALL_CONNECT_CANCEL]            = "sd_ble_gap_connect_cancel",
+    [SD_CALL_DISCONNECT]                = "sd_ble_gap_disconnect",
+    [SD_CALL_CONN_PARAM_UPDATE]         = "sd_ble_gap_conn_param_update",
+    [SD_CALL_PHY_UPDATE]                = "sd_ble_gap_phy_update",
+    [SD_CALL_DATA_LENGTH_UPDATE]        = "sd_ble_gap_data_length_update",
+    [SD_CALL_RSSI_START]                = "sd_ble_gap_rssi_start",
+    [SD_CALL_RSSI_STOP]                 = "sd_ble_gap_rssi_stop",
+    [SD_CALL_RSSI_GET]                  = "sd_ble_gap_rssi_get",
+    [SD_CALL_EXCHANGE_MTU_REQUEST]      = "sd_ble_gattc_exchange_mtu_request",
+    [SD_CALL_PRIMARY_SERVICES_DISCOVER] = "sd_ble_gattc_primary_services_discover",
+    [SD_CALL_CHARACTERISTICS_DISCOVER]  = "sd_ble_gattc_characteristics_discover",
+    [SD_CALL_DESCRIPTORS_DISCOVER]      = "sd_ble_gattc_descriptors_discover",
+    [SD_CALL_WRITE]                     = "sd_ble_gattc_write",
+    [SD_CALL_UUID_VS_ADD]               = "sd_ble_uuid_vs_add",
+    [SD_CALL_CFG_SET]                   = "sd_ble_cfg_set",
+    [SD_CALL_OPT_SET]                   = "sd_ble_opt_set",
+};
+
+static char const * const m_lat_names[HOST_LAT_COUNT] =
+{
+    [HOST_LAT_REPORT]     = "report",
+    [HOST_LAT_CONNECT]    = "connect",
+    [HOST_LAT_CONNECTED]  = "connected",
+    [HOST_LAT_DISCONNECT] = "disconnect",
+};
+
+static host_evt_slot_t  m_evt_queue[HOST_EVT_QUEUE_SIZE];
+static uint32_t         m_evt_start;
+static uint32_t         m_evt_count;
+static uint32_t         m_evt_overflow;
+static host_evt_stats_t m_evt_stats[HOST_EVT_ID_COUNT];
+static uint16_t         m_evt_got_id;                   /**< Event handed to the application by the last sd_ble_evt_get(). */
+static uint64_t         m_evt_got_ns;
+static bool             m_evt_got;
+static uint8_t *        m_evt_alloc;                    /**< Exact size copy of the advertising data of that event. */
+
+static uint32_t         m_sd_calls[SD_CALL_COUNT];
+static uint32_t         m_sd_refused[SD_CALL_COUNT];
+
+static bool             m_passive;
+static bool             m_exact_adv_data;
+static int8_t           m_passive_rssi[HOST_LINK_COUNT];
+
+static bool             m_sd_enabled;
+static bool             m_ble_enabled;
+static uint8_t          m_conn_cfg_tag = BLE_CONN_CFG_TAG_DEFAULT;   /**< Tag of the connection configuration of the application. */
+static uint8_t          m_conn_count = BLE_GAP_CONN_COUNT_DEFAULT;
+static uint16_t         m_att_mtu = BLE_GATT_ATT_MTU_DEFAULT;
+static uint8_t          m_vs_uuid_cfg = BLE_UUID_VS_COUNT_DEFAULT;
+static uint8_t          m_txq_size = BLE_GATTC_WRITE_CMD_TX_QUEUE_SIZE_DEFAULT;
+static bool             m_conn_evt_ext;
+static ble_uuid128_t    m_vs_uuids[BLE_UUID_VS_COUNT_MAX];
+static uint8_t          m_vs_uuid_count;
+static uint8_t          m_lbs_uuid_type = BLE_UUID_TYPE_UNKNOWN;
+
+static host_window_t    m_scanner;
+static bool             m_scanner_paused;
+static ble_data_t       m_scan_buffer;
+static host_window_t    m_initiator;
+static ble_gap_addr_t   m_initiator_peer;
+static ble_gap_conn_params_t m_initiator_conn_params;
+static uint64_t         m_radio_on_us;
+
+static host_link_t      m_links[HOST_LINK_COUNT];
+static host_peer_t      m_peers[HOST_PEER_MAX];
+
+static uint8_t          m_blink_value;                  /**< LED value of the blink being spread over the peers. */
+static uint32_t         m_blink_peers;                  /**< Peers that took up that value so far, one bit each. */
+static uint64_t         m_blink_first_us;
+static uint64_t         m_blink_last_us;
+static uint32_t         m_blinks;                       /**< Blinks taken up by more than one peer. */
+static uint64_t         m_blink_spread_total_us;
+static uint64_t         m_blink_spread_max_us;
+
+
+static uint32_t sd_call(sd_call_t call, uint32_t err_code)
+{
+    m_sd_calls[call]++;
+    if (err_code != NRF_SUCCESS)
+    {
+        m_sd_refused[call]++;
+    }
+    return err_code;
+}
+
+
+static char const * evt_name(uint16_t evt_id)
+{
+    switch (evt_id)
+    {
+        case BLE_GAP_EVT_CONNECTED:                  return "CONNECTED";
+        case BLE_GAP_EVT_DISCONNECTED:               return "DISCONNECTED";
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE:          return "CONN_PARAM_UPDATE";
+        case BLE_GAP_EVT_TIMEOUT:                    return "TIMEOUT";
+        case BLE_GAP_EVT_RSSI_CHANGED:               return "RSSI_CHANGED";
+        case BLE_GAP_EVT_ADV_REPORT:                 return "ADV_REPORT";
+        case BLE_GAP_EVT_CONN_PARAM_UPDATE_REQUEST:  return "CONN_PARAM_UPDATE_REQUEST";
+        case BLE_GAP_EVT_PHY_UPDATE_REQUEST:         return "PHY_UPDATE_REQUEST";
+        case BLE_GAP_EVT_PHY_UPDATE:                 return "PHY_UPDATE";
+        case BLE_GAP_EVT_DATA_LENGTH_UPDATE_REQUEST: return "DATA_LENGTH_UPDATE_REQUEST";
+        case BLE_GAP_EVT_DATA_LENGTH_UPDATE:         return "DATA_LENGTH_UPDATE";
+        case BLE_GATTC_EVT_PRIM_SRVC_DISC_RSP:       return "PRIM_SRVC_DISC_RSP";
+        case BLE_GATTC_EVT_CHAR_DISC_RSP:            return "CHAR_DISC_RSP";
+        case BLE_GATTC_EVT_DESC_DISC_RSP:            return "DESC_DISC_RSP";
+        case BLE_GATTC_EVT_WRITE_RSP:                return "WRITE_RSP";
+        case BLE_GATTC_EVT_HVX:                      return "HVX";
+        case BLE_GATTC_EVT_EXCHANGE_MTU_RSP:         return "EXCHANGE_MTU_RSP";
+        case BLE_GATTC_EVT_TIMEOUT:                  return "GATTC_TIMEOUT";
+        case BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE:    return "WRITE_CMD_TX_COMPLETE";
+        default:                                     return "other";
+    }
+}
+
+
+/**@brief Function for reserving a zeroed event in the queue.
+ *
+ * @return The event, with its length set to the whole slot, or NULL when the queue is full.
+ */
+static ble_evt_t * evt_alloc(uint16_t evt_id)
+{
+    host_evt_slot_t * p_slot;
+    ble_evt_t *       p_evt;
+
+    if (m_evt_count == HOST_EVT_QUEUE_SIZE)
+    {
+        m_evt_overflow++;
+        return NULL;
+    }
+    p_slot = &m_evt_queue[(m_evt_start + m_evt_count++) % HOST_EVT_QUEUE_SIZE];
+    memset(p_slot, 0, sizeof(*p_slot));
+    p_evt                   = (ble_evt_t *)p_slot->evt;
+    p_evt->header.evt_id    = evt_id;
+    p_evt->header.evt_len   = NRF_SDH_BLE_EVT_BUF_SIZE;
+    NVIC_SetPendingIRQ(SD_EVT_IRQn);
+    return p_evt;
+}
+
+
+static host_evt_slot_t * evt_slot(ble_evt_t const * p_evt)
+{
+    return (host_evt_slot_t *)((uint8_t *)p_evt - offsetof(host_evt_slot_t, evt));
+}
+
+
+/**@brief Function for queuing an event built outside of the model, for the replay and the fuzzer. */
+void host_sd_evt_put(ble_evt_t const * p_ble_evt, uint8_t const * p_data, uint16_t data_len)
+{
+    ble_evt_t * p_evt = evt_alloc(p_ble_evt->header.evt_id);
+
+    if (p_evt == NULL)
+    {
+        return;
+    }
+    memcpy(p_evt, p_ble_evt, MIN(p_ble_evt->header.evt_len, NRF_SDH_BLE_EVT_BUF_SIZE));
+    p_evt->header.evt_len = MIN(p_ble_evt->header.evt_len, NRF_SDH_BLE_EVT_BUF_SIZE);
+    if (p_data != NULL)
+    {
+        evt_slot(p_evt)->data_len = MIN(data_len, sizeof(evt_slot(p_evt)->data));
+        memcpy(evt_slot(p_evt)->data, p_data, evt_slot(p_evt)->data_len);
+    }
+}
+
+
+static host_peer_t * peer_find_by_addr(ble_gap_addr_t const * p_addr)
+{
+    for (uint32_t i = 0; i < HOST_PEER_MAX; i++)
+    {
+        if (m_peers[i].declared && (m_peers[i].addr.addr_type == p_addr->addr_type) &&
+            (memcmp(m_peers[i].addr.addr, p_addr->addr, BLE_GAP_ADDR_LEN) == 0))
+        {
+            return &m_peers[i];
+        }
+    }
+    return NULL;
+}
+
+
+/**@brief Function for recording a latency since the last feed command that changed the peer. */
+static void peer_latency_record(host_peer_t * p_peer, host_lat_type_t type)
+{
+    uint64_t    elapsed;
+    host_lat_t * p_lat;
+
+    if ((p_peer == NULL) || !p_peer->mark_valid || (p_peer->mark_done & (1U << type)) ||
+        (p_peer->mark_connected != (type == HOST_LAT_DISCONNECT)))
+    {
+        return;
+    }
+    p_peer->mark_done |= 1U << type;
+    elapsed           = host_now_us() - p_peer->mark_us;
+    p_lat             = &p_peer->lat[type];
+    p_lat->count++;
+    p_lat->total_us  += elapsed;
+    p_lat->max_us     = MAX(p_lat->max_us, elapsed);
+}
+
+
+static void peer_mark(host_peer_t * p_peer)
+{
+    p_peer->mark_us        = host_now_us();
+    p_peer->mark_valid     = true;
+    p_peer->mark_connected = (p_peer->conn_handle != BLE_CONN_HANDLE_INVALID);
+    p_peer->mark_done      = 0;
+}
+
+
+/**@brief Function for accounting the observer time of the event handed out by the last call. */
+static void evt_got_account(void)
+{
+    uint64_t elapsed = host_ns() - m_evt_got_ns;
+
+    if (!m_evt_got)
+    {
+        return;
+    }
+    m_evt_got = false;
+    free(m_evt_alloc);
+    m_evt_alloc = NULL;
+    if (m_evt_got_id < HOST_EVT_ID_COUNT)
+    {
+        host_evt_stats_t * p_stats = &m_evt_stats[m_evt_got_id];
+
+        p_stats->count++;
+        p_stats->total_ns += elapsed;
+        p_stats->max_ns    = MAX(p_stats->max_ns, elapsed);
+    }
+}
+
+
+/**@brief Function for handing the oldest event to the application.
+ *
+ * @details The advertising data of a report is copied to the scan buffer of the application,
+ *          or to an allocation of its exact size so a sanitizer catches reads past the data.
+ *          The time to the next call is the time of the observers of the event.
+ */
+uint32_t sd_ble_evt_get(uint8_t * p_dest, uint16_t * p_len)
+{
+    static uint8_t    fallback[BLE_GAP_SCAN_BUFFER_MAX];
+    host_evt_slot_t * p_slot;
+    ble_evt_t *       p_evt;
+
+    evt_got_account();
+    if (p_len == NULL)
+    {
+        return NRF_ERROR_INVALID_ADDR;
+    }
+    if (m_evt_count == 0)
+    {
+        return NRF_ERROR_NOT_FOUND;
+    }
+    p_slot = &m_evt_queue[m_evt_start];
+    p_evt  = (ble_evt_t *)p_slot->evt;
+    if (p_dest == NULL)
+    {
+        *p_len = p_evt->header.evt_len;
+        return NRF_SUCCESS;
+    }
+    if (*p_len < p_evt->header.evt_len)
+    {
+        *p_len = p_evt->header.evt_len;
+        return NRF_ERROR_DATA_SIZE;
+    }
+
+    m_evt_start = (m_evt_start + 1) % HOST_EVT_QUEUE_SIZE;
+    m_evt_count--;
+
+    if (p_evt->header.evt_id == BLE_GAP_EVT_ADV_REPORT)
+    {
+        ble_data_t * p_data = &p_evt->evt.gap_evt.params.adv_report.data;
+
+        if (m_exact_adv_data)
+        {
+            m_evt_alloc    = malloc(MAX(p_slot->data_len, 1));
+            p_data->p_data = m_evt_alloc;
+            p_data->len    = p_slot->data_len;
+        }
+        else if (m_scan_buffer.p_data != NULL)
+        {
+            p_data->p_data = m_scan_buffer.p_data;
+            p_data->len    = MIN(p_slot->data_len, m_scan_buffer.len);
+        }
+        else
+        {
+            p_data->p_data = fallback;
+            p_data->len    = MIN(p_slot->data_len, sizeof(fallback));
+        }
+        memcpy(p_data->p_data, p_slot->data, p_data->len);
+        if (m_scanner.active)
+        {
+            m_scanner_paused = true;
+        }
+        if (!m_passive && !p_evt->evt.gap_evt.params.adv_report.type.scan_response)
+        {
+            host_peer_t * p_peer = peer_find_by_addr(&p_evt->evt.gap_evt.params.adv_report.peer_addr);
+
+            if (p_peer != NULL)
+            {
+                p_peer->reports++;
+                peer_latency_record(p_peer, HOST_LAT_REPORT);
+            }
+        }
+    }
+
+    memcpy(p_dest, p_evt, p_evt->header.evt_len);
+    *p_len        = p_evt->header.evt_len;
+    m_evt_got     = true;
+    m_evt_got_id  = p_evt->header.evt_id;
+    m_evt_got_ns  = host_ns();
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Function for pulling a SoC event, the model raises none. */
+uint32_t sd_evt_get(uint32_t * p_evt_id)
+{
+    return (p_evt_id == NULL) ? NRF_ERROR_INVALID_ADDR : NRF_ERROR_NOT_FOUND;
+}
+
+
+uint32_t sd_app_evt_wait(void)
+{
+    host_wfe();
+    return NRF_SUCCESS;
+}
+
+
+uint32_t sd_softdevice_enable(nrf_clock_lf_cfg_t const * p_clock_lf_cfg, nrf_fault_handler_t fault_handler)
+{
+    if ((p_clock_lf_cfg == NULL) || (fault_handler == NULL))
+    {
+        return NRF_ERROR_INVALID_ADDR;
+    }
+    if (m_sd_enabled)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    m_sd_enabled = true;
+    NVIC_SetPriority(SD_EVT_IRQn, APP_IRQ_PRIORITY_LOW);
+    return NRF_SUCCESS;
+}
+
+
+uint32_t sd_softdevice_disable(void)
+{
+    m_sd_enabled  = false;
+    m_ble_enabled = false;
+    return NRF_SUCCESS;
+}
+
+
+uint32_t sd_softdevice_is_enabled(uint8_t * p_softdevice_enabled)
+{
+    *p_softdevice_enabled = m_sd_enabled;
+    return NRF_SUCCESS;
+}
+
+
+/**@brief Function for entering System OFF, which ends the run. */
+uint32_t sd_power_system_off(void)
+{
+    printf("host: system off, t = %llu us\n", (unsigned long long)host_now_us());
+    host_finish();
+    return NRF_SUCCESS;
+}
+
+
+void host_sd_passive_set(bool passive)
+{
+    m_passive = passive;
+}
+
+
+void host_sd_exact_adv_data_set(bool exact)
+{
+    m_exact_adv_data = exact;
+}
+
+
+void host_sd_rssi_set(uint16_t conn_handle, int8_t rssi)
+{
+    if (conn_handle < HOST_LINK_COUNT)
+    {
+        m_passive_rssi[conn_handle] = rssi;
+    }
+}
+
+
+/**@brief Function for computing the radio time of a scan window from its start up to an offset. */
+static uint64_t window_on_us(ble_gap_scan_params_t const * p_params, uint64_t offset_us)
+{
+    uint64_t interval_us = (uint64_t)p_params->interval * UNIT_0_625_MS;
+    uint64_t window_us   = (uint64_t)p_params->window * UNIT_0_625_MS;
+
+    return (offset_us / interval_us) * window_us + MIN(offset_us % interval_us, window_us);
+}
+
+
+static void window_account(host_window_t * p_window)
+{
+    uint64_t now = host_now_us();
+
+    if (p_window->active)
+    {
+        m_radio_on_us     += window_on_us(&p_window->params, now - p_window->start_us) -
+                             window_on_us(&p_window->params, p_window->since_us - p_window->start_us);
+        p_window->since_us = now;
+    }
+}
+
+
+static bool window_listening(host_window_t const * p_window)
+{
+    uint64_t offset_us = host_now_us() - p_window->start_us;
+
+    return p_window->active &&
+           ((offset_us % ((uint64_t)p_window->params.interval * UNIT_0_625_MS)) <
+            (uint64_t)p_window->params.window * UNIT_0_625_MS);
+}
+
+
+static void window_start(host_window_t * p_window, ble_gap_scan_params_t const * p_params)
+{
+    p_window->active   = true;
+    p_window->params   = *p_params;
+    p_window->start_us = host_now_us();
+    p_window->since_us = p_window->start_us;
+    p_window->generation++;
+}
+
+
+static void window_stop(host_window_t * p_window)
+{
+    window_account(p_window);
+    p_window->active = false;
+    p_window->generation++;
+}
+
+
+static bool scan_params_valid(ble_gap_scan_params_t const * p_params)
+{
+    return (p_params->interval >= BLE_GAP_SCAN_INTERVAL_MIN) &&
+           (p_params->window >= BLE_GAP_SCAN_WINDOW_MIN) &&
+           (p_params->window <= p_params->interval) &&
+           !p_params->extended &&
+           ((p_params->scan_phys == BLE_GAP_PHY_AUTO) || (p_params->scan_phys == BLE_GAP_PHY_1MBPS));
+}
+
+
+static void scan_timeout(void * p_context, uint32_t generation)
+{
+    ble_evt_t * p_evt;
+
+    if (!m_scanner.active || (m_scanner.generation != generation))
+    {
+        return;
+    }
+    window_stop(&m_scanner);
+    p_evt = evt_alloc(BLE_GAP_EVT_TIMEOUT);
+    if (p_evt != NULL)
+    {
+        p_evt->header.evt_len                                    = HOST_EVT_LEN(gap_evt.params.timeout);
+        p_evt->evt.gap_evt.conn_handle                           = BLE_CONN_HANDLE_INVALID;
+        p_evt->evt.gap_evt.params.timeout.src                    = BLE_GAP_TIMEOUT_SRC_SCAN;
+        p_evt->evt.gap_evt.params.timeout.params.adv_report_buffer = m_scan_buffer;
+    }
+}
+
+
+uint32_t sd_ble_gap_scan_start(ble_gap_scan_params_t const * p_scan_params, ble_data_t const * p_adv_report_buffer)
+{
+    if ((p_adv_report_buffer == NULL) || (p_adv_report_buffer->p_data == NULL) ||
+        (p_adv_report_buffer->len < BLE_GAP_SCAN_BUFFER_MIN))
+    {
+        return sd_call(SD_CALL_SCAN_START, NRF_ERROR_INVALID_PARAM);
+    }
+    m_scan_buffer = *p_adv_report_buffer;
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_SCAN_START, NRF_SUCCESS);
+    }
+
+    if (p_scan_params == NULL)
+    {
+        // Resume after a report.
+        if (!m_scanner.active || !m_scanner_paused)
+        {
+            return sd_call(SD_CALL_SCAN_START, NRF_ERROR_INVALID_STATE);
+        }
+        m_scanner_paused = false;
+        return sd_call(SD_CALL_SCAN_START, NRF_SUCCESS);
+    }
+
+    if (m_scanner.active || m_initiator.active)
+    {
+        return sd_call(SD_CALL_SCAN_START, NRF_ERROR_INVALID_STATE);
+    }
+    if (!scan_params_valid(p_scan_params))
+    {
+        return sd_call(SD_CALL_SCAN_START, NRF_ERROR_INVALID_PARAM);
+    }
+
+    window_start(&m_scanner, p_scan_params);
+    m_scanner_paused = false;
+    if (p_scan_params->timeout != BLE_GAP_SCAN_TIMEOUT_UNLIMITED)
+    {
+        host_schedule(host_now_us() + (uint64_t)p_scan_params->timeout * UNIT_10_MS,
+                      scan_timeout, NULL, m_scanner.generation);
+    }
+    return sd_call(SD_CALL_SCAN_START, NRF_SUCCESS);
+}
+
+
+uint32_t sd_ble_gap_scan_stop(void)
+{
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_SCAN_STOP, NRF_SUCCESS);
+    }
+    if (!m_scanner.active)
+    {
+        return sd_call(SD_CALL_SCAN_STOP, NRF_ERROR_INVALID_STATE);
+    }
+    window_stop(&m_scanner);
+    return sd_call(SD_CALL_SCAN_STOP, NRF_SUCCESS);
+}
+
+
+static bool conn_params_valid(ble_gap_conn_params_t const * p_params)
+{
+    return (p_params->min_conn_interval >= BLE_GAP_CP_MIN_CONN_INTVL_MIN) &&
+           (p_params->max_conn_interval <= BLE_GAP_CP_MAX_CONN_INTVL_MAX) &&
+           (p_params->min_conn_interval <= p_params->max_conn_interval) &&
+           (p_params->slave_latency <= BLE_GAP_CP_SLAVE_LATENCY_MAX) &&
+           (p_params->conn_sup_timeout >= BLE_GAP_CP_CONN_SUP_TIMEOUT_MIN) &&
+           (p_params->conn_sup_timeout <= BLE_GAP_CP_CONN_SUP_TIMEOUT_MAX) &&
+           // The supervision timeout has to cover two intervals with the slave latency.
+           ((uint32_t)p_params->conn_sup_timeout * 4 >
+            (1U + p_params->slave_latency) * p_params->max_conn_interval);
+}
+
+
+static host_link_t * link_get(uint16_t conn_handle)
+{
+    if ((conn_handle >= HOST_LINK_COUNT) || !m_links[conn_handle].connected)
+    {
+        return NULL;
+    }
+    return &m_links[conn_handle];
+}
+
+
+static void connect_timeout(void * p_context, uint32_t generation)
+{
+    ble_evt_t * p_evt;
+
+    if (!m_initiator.active || (m_initiator.generation != generation))
+    {
+        return;
+    }
+    window_stop(&m_initiator);
+    p_evt = evt_alloc(BLE_GAP_EVT_TIMEOUT);
+    if (p_evt != NULL)
+    {
+        p_evt->header.evt_len                 = HOST_EVT_LEN(gap_evt.params.timeout);
+        p_evt->evt.gap_evt.conn_handle        = BLE_CONN_HANDLE_INVALID;
+        p_evt->evt.gap_evt.params.timeout.src = BLE_GAP_TIMEOUT_SRC_CONN;
+    }
+}
+
+
+uint32_t sd_ble_gap_connect(ble_gap_addr_t const *        p_peer_addr,
+                            ble_gap_scan_params_t const * p_scan_params,
+                            ble_gap_conn_params_t const * p_conn_params,
+                            uint8_t                       conn_cfg_tag)
+{
+    uint32_t connected = 0;
+
+    if ((p_peer_addr == NULL) || (p_scan_params == NULL) || (p_conn_params == NULL))
+    {
+        return sd_call(SD_CALL_CONNECT, NRF_ERROR_INVALID_ADDR);
+    }
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_CONNECT, NRF_SUCCESS);
+    }
+    if (!scan_params_valid(p_scan_params) || !conn_params_valid(p_conn_params))
+    {
+        return sd_call(SD_CALL_CONNECT, NRF_ERROR_INVALID_PARAM);
+    }
+    if ((conn_cfg_tag != m_conn_cfg_tag) && (conn_cfg_tag != BLE_CONN_CFG_TAG_DEFAULT))
+    {
+        return sd_call(SD_CALL_CONNECT, NRF_ERROR_NOT_FOUND);
+    }
+    if (m_initiator.active)
+    {
+        return sd_call(SD_CALL_CONNECT, NRF_ERROR_INVALID_STATE);
+    }
+    for (uint32_t i = 0; i < HOST_LINK_COUNT; i++)
+    {
+        connected += m_links[i].connected ? 1 : 0;
+    }
+    if (connected == HOST_LINK_COUNT)
+    {
+        return sd_call(SD_CALL_CONNECT, NRF_ERROR_CONN_COUNT);
+    }
+
+    // A running scanner is stopped by the connection attempt.
+    if (m_scanner.active)
+    {
+        window_stop(&m_scanner);
+    }
+    window_start(&m_initiator, p_scan_params);
+    m_initiator_peer        = *p_peer_addr;
+    m_initiator_conn_params = *p_conn_params;
+    if (p_scan_params->timeout != BLE_GAP_SCAN_TIMEOUT_UNLIMITED)
+    {
+        host_schedule(host_now_us() + (uint64_t)p_scan_params->timeout * UNIT_10_MS,
+                      connect_timeout, NULL, m_initiator.generation);
+    }
+    peer_latency_record(peer_find_by_addr(p_peer_addr), HOST_LAT_CONNECT);
+    return sd_call(SD_CALL_CONNECT, NRF_SUCCESS);
+}
+
+
+uint32_t sd_ble_gap_connect_cancel(void)
+{
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_CONNECT_CANCEL, NRF_SUCCESS);
+    }
+    if (!m_initiator.active)
+    {
+        return sd_call(SD_CALL_CONNECT_CANCEL, NRF_ERROR_INVALID_STATE);
+    }
+    window_stop(&m_initiator);
+    return sd_call(SD_CALL_CONNECT_CANCEL, NRF_SUCCESS);
+}
+
+
+static void peer_adv_schedule(host_peer_t * p_peer, uint64_t delay_us);
+
+
+/**@brief Function for ending a link and telling the application. */
+static void link_drop(host_link_t * p_link, uint8_t reason)
+{
+    uint16_t      conn_handle = (uint16_t)(p_link - m_links);
+    host_peer_t * p_peer      = p_link->p_peer;
+    ble_evt_t *   p_evt;
+
+    p_link->connected = false;
+    p_link->generation++;
+    if (p_peer != NULL)
+    {
+        p_peer->conn_handle        = BLE_CONN_HANDLE_INVALID;
+        p_peer->cccd_enabled       = false;
+        p_peer->notify_pending     = 0;
+        p_peer->disconnect_pending = false;
+        p_peer->conn_param_pending = false;
+        p_peer->phy_pending        = false;
+        if (p_peer->advertising && !p_peer->silent)
+        {
+            peer_adv_schedule(p_peer, 0);
+        }
+    }
+
+    p_evt = evt_alloc(BLE_GAP_EVT_DISCONNECTED);
+    if (p_evt != NULL)
+    {
+        p_evt->header.evt_len                         = HOST_EVT_LEN(gap_evt.params.disconnected);
+        p_evt->evt.gap_evt.conn_handle                = conn_handle;
+        p_evt->evt.gap_evt.params.disconnected.reason = reason;
+    }
+}
+
+
+uint32_t sd_ble_gap_disconnect(uint16_t conn_handle, uint8_t hci_status_code)
+{
+    host_link_t * p_link = link_get(conn_handle);
+
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_DISCONNECT, NRF_SUCCESS);
+    }
+    if ((hci_status_code != BLE_HCI_REMOTE_USER_TERMINATED_CONNECTION) &&
+        (hci_status_code != BLE_HCI_CONN_INTERVAL_UNACCEPTABLE))
+    {
+        return sd_call(SD_CALL_DISCONNECT, NRF_ERROR_INVALID_PARAM);
+    }
+    if (p_link == NULL)
+    {
+        return sd_call(SD_CALL_DISCONNECT, BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (p_link->disconnecting)
+    {
+        return sd_call(SD_CALL_DISCONNECT, NRF_ERROR_INVALID_STATE);
+    }
+    p_link->disconnecting = true;
+    peer_latency_record(p_link->p_peer, HOST_LAT_DISCONNECT);
+    return sd_call(SD_CALL_DISCONNECT, NRF_SUCCESS);
+}
+
+
+/**@brief Function for picking the PHY of a link from the PHYs both sides allow. */
+static uint8_t phy_choose(uint8_t local, uint8_t remote, uint8_t current)
+{
+    uint8_t allowed = ((local == BLE_GAP_PHY_AUTO) ? (BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS) : local) &
+                      ((remote == BLE_GAP_PHY_AUTO) ? (BLE_GAP_PHY_1MBPS | BLE_GAP_PHY_2MBPS) : remote);
+
+    if (allowed & BLE_GAP_PHY_2MBPS)
+    {
+        return BLE_GAP_PHY_2MBPS;
+    }
+    if (allowed & BLE_GAP_PHY_1MBPS)
+    {
+        return BLE_GAP_PHY_1MBPS;
+    }
+    return current;
+}
+
+
+uint32_t sd_ble_gap_conn_param_update(uint16_t conn_handle, ble_gap_conn_params_t const * p_conn_params)
+{
+    host_link_t * p_link = link_get(conn_handle);
+
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_CONN_PARAM_UPDATE, NRF_SUCCESS);
+    }
+    if (p_link == NULL)
+    {
+        return sd_call(SD_CALL_CONN_PARAM_UPDATE, BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (p_link->disconnecting)
+    {
+        return sd_call(SD_CALL_CONN_PARAM_UPDATE, NRF_ERROR_INVALID_STATE);
+    }
+    if (p_link->proc == LL_PROC_PEER_CONN_PARAM)
+    {
+        if (p_conn_params == NULL)
+        {
+            // The request of the peer is rejected.
+            p_link->proc = LL_PROC_NONE;
+            return sd_call(SD_CALL_CONN_PARAM_UPDATE, NRF_SUCCESS);
+        }
+    }
+    else if (p_link->proc != LL_PROC_NONE)
+    {
+        return sd_call(SD_CALL_CONN_PARAM_UPDATE, NRF_ERROR_BUSY);
+    }
+    if ((p_conn_params == NULL) || !conn_params_valid(p_conn_params))
+    {
+        return sd_call(SD_CALL_CONN_PARAM_UPDATE, NRF_ERROR_INVALID_PARAM);
+    }
+
+    p_link->proc        = LL_PROC_CONN_PARAM;
+    p_link->proc_due    = p_link->rx_events + HOST_LL_CONN_PARAM_EVENTS;
+    p_link->proc_params = *p_conn_params;
+    return sd_call(SD_CALL_CONN_PARAM_UPDATE, NRF_SUCCESS);
+}
+
+
+uint32_t sd_ble_gap_phy_update(uint16_t conn_handle, ble_gap_phys_t const * p_gap_phys)
+{
+    host_link_t * p_link = link_get(conn_handle);
+    uint8_t       remote;
+
+    if (p_gap_phys == NULL)
+    {
+        return sd_call(SD_CALL_PHY_UPDATE, NRF_ERROR_INVALID_ADDR);
+    }
+    if ((p_gap_phys->tx_phys | p_gap_phys->rx_phys) & BLE_GAP_PHY_CODED)
+    {
+        // S132 has no Coded PHY.
+        return sd_call(SD_CALL_PHY_UPDATE, NRF_ERROR_NOT_SUPPORTED);
+    }
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_PHY_UPDATE, NRF_SUCCESS);
+    }
+    if (p_link == NULL)
+    {
+        return sd_call(SD_CALL_PHY_UPDATE, BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (p_link->disconnecting)
+    {
+        return sd_call(SD_CALL_PHY_UPDATE, NRF_ERROR_INVALID_STATE);
+    }
+    if (p_link->proc == LL_PROC_PEER_PHY)
+    {
+        remote = p_link->p_peer->phy_req & p_link->p_peer->cfg.phys;
+    }
+    else if (p_link->proc == LL_PROC_NONE)
+    {
+        remote = p_link->p_peer->cfg.phys;
+    }
+    else
+    {
+        return sd_call(SD_CALL_PHY_UPDATE, NRF_ERROR_BUSY);
+    }
+
+    p_link->proc     = LL_PROC_PHY;
+    p_link->proc_due = p_link->rx_events + HOST_LL_PHY_EVENTS;
+    p_link->proc_phy = phy_choose(p_gap_phys->tx_phys, remote, p_link->phy);
+    return sd_call(SD_CALL_PHY_UPDATE, NRF_SUCCESS);
+}
+
+
+uint32_t sd_ble_gap_data_length_update(uint16_t                             conn_handle,
+                                       ble_gap_data_length_params_t const * p_dl_params,
+                                       ble_gap_data_length_limitation_t *   p_dl_limitation)
+{
+    host_link_t * p_link = link_get(conn_handle);
+    uint16_t      octets = ((p_dl_params == NULL) || (p_dl_params->max_tx_octets == BLE_GAP_DATA_LENGTH_AUTO))
+                           ? NRF_SDH_BLE_GAP_DATA_LENGTH : p_dl_params->max_tx_octets;
+
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_DATA_LENGTH_UPDATE, NRF_SUCCESS);
+    }
+    if (p_link == NULL)
+    {
+        return sd_call(SD_CALL_DATA_LENGTH_UPDATE, BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (p_link->disconnecting)
+    {
+        return sd_call(SD_CALL_DATA_LENGTH_UPDATE, NRF_ERROR_INVALID_STATE);
+    }
+    if ((octets < BLE_GAP_DATA_LENGTH_DEFAULT) || (octets > BLE_GAP_DATA_LENGTH_MAX))
+    {
+        return sd_call(SD_CALL_DATA_LENGTH_UPDATE, NRF_ERROR_INVALID_PARAM);
+    }
+    if (octets > NRF_SDH_BLE_GAP_DATA_LENGTH)
+    {
+        if (p_dl_limitation != NULL)
+        {
+            p_dl_limitation->tx_payload_limited_octets = octets - NRF_SDH_BLE_GAP_DATA_LENGTH;
+            p_dl_limitation->rx_payload_limited_octets = octets - NRF_SDH_BLE_GAP_DATA_LENGTH;
+        }
+        return sd_call(SD_CALL_DATA_LENGTH_UPDATE, NRF_ERROR_RESOURCES);
+    }
+    if (p_link->proc != LL_PROC_NONE)
+    {
+        return sd_call(SD_CALL_DATA_LENGTH_UPDATE, NRF_ERROR_BUSY);
+    }
+
+    p_link->proc     = LL_PROC_DL;
+    p_link->proc_due = p_link->rx_events + HOST_LL_DL_EVENTS;
+    p_link->proc_dl  = (uint8_t)MIN(octets, p_link->p_peer->cfg.dl);
+    return sd_call(SD_CALL_DATA_LENGTH_UPDATE, NRF_SUCCESS);
+}
+
+
+uint32_t sd_ble_gap_rssi_start(uint16_t conn_handle, uint8_t threshold_dbm, uint8_t skip_count)
+{
+    host_link_t * p_link = link_get(conn_handle);
+
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_RSSI_START, NRF_SUCCESS);
+    }
+    if (p_link == NULL)
+    {
+        return sd_call(SD_CALL_RSSI_START, BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (p_link->rssi_on)
+    {
+        return sd_call(SD_CALL_RSSI_START, NRF_ERROR_INVALID_STATE);
+    }
+    p_link->rssi_on             = true;
+    p_link->rssi_threshold      = threshold_dbm;
+    p_link->rssi_skip           = skip_count;
+    p_link->rssi_over           = 0;
+    p_link->rssi_reported_valid = false;
+    return sd_call(SD_CALL_RSSI_START, NRF_SUCCESS);
+}
+
+
+uint32_t sd_ble_gap_rssi_stop(uint16_t conn_handle)
+{
+    host_link_t * p_link = link_get(conn_handle);
+
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_RSSI_STOP, NRF_SUCCESS);
+    }
+    if (p_link == NULL)
+    {
+        return sd_call(SD_CALL_RSSI_STOP, BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (!p_link->rssi_on)
+    {
+        return sd_call(SD_CALL_RSSI_STOP, NRF_ERROR_INVALID_STATE);
+    }
+    p_link->rssi_on = false;
+    return sd_call(SD_CALL_RSSI_STOP, NRF_SUCCESS);
+}
+
+
+uint32_t sd_ble_gap_rssi_get(uint16_t conn_handle, int8_t * p_rssi, uint8_t * p_ch_index)
+{
+    host_link_t * p_link = link_get(conn_handle);
+
+    if ((p_rssi == NULL) || (p_ch_index == NULL))
+    {
+        return sd_call(SD_CALL_RSSI_GET, NRF_ERROR_INVALID_ADDR);
+    }
+    if (m_passive)
+    {
+        *p_rssi     = (conn_handle < HOST_LINK_COUNT) ? m_passive_rssi[conn_handle] : 0;
+        *p_ch_index = 0;
+        return sd_call(SD_CALL_RSSI_GET, NRF_SUCCESS);
+    }
+    if (p_link == NULL)
+    {
+        return sd_call(SD_CALL_RSSI_GET, BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (!p_link->rssi_on)
+    {
+        return sd_call(SD_CALL_RSSI_GET, NRF_ERROR_INVALID_STATE);
+    }
+    if (!p_link->rssi_valid)
+    {
+        return sd_call(SD_CALL_RSSI_GET, NRF_ERROR_NOT_FOUND);
+    }
+    *p_rssi     = p_link->rssi_last;
+    *p_ch_index = p_link->ch_index;
+    return sd_call(SD_CALL_RSSI_GET, NRF_SUCCESS);
+}
+
+
+/**@brief Function for checking an ATT request can be sent on a link.
+ *
+ * @return NRF_SUCCESS, or the error of the SoftDevice call.
+ */
+static uint32_t att_request_check(host_link_t const * p_link)
+{
+    if (p_link == NULL)
+    {
+        return BLE_ERROR_INVALID_CONN_HANDLE;
+    }
+    if (p_link->disconnecting)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if (p_link->att_op != ATT_OP_NONE)
+    {
+        return NRF_ERROR_BUSY;
+    }
+    return NRF_SUCCESS;
+}
+
+
+static void att_request_start(host_link_t * p_link, att_op_t op)
+{
+    p_link->att_op  = op;
+    p_link->att_due = p_link->rx_events + HOST_ATT_EVENTS;
+}
+
+
+uint32_t sd_ble_gattc_exchange_mtu_request(uint16_t conn_handle, uint16_t client_rx_mtu)
+{
+    host_link_t * p_link = link_get(conn_handle);
+    uint32_t      err_code;
+
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_EXCHANGE_MTU_REQUEST, NRF_SUCCESS);
+    }
+    err_code = att_request_check(p_link);
+    if (err_code != NRF_SUCCESS)
+    {
+        return sd_call(SD_CALL_EXCHANGE_MTU_REQUEST, err_code);
+    }
+    if (p_link->mtu_exchanged)
+    {
+        return sd_call(SD_CALL_EXCHANGE_MTU_REQUEST, NRF_ERROR_INVALID_STATE);
+    }
+    if ((client_rx_mtu < BLE_GATT_ATT_MTU_DEFAULT) || (client_rx_mtu > NRF_SDH_BLE_GATT_MAX_MTU_SIZE))
+    {
+        return sd_call(SD_CALL_EXCHANGE_MTU_REQUEST, NRF_ERROR_INVALID_PARAM);
+    }
+    att_request_start(p_link, ATT_OP_MTU);
+    p_link->att_client_mtu = client_rx_mtu;
+    return sd_call(SD_CALL_EXCHANGE_MTU_REQUEST, NRF_SUCCESS);
+}
+
+
+uint32_t sd_ble_gattc_primary_services_discover(uint16_t conn_handle, uint16_t start_handle, ble_uuid_t const * p_srvc_uuid)
+{
+    host_link_t * p_link = link_get(conn_handle);
+    uint32_t      err_code;
+
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_PRIMARY_SERVICES_DISCOVER, NRF_SUCCESS);
+    }
+    err_code = att_request_check(p_link);
+    if (err_code != NRF_SUCCESS)
+    {
+        return sd_call(SD_CALL_PRIMARY_SERVICES_DISCOVER, err_code);
+    }
+    if (start_handle == BLE_GATT_HANDLE_INVALID)
+    {
+        return sd_call(SD_CALL_PRIMARY_SERVICES_DISCOVER, NRF_ERROR_INVALID_PARAM);
+    }
+    att_request_start(p_link, ATT_OP_PRIM);
+    p_link->att_range.start_handle = start_handle;
+    p_link->att_range.end_handle   = BLE_GATT_HANDLE_END;
+    p_link->att_uuid_valid         = (p_srvc_uuid != NULL);
+    if (p_srvc_uuid != NULL)
+    {
+        p_link->att_uuid = *p_srvc_uuid;
+    }
+    return sd_call(SD_CALL_PRIMARY_SERVICES_DISCOVER, NRF_SUCCESS);
+}
+
+
+static uint32_t range_discover(sd_call_t call, uint16_t conn_handle, ble_gattc_handle_range_t const * p_range, att_op_t op)
+{
+    host_link_t * p_link = link_get(conn_handle);
+    uint32_t      err_code;
+
+    if (p_range == NULL)
+    {
+        return sd_call(call, NRF_ERROR_INVALID_ADDR);
+    }
+    if (m_passive)
+    {
+        return sd_call(call, NRF_SUCCESS);
+    }
+    err_code = att_request_check(p_link);
+    if (err_code != NRF_SUCCESS)
+    {
+        return sd_call(call, err_code);
+    }
+    if ((p_range->start_handle == BLE_GATT_HANDLE_INVALID) || (p_range->start_handle > p_range->end_handle))
+    {
+        return sd_call(call, NRF_ERROR_INVALID_PARAM);
+    }
+    att_request_start(p_link, op);
+    p_link->att_range = *p_range;
+    return sd_call(call, NRF_SUCCESS);
+}
+
+
+uint32_t sd_ble_gattc_characteristics_discover(uint16_t conn_handle, ble_gattc_handle_range_t const * p_handle_range)
+{
+    return range_discover(SD_CALL_CHARACTERISTICS_DISCOVER, conn_handle, p_handle_range, ATT_OP_CHAR);
+}
+
+
+uint32_t sd_ble_gattc_descriptors_discover(uint16_t conn_handle, ble_gattc_handle_range_t const * p_handle_range)
+{
+    return range_discover(SD_CALL_DESCRIPTORS_DISCOVER, conn_handle, p_handle_range, ATT_OP_DESC);
+}
+
+
+uint32_t sd_ble_gattc_write(uint16_t conn_handle, ble_gattc_write_params_t const * p_write_params)
+{
+    host_link_t * p_link = link_get(conn_handle);
+    uint32_t      err_code;
+
+    if ((p_write_params == NULL) || ((p_write_params->len != 0) && (p_write_params->p_value == NULL)))
+    {
+        return sd_call(SD_CALL_WRITE, NRF_ERROR_INVALID_ADDR);
+    }
+    if (m_passive)
+    {
+        return sd_call(SD_CALL_WRITE, NRF_SUCCESS);
+    }
+    if (p_link == NULL)
+    {
+        return sd_call(SD_CALL_WRITE, BLE_ERROR_INVALID_CONN_HANDLE);
+    }
+    if (p_link->disconnecting)
+    {
+        return sd_call(SD_CALL_WRITE, NRF_ERROR_INVALID_STATE);
+    }
+    if (p_write_params->handle == BLE_GATT_HANDLE_INVALID)
+    {
+        return sd_call(SD_CALL_WRITE, NRF_ERROR_INVALID_PARAM);
+    }
+    if (p_write_params->len > p_link->att_mtu - 3)
+    {
+        return sd_call(SD_CALL_WRITE, NRF_ERROR_DATA_SIZE);
+    }
+
+    switch (p_write_params->write_op)
+    {
+        case BLE_GATT_OP_WRITE_CMD:
+        {
+            host_write_cmd_t * p_cmd;
+
+            if (p_link->txq_count >= MIN(m_txq_size, HOST_TXQ_MAX))
+            {
+                return sd_call(SD_CALL_WRITE, NRF_ERROR_RESOURCES);
+            }
+            p_cmd         = &p_link->txq[(p_link->txq_start + p_link->txq_count++) % HOST_TXQ_MAX];
+            p_cmd->handle = p_write_params->handle;
+            p_cmd->len    = p_write_params->len;
+            p_cmd->value  = (p_write_params->len != 0) ? p_write_params->p_value[0] : 0;
+            return sd_call(SD_CALL_WRITE, NRF_SUCCESS);
+        }
+
+        case BLE_GATT_OP_WRITE_REQ:
+            err_code = att_request_check(p_link);
+            if (err_code != NRF_SUCCESS)
+            {
+                return sd_call(SD_CALL_WRITE, err_code);
+            }
+            att_request_start(p_link, ATT_OP_WRITE);
+            p_link->att_write_handle = p_write_params->handle;
+            p_link->att_write_value  = (p_write_params->len != 0) ? p_write_params->p_value[0] : 0;
+            return sd_call(SD_CALL_WRITE, NRF_SUCCESS);
+
+        default:
+            return sd_call(SD_CALL_WRITE, NRF_ERROR_NOT_SUPPORTED);
+    }
+}
+
+
+uint32_t sd_ble_uuid_vs_add(ble_uuid128_t const * p_vs_uuid, uint8_t * p_uuid_type)
+{
+    static uint8_t const lbs_base[] = LBS_UUID_BASE;
+    ble_uuid128_t        base;
+
+    if ((p_vs_uuid == NULL) || (p_uuid_type == NULL))
+    {
+        return sd_call(SD_CALL_UUID_VS_ADD, NRF_ERROR_INVALID_ADDR);
+    }
+
+    // Bytes 12 and 13 hold the 16-bit UUID, they are not part of the base.
+    base = *p_vs_uuid;
+    base.uuid128[12] = 0;
+    base.uuid128[13] = 0;
+    for (uint8_t i = 0; i < m_vs_uuid_count; i++)
+    {
+        if (memcmp(&m_vs_uuids[i], &base, sizeof(base)) == 0)
+        {
+            *p_uuid_type = BLE_UUID_TYPE_VENDOR_BEGIN + i;
+            return sd_call(SD_CALL_UUID_VS_ADD, NRF_SUCCESS);
+        }
+    }
+    if (m_vs_uuid_count == BLE_UUID_VS_COUNT_MAX)
+    {
+        return sd_call(SD_CALL_UUID_VS_ADD, NRF_ERROR_NO_MEM);
+    }
+
+    m_vs_uuids[m_vs_uuid_count] = base;
+    *p_uuid_type                = BLE_UUID_TYPE_VENDOR_BEGIN + m_vs_uuid_count++;
+    if (memcmp(base.uuid128, lbs_base, sizeof(lbs_base)) == 0)
+    {
+        m_lbs_uuid_type = *p_uuid_type;
+    }
+    return sd_call(SD_CALL_UUID_VS_ADD, NRF_SUCCESS);
+}
+
+
+uint32_t sd_ble_cfg_set(uint32_t cfg_id, ble_cfg_t const * p_cfg, uint32_t app_ram_base)
+{
+    UNUSED_PARAMETER(app_ram_base);
+    if (p_cfg == NULL)
+    {
+        return sd_call(SD_CALL_CFG_SET, NRF_ERROR_INVALID_ADDR);
+    }
+    if (m_ble_enabled)
+    {
+        return sd_call(SD_CALL_CFG_SET, NRF_ERROR_INVALID_STATE);
+    }
+    switch (cfg_id)
+    {
+        case BLE_CONN_CFG_GAP:
+            m_conn_cfg_tag = p_cfg->conn_cfg.conn_cfg_tag;
+            m_conn_count   = p_cfg->conn_cfg.params.gap_conn_cfg.conn_count;
+            break;
+
+        case BLE_CONN_CFG_GATT:
+            if (p_cfg->conn_cfg.params.gatt_conn_cfg.att_mtu < BLE_GATT_ATT_MTU_DEFAULT)
+            {
+                return sd_call(SD_CALL_CFG_SET, NRF_ERROR_INVALID_PARAM);
+            }
+            m_att_mtu = p_cfg->conn_cfg.params.gatt_conn_cfg.att_mtu;
+            break;
+
+        case BLE_CONN_CFG_GATTC:
+            if (p_cfg->conn_cfg.params.gattc_conn_cfg.write_cmd_tx_queue_size == 0)
+            {
+                return sd_call(SD_CALL_CFG_SET, NRF_ERROR_INVALID_PARAM);
+            }
+            m_txq_size = p_cfg->conn_cfg.params.gattc_conn_cfg.write_cmd_tx_queue_size;
+            break;
+
+        case BLE_COMMON_CFG_VS_UUID:
+            m_vs_uuid_cfg = p_cfg->common_cfg.vs_uuid_cfg.vs_uuid_count;
+            break;
+
+        default:
+            break;
+    }
+    return sd_call(SD_CALL_CFG_SET, NRF_SUCCESS);
+}
+
+
+/**@brief Function for estimating the RAM the SoftDevice needs for the configuration.
+ *
+ * @details The S132 figures are not published per buffer, so the constants are fitted to the
+ *          RAM starts the target logs: the context and the link layer buffers of every link,
+ *          sized by the data length, and its write command TX queue, sized by the ATT MTU.
+ */
+static uint32_t ram_required(void)
+{
+    uint32_t link = HOST_RAM_LINK
+                  + HOST_RAM_LL_BUFFERS * (NRF_SDH_BLE_GAP_DATA_LENGTH + HOST_RAM_LL_OVERHEAD)
+                  + m_att_mtu
+                  + m_txq_size * (m_att_mtu + HOST_RAM_TXQ_OVERHEAD);
+
+    return HOST_RAM_BASE + HOST_RAM_FIXED + m_vs_uuid_cfg * sizeof(ble_uuid128_t) + m_conn_count * link;
+}
+
+
+uint32_t sd_ble_enable(uint32_t * p_app_ram_base)
+{
+    uint32_t required = ram_required();
+    uint32_t err_code = NRF_SUCCESS;
+
+    if (!m_sd_enabled || m_ble_enabled)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if (*p_app_ram_base < required)
+    {
+        // nrf_sdh_ble logs this only with NRF_SDH_BLE_LOG_ENABLED.
+        printf("host: the SoftDevice needs RAM up to 0x%x, application RAM starts at 0x%x\n",
+               required, *p_app_ram_base);
+        err_code = NRF_ERROR_NO_MEM;
+    }
+    *p_app_ram_base = required;
+    m_ble_enabled   = (err_code == NRF_SUCCESS);
+    return err_code;
+}
+
+
+uint32_t sd_ble_opt_set(uint32_t opt_id, ble_opt_t const * p_opt)
+{
+    if (p_opt == NULL)
+    {
+        return sd_call(SD_CALL_OPT_SET, NRF_ERROR_INVALID_ADDR);
+    }
+    if (opt_id == BLE_COMMON_OPT_CONN_EVT_EXT)
+    {
+        m_conn_evt_ext = p_opt->common_opt.conn_evt_ext.enable;
+        return sd_call(SD_CALL_OPT_SET, NRF_SUCCESS);
+    }
+    return sd_call(SD_CALL_OPT_SET, NRF_ERROR_NOT_SUPPORTED);
+}
+
+
+/**@brief Function for computing the on-air time of a data packet, as main.c does. */
+static uint32_t pdu_airtime_us(uint8_t phy, uint32_t pdu_len)
+{
+    return (phy == BLE_GAP_PHY_2MBPS) ? ((2 + 4 + 2 + pdu_len + 3) * 4) : ((1 + 4 + 2 + pdu_len + 3) * 8);
+}
+
+
+/**@brief Function for applying an LED write on a peer.
+ *
+ * @details All links are written the same LED value per blink. The time from the first peer to
+ *          the last one that takes a value up is the blink spread, closed when the value changes.
+ *          A peer with echo notifies the value back on its button characteristic.
+ */
+static void peer_led_set(host_peer_t * p_peer, uint8_t value)
+{
+    uint64_t now  = host_now_us();
+    uint32_t peer = 1U << (p_peer - m_peers);
+
+    p_peer->led = value;
+    p_peer->led_writes++;
+    if (p_peer->cfg.echo && p_peer->cccd_enabled)
+    {
+        p_peer->button = value;
+        p_peer->notify_pending++;
+    }
+    if ((m_blink_peers == 0) || (value != m_blink_value))
+    {
+        // A blink counts once it reached two peers.
+        if ((m_blink_peers & (m_blink_peers - 1)) != 0)
+        {
+            m_blinks++;
+            m_blink_spread_total_us += m_blink_last_us - m_blink_first_us;
+            m_blink_spread_max_us    = MAX(m_blink_spread_max_us, m_blink_last_us - m_blink_first_us);
+        }
+        m_blink_value    = value;
+        m_blink_peers    = 0;
+        m_blink_first_us = now;
+    }
+    if ((m_blink_peers & peer) == 0)
+    {
+        m_blink_last_us = now;
+        m_blink_peers  |= peer;
+    }
+}
+
+
+/**@brief Function for handing the queued write commands of a link to the peer.
+ *
+ * @details Full length packets, each answered by an empty packet, fill the connection event:
+ *          NRF_SDH_BLE_GAP_EVENT_LENGTH, or the whole interval with connection event extension.
+ */
+static void link_txq_send(host_link_t * p_link)
+{
+    host_peer_t * p_peer   = p_link->p_peer;
+    uint32_t      event_us = m_conn_evt_ext ? ((uint32_t)p_link->params.max_conn_interval * UNIT_1_25_MS)
+                                            : (NRF_SDH_BLE_GAP_EVENT_LENGTH * UNIT_1_25_MS);
+    uint32_t      pair_us  = pdu_airtime_us(p_link->phy, p_link->data_length) + HOST_IFS_US +
+                             pdu_airtime_us(p_link->phy, 0) + HOST_IFS_US;
+    uint32_t      packets  = MAX(event_us / pair_us, 1);
+    uint8_t       sent     = 0;
+    ble_evt_t *   p_evt;
+
+    while (p_link->txq_count != 0)
+    {
+        host_write_cmd_t const * p_cmd     = &p_link->txq[p_link->txq_start];
+        // L2CAP header, ATT opcode and handle, then the value.
+        uint32_t                 fragments = CEIL_DIV(p_cmd->len + 4 + 3, p_link->data_length);
+
+        if (fragments > packets)
+        {
+            break;
+        }
+        packets -= fragments;
+        if ((p_cmd->handle == HOST_LBS_BASE_HANDLE + p_peer->handle_offset + 5) && p_peer->cfg.wwr && (p_cmd->len != 0))
+        {
+            peer_led_set(p_peer, p_cmd->value);
+        }
+        p_link->txq_start = (p_link->txq_start + 1) % HOST_TXQ_MAX;
+        p_link->txq_count--;
+        sent++;
+    }
+
+    if (sent == 0)
+    {
+        return;
+    }
+    p_evt = evt_alloc(BLE_GATTC_EVT_WRITE_CMD_TX_COMPLETE);
+    if (p_evt != NULL)
+    {
+        p_evt->header.evt_len                                  = HOST_EVT_LEN(gattc_evt.params.write_cmd_tx_complete);
+        p_evt->evt.gattc_evt.conn_handle                       = (uint16_t)(p_link - m_links);
+        p_evt->evt.gattc_evt.params.write_cmd_tx_complete.count = sent;
+    }
+}
+
+
+/**@brief Function for building the response of the peer to the ATT request of a link.
+ *
+ * @details Attributes of the LED Button service, from its base handle:
+ *          0 service, 1 Button declaration, 2 Button value, 3 Button CCCD,
+ *          4 LED declaration, 5 LED value.
+ */
+static void link_att_respond(host_link_t * p_link)
+{
+    host_peer_t *  p_peer      = p_link->p_peer;
+    uint16_t       base        = HOST_LBS_BASE_HANDLE + p_peer->handle_offset;
+    uint16_t       conn_handle = (uint16_t)(p_link - m_links);
+    ble_gattc_evt_t * p_gattc;
+    ble_evt_t *    p_evt;
+    att_op_t       op          = p_link->att_op;
+
+    p_link->att_op = ATT_OP_NONE;
+    switch (op)
+    {
+        case ATT_OP_MTU:
+            p_evt = evt_alloc(BLE_GATTC_EVT_EXCHANGE_MTU_RSP);
+            p_link->mtu_exchanged = true;
+            p_link->att_mtu       = MAX(MIN(p_link->att_client_mtu, p_peer->cfg.mtu), BLE_GATT_ATT_MTU_DEFAULT);
+            if (p_evt != NULL)
+            {
+                p_evt->header.evt_len                             = HOST_EVT_LEN(gattc_evt.params.exchange_mtu_rsp);
+                p_evt->evt.gattc_evt.params.exchange_mtu_rsp.server_rx_mtu = p_peer->cfg.mtu;
+            }
+            break;
+
+        case ATT_OP_PRIM:
+        {
+            bool match = p_peer->cfg.lbs && (p_link->att_range.start_handle <= base) &&
+                         (!p_link->att_uuid_valid ||
+                          ((p_link->att_uuid.type == m_lbs_uuid_type) && (p_link->att_uuid.uuid == LBS_UUID_SERVICE)));
+
+            p_evt = evt_alloc(BLE_GATTC_EVT_PRIM_SRVC_DISC_RSP);
+            if (p_evt == NULL)
+            {
+                break;
+            }
+            p_gattc = &p_evt->evt.gattc_evt;
+            p_evt->header.evt_len = (uint16_t)(offsetof(ble_evt_t, evt.gattc_evt.params.prim_srvc_disc_rsp.services) +
+                                               (match ? sizeof(ble_gattc_service_t) : 0));
+            if (!match)
+            {
+                p_gattc->gatt_status  = BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_FOUND;
+                p_gattc->error_handle = p_link->att_range.start_handle;
+                break;
+            }
+            p_gattc->params.prim_srvc_disc_rsp.count                                 = 1;
+            p_gattc->params.prim_srvc_disc_rsp.services[0].uuid.uuid                 = LBS_UUID_SERVICE;
+            p_gattc->params.prim_srvc_disc_rsp.services[0].uuid.type                 = m_lbs_uuid_type;
+            p_gattc->params.prim_srvc_disc_rsp.services[0].handle_range.start_handle = base;
+            p_gattc->params.prim_srvc_disc_rsp.services[0].handle_range.end_handle   = base + 5;
+        } break;
+
+        case ATT_OP_CHAR:
+        {
+            // A characteristic declaration with a 128-bit UUID takes 21 bytes of the response.
+            uint16_t         max_count = (uint16_t)((p_link->att_mtu - 2) / 21);
+            uint16_t         count     = 0;
+            ble_gattc_char_t chars[2];
+
+            if ((p_link->att_range.start_handle <= base + 1) && (p_link->att_range.end_handle >= base + 1))
+            {
+                chars[count++] = (ble_gattc_char_t){
+                    .uuid         = {.uuid = LBS_UUID_BUTTON_CHAR, .type = m_lbs_uuid_type},
+                    .char_props   = {.read = 1, .notify = 1},
+                    .handle_decl  = base + 1,
+                    .handle_value = base + 2,
+                };
+            }
+            if ((count < max_count) && (p_link->att_range.start_handle <= base + 4) && (p_link->att_range.end_handle >= base + 4))
+            {
+                chars[count++] = (ble_gattc_char_t){
+                    .uuid         = {.uuid = LBS_UUID_LED_CHAR, .type = m_lbs_uuid_type},
+                    .char_props   = {.read = 1, .write = 1, .write_wo_resp = p_peer->cfg.wwr},
+                    .handle_decl  = base + 4,
+                    .handle_value = base + 5,
+                };
+            }
+
+            p_evt = evt_alloc(BLE_GATTC_EVT_CHAR_DISC_RSP);
+            if (p_evt == NULL)
+            {
+                break;
+            }
+            p_gattc = &p_evt->evt.gattc_evt;
+            p_evt->header.evt_len = (uint16_t)(offsetof(ble_evt_t, evt.gattc_evt.params.char_disc_rsp.chars) +
+                                               count * sizeof(ble_gattc_char_t));
+            if (count == 0)
+            {
+                p_gattc->gatt_status  = BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_FOUND;
+                p_gattc->error_handle = p_link->att_range.start_handle;
+                break;
+            }
+            p_gattc->params.char_disc_rsp.count = count;
+            memcpy(p_gattc->params.char_disc_rsp.chars, chars, count * sizeof(ble_gattc_char_t));
+        } break;
+
+        case ATT_OP_DESC:
+        {
+            static uint16_t const uuids[] = {0x2800, 0x2803, LBS_UUID_BUTTON_CHAR, BLE_UUID_DESCRIPTOR_CLIENT_CHAR_CONFIG,
+                                             0x2803, LBS_UUID_LED_CHAR};
+            uint16_t max_count = (uint16_t)MIN((p_link->att_mtu - 2) / 4, ARRAY_SIZE(uuids));
+            uint16_t count     = 0;
+
+            p_evt = evt_alloc(BLE_GATTC_EVT_DESC_DISC_RSP);
+            if (p_evt == NULL)
+            {
+                break;
+            }
+            p_gattc = &p_evt->evt.gattc_evt;
+            for (uint16_t i = 0; (i < ARRAY_SIZE(uuids)) && (count < max_count); i++)
+            {
+                uint16_t handle = base + i;
+
+                if ((handle < p_link->att_range.start_handle) || (handle > p_link->att_range.end_handle))
+                {
+                    continue;
+                }
+                p_gattc->params.desc_disc_rsp.descs[count].handle    = handle;
+                p_gattc->params.desc_disc_rsp.descs[count].uuid.uuid = uuids[i];
+                p_gattc->params.desc_disc_rsp.descs[count].uuid.type = ((i == 2) || (i == 5)) ? m_lbs_uuid_type
+                                                                                              : BLE_UUID_TYPE_BLE;
+                count++;
+            }
+            p_evt->header.evt_len = (uint16_t)(offsetof(ble_evt_t, evt.gattc_evt.params.desc_disc_rsp.descs) +
+                                               count * sizeof(ble_gattc_desc_t));
+            p_gattc->params.desc_disc_rsp.count = count;
+            if (count == 0)
+            {
+                p_gattc->gatt_status  = BLE_GATT_STATUS_ATTERR_ATTRIBUTE_NOT_FOUND;
+                p_gattc->error_handle = p_link->att_range.start_handle;
+            }
+        } break;
+
+        case ATT_OP_WRITE:
+        {
+            uint16_t handle = p_link->att_write_handle;
+            uint16_t status = BLE_GATT_STATUS_SUCCESS;
+
+            if (handle == base + 5)
+            {
+                peer_led_set(p_peer, p_link->att_write_value);
+            }
+            else if (handle == base + 3)
+            {
+                p_peer->cccd_enabled = (p_link->att_write_value & 0x01) != 0;
+            }
+            else if ((handle >= base) && (handle <= base + 5))
+            {
+                status = BLE_GATT_STATUS_ATTERR_WRITE_NOT_PERMITTED;
+            }
+            else
+            {
+                status = BLE_GATT_STATUS_ATTERR_INVALID_HANDLE;
+            }
+
+            p_evt = evt_alloc(BLE_GATTC_EVT_WRITE_RSP);
+            if (p_evt == NULL)
+            {
+                break;
+            }
+            p_gattc = &p_evt->evt.gattc_evt;
+            p_evt->header.evt_len              = (uint16_t)offsetof(ble_evt_t, evt.gattc_evt.params.write_rsp.data);
+            p_gattc->gatt_status               = status;
+            p_gattc->error_handle              = (status == BLE_GATT_STATUS_SUCCESS) ? BLE_GATT_HANDLE_INVALID : handle;
+            p_gattc->params.write_rsp.handle   = handle;
+            p_gattc->params.write_rsp.write_op = BLE_GATT_OP_WRITE_REQ;
+        } break;
+
+        default:
+            p_evt = NULL;
+            break;
+    }
+
+    if (p_evt != NULL)
+    {
+        p_evt->evt.gattc_evt.conn_handle = conn_handle;
+    }
+}
+
+
+/**@brief Function for reaching the instant of the link layer procedure of a link. */
+static void link_proc_complete(host_link_t * p_link)
+{
+    uint16_t    conn_handle = (uint16_t)(p_link - m_links);
+    ble_evt_t * p_evt       = NULL;
+    ll_proc_t   proc        = p_link->proc;
+
+    p_link->proc = LL_PROC_NONE;
+    switch (proc)
+    {
+        case LL_PROC_PHY:
+            p_link->phy = p_link->proc_phy;
+            p_evt       = evt_alloc(BLE_GAP_EVT_PHY_UPDATE);
+            if (p_evt != NULL)
+            {
+                p_evt->header.evt_len                     = HOST_EVT_LEN(gap_evt.params.phy_update);
+                p_evt->evt.gap_evt.params.phy_update.status = BLE_HCI_STATUS_CODE_SUCCESS;
+                p_evt->evt.gap_evt.params.phy_update.tx_phy = p_link->phy;
+                p_evt->evt.gap_evt.params.phy_update.rx_phy = p_link->phy;
+            }
+            break;
+
+        case LL_PROC_DL:
+        {
+            ble_gap_data_length_params_t * p_params;
+
+            p_link->data_length = p_link->proc_dl;
+            p_evt               = evt_alloc(BLE_GAP_EVT_DATA_LENGTH_UPDATE);
+            if (p_evt == NULL)
+            {
+                break;
+            }
+            p_params                 = &p_evt->evt.gap_evt.params.data_length_update.effective_params;
+            p_evt->header.evt_len    = HOST_EVT_LEN(gap_evt.params.data_length_update);
+            p_params->max_tx_octets  = p_link->data_length;
+            p_params->max_rx_octets  = p_link->data_length;
+            p_params->max_tx_time_us = (uint16_t)((p_link->data_length + 14) * 8);
+            p_params->max_rx_time_us = (uint16_t)((p_link->data_length + 14) * 8);
+        } break;
+
+        case LL_PROC_CONN_PARAM:
+            p_link->params                   = p_link->proc_params;
+            p_link->params.min_conn_interval = p_link->params.max_conn_interval;
+            p_evt = evt_alloc(BLE_GAP_EVT_CONN_PARAM_UPDATE);
+            if (p_evt != NULL)
+            {
+                p_evt->header.evt_len                             = HOST_EVT_LEN(gap_evt.params.conn_param_update);
+                p_evt->evt.gap_evt.params.conn_param_update.conn_params = p_link->params;
+            }
+            break;
+
+        default:
+            // The application did not answer the request of the peer in time.
+            break;
+    }
+
+    if (p_evt != NULL)
+    {
+        p_evt->evt.gap_evt.conn_handle = conn_handle;
+    }
+}
+
+
+/**@brief Function for starting a procedure the feed asked the peer for, once the link is free for it. */
+static void link_peer_requests(host_link_t * p_link)
+{
+    host_peer_t * p_peer      = p_link->p_peer;
+    uint16_t      conn_handle = (uint16_t)(p_link - m_links);
+    ble_evt_t *   p_evt;
+
+    if (p_link->proc != LL_PROC_NONE)
+    {
+        return;
+    }
+    if (p_peer->conn_param_pending)
+    {
+        p_peer->conn_param_pending = false;
+        p_evt = evt_alloc(BLE_GAP_EVT_CONN_PARAM_UPDATE_REQUEST);
+        if (p_evt != NULL)
+        {
+            p_link->proc     = LL_PROC_PEER_CONN_PARAM;
+            p_link->proc_due = p_link->rx_events + HOST_LL_ANSWER_EVENTS;
+            p_evt->header.evt_len                                            = HOST_EVT_LEN(gap_evt.params.conn_param_update_request);
+            p_evt->evt.gap_evt.conn_handle                                   = conn_handle;
+            p_evt->evt.gap_evt.params.conn_param_update_request.conn_params  = p_peer->conn_param_req;
+        }
+    }
+    else if (p_peer->phy_pending)
+    {
+        p_peer->phy_pending = false;
+        p_evt = evt_alloc(BLE_GAP_EVT_PHY_UPDATE_REQUEST);
+        if (p_evt != NULL)
+        {
+            p_link->proc     = LL_PROC_PEER_PHY;
+            p_link->proc_due = p_link->rx_events + HOST_LL_ANSWER_EVENTS;
+            p_evt->header.evt_len                                        = HOST_EVT_LEN(gap_evt.params.phy_update_request);
+            p_evt->evt.gap_evt.conn_handle                               = conn_handle;
+            p_evt->evt.gap_evt.params.phy_update_request.peer_preferred_phys.tx_phys = p_peer->phy_req;
+            p_evt->evt.gap_evt.params.phy_update_request.peer_preferred_phys.rx_phys = p_peer->phy_req;
+        }
+    }
+}
+
+
+static int8_t peer_rssi_sample(host_peer_t const * p_peer)
+{
+    int32_t rssi = p_peer->cfg.rssi + host_rand_range(-(int32_t)p_peer->cfg.noise, p_peer->cfg.noise);
+
+    return (int8_t)MAX(MIN(rssi, 20), -127);
+}
+
+
+/**@brief Function for sampling the RSSI of a received packet and reporting a change. */
+static void link_rssi_sample(host_link_t * p_link)
+{
+    int8_t      rssi = peer_rssi_sample(p_link->p_peer);
+    ble_evt_t * p_evt;
+
+    p_link->rssi_last  = rssi;
+    p_link->rssi_valid = true;
+    p_link->ch_index   = (uint8_t)host_rand_range(0, 36);
+    if (!p_link->rssi_on)
+    {
+        return;
+    }
+    if (p_link->rssi_reported_valid && (abs(rssi - p_link->rssi_reported) < p_link->rssi_threshold))
+    {
+        p_link->rssi_over = 0;
+        return;
+    }
+    if (p_link->rssi_reported_valid && (++p_link->rssi_over < p_link->rssi_skip))
+    {
+        return;
+    }
+
+    p_link->rssi_over           = 0;
+    p_link->rssi_reported       = rssi;
+    p_link->rssi_reported_valid = true;
+    p_evt = evt_alloc(BLE_GAP_EVT_RSSI_CHANGED);
+    if (p_evt != NULL)
+    {
+        p_evt->header.evt_len                       = HOST_EVT_LEN(gap_evt.params.rssi_changed);
+        p_evt->evt.gap_evt.conn_handle              = (uint16_t)(p_link - m_links);
+        p_evt->evt.gap_evt.params.rssi_changed.rssi = rssi;
+        p_evt->evt.gap_evt.params.rssi_changed.ch_index = p_link->ch_index;
+    }
+}
+
+
+static void link_notify(host_link_t * p_link)
+{
+    host_peer_t * p_peer = p_link->p_peer;
+
+    for (; p_peer->notify_pending != 0; p_peer->notify_pending--)
+    {
+        ble_evt_t * p_evt = evt_alloc(BLE_GATTC_EVT_HVX);
+
+        if (p_evt == NULL)
+        {
+            continue;
+        }
+        p_evt->header.evt_len                  = (uint16_t)(offsetof(ble_evt_t, evt.gattc_evt.params.hvx.data) + 1);
+        p_evt->evt.gattc_evt.conn_handle       = (uint16_t)(p_link - m_links);
+        p_evt->evt.gattc_evt.params.hvx.handle = HOST_LBS_BASE_HANDLE + p_peer->handle_offset + 2;
+        p_evt->evt.gattc_evt.params.hvx.type   = BLE_GATT_HVX_NOTIFICATION;
+        p_evt->evt.gattc_evt.params.hvx.len    = 1;
+        p_evt->evt.gattc_evt.params.hvx.data[0] = p_peer->button;
+        p_peer->notifications++;
+    }
+}
+
+
+/**@brief Function for running one connection event of a link. */
+static void link_event(void * p_context, uint32_t generation)
+{
+    host_link_t * p_link = p_context;
+    host_peer_t * p_peer = p_link->p_peer;
+    uint64_t      now    = host_now_us();
+
+    if (!p_link->connected || (p_link->generation != generation))
+    {
+        return;
+    }
+    p_link->events++;
+    p_link->next_event_us += (uint64_t)p_link->params.max_conn_interval * UNIT_1_25_MS;
+
+    if (p_peer->silent || ((uint32_t)host_rand_range(0, 99) < p_peer->cfg.loss))
+    {
+        if ((p_link->rx_events == 0) && (p_link->events >= HOST_CONN_ESTABLISH_EVENTS))
+        {
+            link_drop(p_link, BLE_HCI_CONN_FAILED_TO_BE_ESTABLISHED);
+            return;
+        }
+        if (now - p_link->last_rx_us >= (uint64_t)p_link->params.conn_sup_timeout * UNIT_10_MS)
+        {
+            link_drop(p_link, BLE_HCI_CONNECTION_TIMEOUT);
+            return;
+        }
+        host_schedule(p_link->next_event_us, link_event, p_link, generation);
+        return;
+    }
+
+    p_link->last_rx_us = now;
+    p_link->rx_events++;
+    if (p_link->disconnecting)
+    {
+        link_drop(p_link, BLE_HCI_LOCAL_HOST_TERMINATED_CONNECTION);
+        return;
+    }
+    if (p_peer->disconnect_pending)
+    {
+        link_drop(p_link, p_peer->disconnect_reason);
+        return;
+    }
+
+    link_txq_send(p_link);
+    if ((p_link->att_op != ATT_OP_NONE) && (p_link->rx_events >= p_link->att_due))
+    {
+        link_att_respond(p_link);
+    }
+    if ((p_link->proc != LL_PROC_NONE) && (p_link->rx_events >= p_link->proc_due))
+    {
+        link_proc_complete(p_link);
+    }
+    link_peer_requests(p_link);
+    link_notify(p_link);
+    link_rssi_sample(p_link);
+
+    host_schedule(p_link->next_event_us, link_event, p_link, generation);
+}
+
+
+/**@brief Function for opening a link to a peer whose advertising packet the initiator caught. */
+static void link_establish(host_peer_t * p_peer)
+{
+    host_link_t * p_link = NULL;
+    ble_evt_t *   p_evt;
+    uint16_t      conn_handle;
+
+    for (uint32_t i = 0; i < HOST_LINK_COUNT; i++)
+    {
+        if (!m_links[i].connected)
+        {
+            p_link = &m_links[i];
+            break;
+        }
+    }
+    if (p_link == NULL)
+    {
+        return;
+    }
+    conn_handle = (uint16_t)(p_link - m_links);
+
+    window_stop(&m_initiator);
+    *p_link = (host_link_t){
+        .connected     = true,
+        .p_peer        = p_peer,
+        .params        = m_initiator_conn_params,
+        .generation    = p_link->generation + 1,
+        .last_rx_us    = host_now_us(),
+        .phy           = BLE_GAP_PHY_1MBPS,
+        .data_length   = BLE_GAP_DATA_LENGTH_DEFAULT,
+        .att_mtu       = BLE_GATT_ATT_MTU_DEFAULT,
+    };
+    p_link->params.min_conn_interval = p_link->params.max_conn_interval;
+    // First connection event after the transmit window offset.
+    p_link->next_event_us = host_now_us() + UNIT_1_25_MS + (uint64_t)host_rand_range(0, UNIT_1_25_MS);
+    host_schedule(p_link->next_event_us, link_event, p_link, p_link->generation);
+
+    p_peer->conn_handle  = conn_handle;
+    p_peer->cccd_enabled = false;
+    p_peer->connections++;
+    p_peer->adv_generation++;
+
+    p_evt = evt_alloc(BLE_GAP_EVT_CONNECTED);
+    if (p_evt != NULL)
+    {
+        ble_gap_evt_connected_t * p_connected = &p_evt->evt.gap_evt.params.connected;
+
+        p_evt->header.evt_len          = HOST_EVT_LEN(gap_evt.params.connected);
+        p_evt->evt.gap_evt.conn_handle = conn_handle;
+        p_connected->peer_addr         = p_peer->addr;
+        p_connected->role              = BLE_GAP_ROLE_CENTRAL;
+        p_connected->conn_params       = p_link->params;
+        p_connected->adv_handle        = 0xFF;
+    }
+    peer_latency_record(p_peer, HOST_LAT_CONNECTED);
+}
+
+
+/**@brief Function for building the advertising data of a peer: flags and the complete local name. */
+static uint16_t peer_adv_data(host_peer_t const * p_peer, uint8_t * p_data)
+{
+    uint16_t name_len = (uint16_t)MIN(strlen(p_peer->cfg.name), BLE_GAP_ADV_SET_DATA_SIZE_MAX - 5);
+
+    p_data[0] = 2;
+    p_data[1] = 0x01;                                   // Flags.
+    p_data[2] = 0x06;                                   // LE General Discoverable, BR/EDR not supported.
+    p_data[3] = (uint8_t)(name_len + 1);
+    p_data[4] = 0x09;                                   // Complete local name.
+    memcpy(&p_data[5], p_peer->cfg.name, name_len);
+    return (uint16_t)(5 + name_len);
+}
+
+
+/**@brief Function for building the scan response of a peer: the 128-bit UUID of the LED Button
+ *        service, or the 16-bit Battery service UUID for a peer without it. */
+static uint16_t peer_scan_rsp_data(host_peer_t const * p_peer, uint8_t * p_data)
+{
+    static uint8_t const base[] = LBS_UUID_BASE;
+
+    if (!p_peer->cfg.lbs)
+    {
+        p_data[0] = 3;
+        p_data[1] = 0x03;                               // Complete list of 16-bit service UUIDs.
+        p_data[2] = 0x0F;
+        p_data[3] = 0x18;
+        return 4;
+    }
+    p_data[0] = 17;
+    p_data[1] = 0x07;                                   // Complete list of 128-bit service UUIDs.
+    memcpy(&p_data[2], base, sizeof(base));
+    p_data[2 + 12] = (uint8_t)(LBS_UUID_SERVICE & 0xFF);
+    p_data[2 + 13] = (uint8_t)(LBS_UUID_SERVICE >> 8);
+    return 18;
+}
+
+
+static void peer_report(host_peer_t const * p_peer, bool scan_response)
+{
+    ble_evt_t *                p_evt = evt_alloc(BLE_GAP_EVT_ADV_REPORT);
+    ble_gap_evt_adv_report_t * p_report;
+
+    if (p_evt == NULL)
+    {
+        return;
+    }
+    p_report                     = &p_evt->evt.gap_evt.params.adv_report;
+    p_evt->header.evt_len        = HOST_EVT_LEN(gap_evt.params.adv_report);
+    p_evt->evt.gap_evt.conn_handle = BLE_CONN_HANDLE_INVALID;
+    p_report->type.connectable   = 1;
+    p_report->type.scannable     = 1;
+    p_report->type.scan_response = scan_response;
+    p_report->type.status        = BLE_GAP_ADV_DATA_STATUS_COMPLETE;
+    p_report->peer_addr          = p_peer->addr;
+    p_report->primary_phy        = BLE_GAP_PHY_1MBPS;
+    p_report->secondary_phy      = BLE_GAP_PHY_NOT_SET;
+    p_report->tx_power           = 127;
+    p_report->rssi               = peer_rssi_sample(p_peer);
+    p_report->ch_index           = (uint8_t)host_rand_range(37, 39);
+    p_report->set_id             = 0xFF;
+    evt_slot(p_evt)->data_len    = scan_response ? peer_scan_rsp_data(p_peer, evt_slot(p_evt)->data)
+                                                 : peer_adv_data(p_peer, evt_slot(p_evt)->data);
+    // The scanner waits for the application before the next report.
+    m_scanner_paused = true;
+}
+
+
+static void peer_scan_rsp(void * p_context, uint32_t generation)
+{
+    host_peer_t * p_peer = p_context;
+
+    if ((p_peer->adv_generation == generation) && !m_scanner_paused && window_listening(&m_scanner) &&
+        ((uint32_t)host_rand_range(0, 99) >= p_peer->cfg.loss))
+    {
+        peer_report(p_peer, true);
+    }
+}
+
+
+/**@brief Function for running one advertising event of a peer. */
+static void peer_adv_event(void * p_context, uint32_t generation)
+{
+    host_peer_t * p_peer = p_context;
+
+    if ((p_peer->adv_generation != generation) || !p_peer->advertising || p_peer->silent ||
+        (p_peer->conn_handle != BLE_CONN_HANDLE_INVALID))
+    {
+        return;
+    }
+    peer_adv_schedule(p_peer, (uint64_t)p_peer->cfg.adv_interval_ms * HOST_US_PER_MS +
+                              (uint64_t)host_rand_range(0, HOST_ADV_DELAY_MAX_US));
+
+    if ((uint32_t)host_rand_range(0, 99) < p_peer->cfg.loss)
+    {
+        return;
+    }
+    if (window_listening(&m_initiator) && (memcmp(&m_initiator_peer, &p_peer->addr, sizeof(ble_gap_addr_t)) == 0))
+    {
+        link_establish(p_peer);
+        return;
+    }
+    if (window_listening(&m_scanner) && !m_scanner_paused)
+    {
+        peer_report(p_peer, false);
+        if (m_scanner.params.active)
+        {
+            host_schedule(host_now_us() + HOST_SCAN_RSP_DELAY_US, peer_scan_rsp, p_peer, generation);
+        }
+    }
+}
+
+
+static void peer_adv_schedule(host_peer_t * p_peer, uint64_t delay_us)
+{
+    if (delay_us == 0)
+    {
+        // A new advertising set, the first event is anywhere in the first interval.
+        p_peer->adv_generation++;
+        delay_us = (uint64_t)host_rand_range(0, p_peer->cfg.adv_interval_ms * 1000);
+    }
+    host_schedule(host_now_us() + delay_us, peer_adv_event, p_peer, p_peer->adv_generation);
+}
+
+
+static host_peer_t * peer_get(uint32_t id)
+{
+    return ((id < HOST_PEER_MAX) && m_peers[id].declared) ? &m_peers[id] : NULL;
+}
+
+
+/**@brief Function for declaring a peer, or changing the configuration of a declared one. */
+bool host_peer_declare(uint32_t id, host_peer_cfg_t const * p_cfg)
+{
+    host_peer_t * p_peer;
+
+    if (id >= HOST_PEER_MAX)
+    {
+        return false;
+    }
+    p_peer = &m_peers[id];
+    if (!p_peer->declared)
+    {
+        memset(p_peer, 0, sizeof(*p_peer));
+        p_peer->declared       = true;
+        p_peer->id             = id;
+        p_peer->conn_handle    = BLE_CONN_HANDLE_INVALID;
+        p_peer->addr.addr_type = BLE_GAP_ADDR_TYPE_RANDOM_STATIC;
+        p_peer->addr.addr[0]   = (uint8_t)id;
+        p_peer->addr.addr[1]   = 0x5E;
+        p_peer->addr.addr[2]   = 0xB1;
+        p_peer->addr.addr[3]   = 0x1B;
+        p_peer->addr.addr[4]   = 0xED;
+        p_peer->addr.addr[5]   = 0xC0;                  // Two most significant bits set: random static.
+    }
+    p_peer->cfg = *p_cfg;
+    p_peer->cfg.name[sizeof(p_peer->cfg.name) - 1] = '\0';
+    p_peer->cfg.mtu = MAX(p_peer->cfg.mtu, BLE_GATT_ATT_MTU_DEFAULT);
+    p_peer->cfg.dl  = (uint8_t)MAX(p_peer->cfg.dl, BLE_GAP_DATA_LENGTH_DEFAULT);
+    p_peer->cfg.adv_interval_ms = MAX(p_peer->cfg.adv_interval_ms, 20);
+    return true;
+}
+
+
+bool host_peer_cfg_get(uint32_t id, host_peer_cfg_t * p_cfg)
+{
+    host_peer_t * p_peer = peer_get(id);
+
+    if (p_peer == NULL)
+    {
+        return false;
+    }
+    *p_cfg = p_peer->cfg;
+    return true;
+}
+
+
+bool host_peer_advertise(uint32_t id, bool on)
+{
+    host_peer_t * p_peer = peer_get(id);
+
+    if (p_peer == NULL)
+    {
+        return false;
+    }
+    peer_mark(p_peer);
+    if (on && !p_peer->advertising && !p_peer->silent && (p_peer->conn_handle == BLE_CONN_HANDLE_INVALID))
+    {
+        p_peer->advertising = true;
+        peer_adv_schedule(p_peer, 0);
+    }
+    p_peer->advertising = on;
+    return true;
+}
+
+
+bool host_peer_rssi_set(uint32_t id, int8_t rssi)
+{
+    host_peer_t * p_peer = peer_get(id);
+
+    if (p_peer == NULL)
+    {
+        return false;
+    }
+    p_peer->cfg.rssi = rssi;
+    peer_mark(p_peer);
+    return true;
+}
+
+
+bool host_peer_silent_set(uint32_t id, bool silent)
+{
+    host_peer_t * p_peer = peer_get(id);
+
+    if (p_peer == NULL)
+    {
+        return false;
+    }
+    if (!silent && p_peer->silent && p_peer->advertising && (p_peer->conn_handle == BLE_CONN_HANDLE_INVALID))
+    {
+        p_peer->silent = false;
+        peer_adv_schedule(p_peer, 0);
+    }
+    p_peer->silent = silent;
+    return true;
+}
+
+
+bool host_peer_disconnect(uint32_t id, uint8_t reason)
+{
+    host_peer_t * p_peer = peer_get(id);
+
+    if ((p_peer == NULL) || (p_peer->conn_handle == BLE_CONN_HANDLE_INVALID))
+    {
+        return false;
+    }
+    p_peer->disconnect_pending = true;
+    p_peer->disconnect_reason  = reason;
+    return true;
+}
+
+
+bool host_peer_conn_param_request(uint32_t id, ble_gap_conn_params_t const * p_params)
+{
+    host_peer_t * p_peer = peer_get(id);
+
+    if ((p_peer == NULL) || (p_peer->conn_handle == BLE_CONN_HANDLE_INVALID))
+    {
+        return false;
+    }
+    p_peer->conn_param_pending = true;
+    p_peer->conn_param_req     = *p_params;
+    return true;
+}
+
+
+bool host_peer_phy_request(uint32_t id, uint8_t phys)
+{
+    host_peer_t * p_peer = peer_get(id);
+
+    if ((p_peer == NULL) || (p_peer->conn_handle == BLE_CONN_HANDLE_INVALID))
+    {
+        return false;
+    }
+    p_peer->phy_pending = true;
+    p_peer->phy_req     = phys;
+    return true;
+}
+
+
+bool host_peer_notify(uint32_t id, uint8_t value)
+{
+    host_peer_t * p_peer = peer_get(id);
+
+    if (p_peer == NULL)
+    {
+        return false;
+    }
+    p_peer->button = value;
+    if ((p_peer->conn_handle != BLE_CONN_HANDLE_INVALID) && p_peer->cccd_enabled)
+    {
+        p_peer->notify_pending++;
+    }
+    return true;
+}
+
+
+/**@brief Function for moving the GATT table of a peer, as a firmware update of the peer would. */
+bool host_peer_handles_move(uint32_t id, uint16_t offset)
+{
+    host_peer_t * p_peer = peer_get(id);
+
+    if (p_peer == NULL)
+    {
+        return false;
+    }
+    p_peer->handle_offset = offset;
+    p_peer->cccd_enabled  = false;
+    return true;
+}
+
+
+void host_sd_report(void)
+{
+    uint64_t now = host_now_us();
+
+    window_account(&m_scanner);
+    window_account(&m_initiator);
+    for (uint32_t id = 0; id < HOST_EVT_ID_COUNT; id++)
+    {
+        host_evt_stats_t const * p_stats = &m_evt_stats[id];
+
+        if (p_stats->count != 0)
+        {
+            printf("host: %-26s %8u events, observers mean %6llu ns, max %8llu ns\n", evt_name((uint16_t)id),
+                   p_stats->count, (unsigned long long)(p_stats->total_ns / p_stats->count),
+                   (unsigned long long)p_stats->max_ns);
+        }
+    }
+    if (m_evt_overflow != 0)
+    {
+        printf("host: %u events lost to a full event queue\n", m_evt_overflow);
+    }
+    for (uint32_t i = 0; i < SD_CALL_COUNT; i++)
+    {
+        if (m_sd_calls[i] != 0)
+        {
+            printf("host: %-38s %8u calls, %u refused\n", m_sd_call_names[i], m_sd_calls[i], m_sd_refused[i]);
+        }
+    }
+    if (now != 0)
+    {
+        printf("host: scanner radio on %llu.%llu %% of the time\n",
+               (unsigned long long)(m_radio_on_us * 100 / now), (unsigned long long)((m_radio_on_us * 1000 / now) % 10));
+    }
+    if (m_blinks != 0)
+    {
+        printf("host: LED blink spread over the peers mean %llu us, max %llu us, %u blinks\n",
+               (unsigned long long)(m_blink_spread_total_us / m_blinks), (unsigned long long)m_blink_spread_max_us,
+               m_blinks);
+    }
+    for (uint32_t i = 0; i < HOST_PEER_MAX; i++)
+    {
+        host_peer_t const * p_peer = &m_peers[i];
+
+        if (!p_peer->declared)
+        {
+            continue;
+        }
+        printf("host: peer %u \"%s\": %u reports, %u connections, %u LED writes, %u notifications\n",
+               i, p_peer->cfg.name, p_peer->reports, p_peer->connections, p_peer->led_writes, p_peer->notifications);
+        for (uint32_t type = 0; type < HOST_LAT_COUNT; type++)
+        {
+            host_lat_t const * p_lat = &p_peer->lat[type];
+
+            if (p_lat->count != 0)
+            {
+                printf("host: peer %u detect %-10s %4u times, mean %6llu us, max %6llu us\n", i, m_lat_names[type],
+                       p_lat->count, (unsigned long long)(p_lat->total_us / p_lat->count),
+                       (unsigned long long)p_lat->max_us);
+            }
+        }
+    }
+}
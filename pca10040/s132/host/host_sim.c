@@ -0,0 +1,424 @@
+/**
+ * @file
+ * @brief Host build: simulated time, the Cortex-M core and the peripheral register blocks.
+ *
+ * @details Every interrupt of the target is an action on a microsecond clock. The main loop of
+ *          the application calls nrf_pwr_mgmt_run() when it has nothing left to do; __WFE and
+ *          sd_app_evt_wait() end up in host_wfe(), which runs the earliest action and the
+ *          interrupt handlers it pended, then returns. Time only moves there, so the application
+ *          code between two wake-ups takes no simulated time. Interrupts never preempt the code
+ *          that runs, like on the target with every handler at one priority.
+ *
+ *          The register blocks the SDK modules touch directly are mapped at their nRF52832
+ *          addresses: FICR, the peripherals from POWER to PPI and P0.
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include "boards.h"
+#include "nrf.h"
+#include "nrf_log_ctrl.h"
+#include "nrf_sdh.h"
+#include "host.h"
+
+#define HOST_PIN_COUNT                  32
+#define HOST_REG_SET(reg, value)        (*(volatile uint32_t *)&(reg) = (value))   /**< Write to a read-only register, from the hardware side. */
+
+/**@brief Register block mapped at its address on the target. */
+typedef struct
+{
+    uintptr_t base;
+    size_t    size;
+} host_region_t;
+
+/**@brief Pending action. */
+typedef struct
+{
+    uint64_t      at_us;
+    uint64_t      seq;                              /**< Insertion order, keeps actions of the same time in order. */
+    host_action_t action;
+    void *        p_context;
+    uint32_t      arg;
+} host_action_entry_t;
+
+/**@brief Interrupt handler of a vector the simulation pends through the NVIC. */
+typedef struct
+{
+    IRQn_Type irq;
+    void   (* handler)(void);
+} host_vector_t;
+
+extern void SWI2_EGU2_IRQHandler(void);
+
+bool            host_quiet;
+uint64_t        host_end_us = UINT64_MAX;
+host_nvic_t     host_nvic;
+NVIC_Type       host_nvic_regs;
+SCB_Type        host_scb;
+CoreDebug_Type  host_core_debug;
+
+static host_region_t const m_regions[] =
+{
+    {NRF_FICR_BASE,  0x1000},
+    {NRF_POWER_BASE, 0x20000},                      /**< POWER to PPI, every APB peripheral. */
+    {NRF_P0_BASE,    0x1000},
+};
+
+static host_vector_t const m_vectors[] =
+{
+    {SWI2_EGU2_IRQn, SWI2_EGU2_IRQHandler},         /**< SoftDevice events, nrf_sdh.c. */
+};
+
+static uint64_t              m_now_us;
+static uint64_t              m_seq;
+static host_action_entry_t * m_actions;
+static uint32_t              m_action_count;
+static uint32_t              m_action_size;
+static uint32_t              m_wakeups;
+static uint32_t              m_interrupts;
+static uint32_t              m_rand_state = 1;
+static uint64_t              m_wall_start_ns;
+static bool                  m_pins[HOST_PIN_COUNT];
+static uint32_t              m_pin_switches[HOST_PIN_COUNT];
+
+
+/**@brief Function for mapping the register blocks and setting the idle pin levels. */
+void host_sim_init(void)
+{
+    for (uint32_t i = 0; i < ARRAY_SIZE(m_regions); i++)
+    {
+        void * p_block = mmap((void *)m_regions[i].base, m_regions[i].size, PROT_READ | PROT_WRITE,
+                              MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0);
+
+        if (p_block != (void *)m_regions[i].base)
+        {
+            fprintf(stderr, "host: cannot map the registers at 0x%08lx\n", (unsigned long)m_regions[i].base);
+            exit(2);
+        }
+    }
+    HOST_REG_SET(NRF_FICR->INFO.PART, FICR_INFO_PART_PART_N52832);
+    HOST_REG_SET(NRF_FICR->INFO.RAM, FICR_INFO_RAM_RAM_K64);
+    HOST_REG_SET(NRF_FICR->INFO.FLASH, FICR_INFO_FLASH_FLASH_K512);
+
+    // BUTTON_PULL keeps an idle button at its inactive level.
+    for (uint32_t i = 0; i < BUTTONS_NUMBER; i++)
+    {
+        host_pin_set(bsp_board_button_idx_to_pin(i), BUTTONS_ACTIVE_STATE ? false : true);
+    }
+    m_wall_start_ns = host_ns();
+}
+
+
+/**@brief Function for reading the host monotonic clock in nanoseconds. */
+uint64_t host_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+uint64_t host_now_us(void)
+{
+    return m_now_us;
+}
+
+
+void host_seed(uint32_t seed)
+{
+    m_rand_state = (seed == 0) ? 1 : seed;
+}
+
+
+/**@brief Function for drawing a pseudo-random number, xorshift32 so runs repeat per seed. */
+uint32_t host_rand(void)
+{
+    m_rand_state ^= m_rand_state << 13;
+    m_rand_state ^= m_rand_state >> 17;
+    m_rand_state ^= m_rand_state << 5;
+    return m_rand_state;
+}
+
+
+int32_t host_rand_range(int32_t min, int32_t max)
+{
+    if (max <= min)
+    {
+        return min;
+    }
+    return min + (int32_t)(host_rand() % (uint32_t)(max - min + 1));
+}
+
+
+static bool action_before(host_action_entry_t const * p_a, host_action_entry_t const * p_b)
+{
+    return (p_a->at_us < p_b->at_us) || ((p_a->at_us == p_b->at_us) && (p_a->seq < p_b->seq));
+}
+
+
+/**@brief Function for queuing an action, a time in the past runs it at the next wake-up. */
+void host_schedule(uint64_t at_us, host_action_t action, void * p_context, uint32_t arg)
+{
+    uint32_t i;
+
+    if (m_action_count == m_action_size)
+    {
+        m_action_size = (m_action_size == 0) ? 256 : (m_action_size * 2);
+        m_actions     = realloc(m_actions, m_action_size * sizeof(host_action_entry_t));
+        if (m_actions == NULL)
+        {
+            fprintf(stderr, "host: out of memory\n");
+            exit(1);
+        }
+    }
+
+    i = m_action_count++;
+    m_actions[i] = (host_action_entry_t){
+        .at_us     = (at_us < m_now_us) ? m_now_us : at_us,
+        .seq       = m_seq++,
+        .action    = action,
+        .p_context = p_context,
+        .arg       = arg,
+    };
+    while (i > 0)
+    {
+        uint32_t            parent = (i - 1) / 2;
+        host_action_entry_t tmp;
+
+        if (!action_before(&m_actions[i], &m_actions[parent]))
+        {
+            break;
+        }
+        tmp                = m_actions[parent];
+        m_actions[parent]  = m_actions[i];
+        m_actions[i]       = tmp;
+        i                  = parent;
+    }
+}
+
+
+static host_action_entry_t action_pop(void)
+{
+    host_action_entry_t top = m_actions[0];
+    uint32_t            i   = 0;
+
+    m_actions[0] = m_actions[--m_action_count];
+    for (;;)
+    {
+        uint32_t            left     = 2 * i + 1;
+        uint32_t            right    = left + 1;
+        uint32_t            smallest = i;
+        host_action_entry_t tmp;
+
+        if ((left < m_action_count) && action_before(&m_actions[left], &m_actions[smallest]))
+        {
+            smallest = left;
+        }
+        if ((right < m_action_count) && action_before(&m_actions[right], &m_actions[smallest]))
+        {
+            smallest = right;
+        }
+        if (smallest == i)
+        {
+            break;
+        }
+        tmp                 = m_actions[smallest];
+        m_actions[smallest] = m_actions[i];
+        m_actions[i]        = tmp;
+        i                   = smallest;
+    }
+    return top;
+}
+
+
+/**@brief Function for running the handlers of the pending, enabled interrupts by priority.
+ *
+ * @return true if a handler ran.
+ */
+static bool irq_deliver(void)
+{
+    bool delivered = false;
+
+    while (host_nvic.primask == 0)
+    {
+        host_vector_t const * p_next = NULL;
+        uint32_t              ipsr   = host_nvic.ipsr;
+
+        for (uint32_t i = 0; i < ARRAY_SIZE(m_vectors); i++)
+        {
+            IRQn_Type irq = m_vectors[i].irq;
+
+            if (host_nvic.pending[irq] && host_nvic.enabled[irq] &&
+                ((p_next == NULL) || (host_nvic.priority[irq] < host_nvic.priority[p_next->irq])))
+            {
+                p_next = &m_vectors[i];
+            }
+        }
+        if (p_next == NULL)
+        {
+            break;
+        }
+        host_nvic.pending[p_next->irq] = false;
+        host_nvic.ipsr                 = (uint32_t)p_next->irq + 16;
+        p_next->handler();
+        host_nvic.ipsr                 = ipsr;
+        m_interrupts++;
+        delivered = true;
+    }
+    return delivered;
+}
+
+
+/**@brief Function for sleeping until the next event of the simulation.
+ *
+ * @details Runs the pending interrupts, or else the earliest action and the interrupts it
+ *          pended. Reaching the end time ends the process with the report.
+ */
+void host_wfe(void)
+{
+    host_action_entry_t next;
+
+    if (irq_deliver())
+    {
+        return;
+    }
+    if ((m_action_count == 0) || (m_actions[0].at_us >= host_end_us))
+    {
+        if (host_end_us != UINT64_MAX)
+        {
+            m_now_us = host_end_us;
+        }
+        host_finish();
+    }
+
+    next     = action_pop();
+    m_now_us = MAX(m_now_us, next.at_us);
+    m_wakeups++;
+    next.action(next.p_context, next.arg);
+    (void)irq_deliver();
+}
+
+
+void host_reset(void)
+{
+    printf("host: NVIC_SystemReset at %llu us\n", (unsigned long long)m_now_us);
+    host_finish();
+}
+
+
+/**@brief Function for reading the DWT block, CYCCNT follows the host clock in nanoseconds.
+ *
+ * @details A value written by the application since the last read restarts the count from it.
+ */
+DWT_Type * host_dwt(void)
+{
+    static DWT_Type dwt;
+    static uint32_t shadow;
+    static uint64_t base_ns;
+    uint64_t        now = host_ns();
+
+    if (dwt.CYCCNT != shadow)
+    {
+        base_ns = now - dwt.CYCCNT;
+    }
+    if ((dwt.CTRL & DWT_CTRL_CYCCNTENA_Msk) && (host_core_debug.DEMCR & CoreDebug_DEMCR_TRCENA_Msk))
+    {
+        dwt.CYCCNT = (uint32_t)(now - base_ns);
+    }
+    else
+    {
+        base_ns = now - dwt.CYCCNT;
+    }
+    shadow = dwt.CYCCNT;
+    return &dwt;
+}
+
+
+/**@brief Function for driving a pin, the level shows in OUT and IN of P0 and reaches GPIOTE. */
+void host_pin_set(uint32_t pin, bool level)
+{
+    if ((pin >= HOST_PIN_COUNT) || (m_pins[pin] == level))
+    {
+        return;
+    }
+    m_pins[pin] = level;
+    m_pin_switches[pin]++;
+    if (level)
+    {
+        NRF_P0->OUT |= 1UL << pin;
+        HOST_REG_SET(NRF_P0->IN, NRF_P0->IN | (1UL << pin));
+    }
+    else
+    {
+        NRF_P0->OUT &= ~(1UL << pin);
+        HOST_REG_SET(NRF_P0->IN, NRF_P0->IN & ~(1UL << pin));
+    }
+    host_gpiote_pin_changed(pin, level);
+}
+
+
+bool host_pin_get(uint32_t pin)
+{
+    return (pin < HOST_PIN_COUNT) && m_pins[pin];
+}
+
+
+static void button_level(void * p_context, uint32_t arg)
+{
+    UNUSED_PARAMETER(p_context);
+    host_pin_set(arg & 0xFF, (arg >> 8) != 0);
+}
+
+
+/**@brief Function for pressing a board button, app_button sees the pin change through GPIOTE. */
+void host_button_press(uint32_t button, uint32_t hold_ms)
+{
+    uint32_t pin;
+
+    if (button >= BUTTONS_NUMBER)
+    {
+        return;
+    }
+    pin = bsp_board_button_idx_to_pin(button);
+    host_schedule(m_now_us, button_level, NULL, pin | ((BUTTONS_ACTIVE_STATE ? 1U : 0U) << 8));
+    host_schedule(m_now_us + hold_ms * HOST_US_PER_MS, button_level, NULL,
+                  pin | ((BUTTONS_ACTIVE_STATE ? 0U : 1U) << 8));
+}
+
+
+void host_sim_report(void)
+{
+    uint64_t wall_ns = host_ns() - m_wall_start_ns;
+
+    printf("host: %llu.%03llu s simulated in %llu.%03llu ms, %u wake-ups, %u interrupts\n",
+           (unsigned long long)(m_now_us / 1000000), (unsigned long long)((m_now_us / 1000) % 1000),
+           (unsigned long long)(wall_ns / 1000000), (unsigned long long)((wall_ns / 1000) % 1000),
+           m_wakeups, m_interrupts);
+    for (uint32_t i = 0; i < LEDS_NUMBER; i++)
+    {
+        uint32_t pin = bsp_board_led_idx_to_pin(i);
+
+        printf("host: LED %u switched %u times\n", i, m_pin_switches[pin]);
+    }
+}
+
+
+/**@brief Function for ending the run: flush the log, print the report and exit. */
+void host_finish(void)
+{
+    host_log_report();
+    host_sim_report();
+    host_sched_report();
+    host_timer_report();
+    host_gpiote_report();
+    host_ppi_report();
+    host_rtt_report();
+    host_sd_report();
+    fflush(stdout);
+    exit(0);
+}
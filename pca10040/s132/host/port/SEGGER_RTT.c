@@ -0,0 +1,112 @@
+/**
+ * @file
+ * @brief Host build: RTT up channels on files, in place of external/segger_rtt/SEGGER_RTT.c.
+ *
+ * @details The SEGGER module keeps its ring buffers in RAM for a debugger to read over SWD.
+ *          Channel 0 carries the log, which the host logger prints itself. Channel 1 carries the
+ *          BLE_EVT_CAPTURE_ENABLED records; they are converted to the target event layout and
+ *          written to the file given with --capture, so the tools read the same records as
+ *          from a board.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "sdk_common.h"
+#include "nrf_sdh_ble.h"
+#include "SEGGER_RTT.h"
+#include "host.h"
+
+#define HOST_RTT_CAPTURE_CHANNEL        1                       /**< Up channel written to the capture file. */
+
+static FILE *   m_capture;
+static uint32_t m_capture_records;
+static uint32_t m_capture_skipped;
+
+
+void SEGGER_RTT_Init(void)
+{
+}
+
+
+int SEGGER_RTT_ConfigUpBuffer(unsigned BufferIndex, const char * sName, void * pBuffer,
+                              unsigned BufferSize, unsigned Flags)
+{
+    UNUSED_PARAMETER(sName);
+    UNUSED_PARAMETER(pBuffer);
+    UNUSED_PARAMETER(BufferSize);
+    UNUSED_PARAMETER(Flags);
+    return (BufferIndex < SEGGER_RTT_MAX_NUM_UP_BUFFERS) ? 0 : -1;
+}
+
+
+int SEGGER_RTT_ConfigDownBuffer(unsigned BufferIndex, const char * sName, void * pBuffer,
+                                unsigned BufferSize, unsigned Flags)
+{
+    UNUSED_PARAMETER(sName);
+    UNUSED_PARAMETER(pBuffer);
+    UNUSED_PARAMETER(BufferSize);
+    UNUSED_PARAMETER(Flags);
+    return (BufferIndex < SEGGER_RTT_MAX_NUM_DOWN_BUFFERS) ? 0 : -1;
+}
+
+
+unsigned SEGGER_RTT_Read(unsigned BufferIndex, void * pBuffer, unsigned BufferSize)
+{
+    UNUSED_PARAMETER(BufferIndex);
+    UNUSED_PARAMETER(pBuffer);
+    UNUSED_PARAMETER(BufferSize);
+    return 0;
+}
+
+
+unsigned SEGGER_RTT_WriteNoLock(unsigned BufferIndex, const void * pBuffer, unsigned NumBytes)
+{
+    uint8_t  record[2 * (sizeof(uint16_t) + sizeof(uint32_t) + NRF_SDH_BLE_EVT_BUF_SIZE + BLE_GAP_ADV_SET_DATA_SIZE_MAX)];
+    uint16_t len;
+
+    if ((BufferIndex != HOST_RTT_CAPTURE_CHANNEL) || (m_capture == NULL))
+    {
+        return NumBytes;
+    }
+    len = host_capture_to_target(pBuffer, (uint16_t)NumBytes, record, sizeof(record));
+    if (len == 0)
+    {
+        m_capture_skipped++;
+        return NumBytes;
+    }
+    if (fwrite(record, 1, len, m_capture) != len)
+    {
+        return 0;
+    }
+    m_capture_records++;
+    return NumBytes;
+}
+
+
+unsigned SEGGER_RTT_Write(unsigned BufferIndex, const void * pBuffer, unsigned NumBytes)
+{
+    return SEGGER_RTT_WriteNoLock(BufferIndex, pBuffer, NumBytes);
+}
+
+
+unsigned SEGGER_RTT_WriteString(unsigned BufferIndex, const char * s)
+{
+    return SEGGER_RTT_Write(BufferIndex, s, (unsigned)strlen(s));
+}
+
+
+bool host_capture_open(char const * p_path)
+{
+    m_capture = fopen(p_path, "wb");
+    return m_capture != NULL;
+}
+
+
+void host_rtt_report(void)
+{
+    if (m_capture != NULL)
+    {
+        printf("host: %u records captured, %u not converted\n", m_capture_records, m_capture_skipped);
+        fclose(m_capture);
+        m_capture = NULL;
+    }
+}
@@ -0,0 +1,67 @@
+/**
+ * @file
+ * @brief Host build: error and assert handlers, in place of util/app_error.c, app_error_weak.c and
+ *        the weak assert_nrf_callback() of util/nrf_assert.c.
+ *
+ * @details The SDK handlers pass the address of their error_info_t or assert_info_t to
+ *          app_error_fault_handler() in a uint32_t, which cuts a 64-bit pointer. These keep the
+ *          SDK flow but decode the information before the call. A fault flushes the log, prints
+ *          where it happened and aborts the run, so a debugger or a sanitizer stops on it.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include "sdk_common.h"
+#include "app_error.h"
+#include "nrf_assert.h"
+#include "nrf_log.h"
+#include "nrf_log_ctrl.h"
+#include "nrf_sdm.h"
+#include "nrf_strerror.h"
+#include "host.h"
+
+
+static void fault(char const * p_what, uint32_t line_num, uint8_t const * p_file_name)
+{
+    NRF_LOG_FINAL_FLUSH();
+    fflush(stdout);
+    fprintf(stderr, "host: %s at %s:%u, t = %llu us\n", p_what,
+            (p_file_name != NULL) ? (char const *)p_file_name : "?", line_num,
+            (unsigned long long)host_now_us());
+    abort();
+}
+
+
+void app_error_fault_handler(uint32_t id, uint32_t pc, uint32_t info)
+{
+    char what[64];
+
+    snprintf(what, sizeof(what), "fault 0x%x, pc 0x%x, info 0x%x", id, pc, info);
+    fault(what, 0, NULL);
+}
+
+
+void app_error_handler(ret_code_t error_code, uint32_t line_num, const uint8_t * p_file_name)
+{
+    char what[96];
+
+    snprintf(what, sizeof(what), "app_error 0x%x %s", error_code, nrf_strerror_get(error_code));
+    fault(what, line_num, p_file_name);
+}
+
+
+void app_error_handler_bare(ret_code_t error_code)
+{
+    app_error_handler(error_code, 0, NULL);
+}
+
+
+void app_error_save_and_stop(uint32_t id, uint32_t pc, uint32_t info)
+{
+    app_error_fault_handler(id, pc, info);
+}
+
+
+__WEAK void assert_nrf_callback(uint16_t line_num, const uint8_t * file_name)
+{
+    fault("assert", line_num, file_name);
+}
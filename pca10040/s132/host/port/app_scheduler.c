@@ -0,0 +1,139 @@
+/**
+ * @file
+ * @brief Host build: scheduler/app_scheduler.c with the event headers outside the event buffer.
+ *
+ * @details The SDK module keeps a handler pointer and a size per queue entry at the start of the
+ *          buffer of APP_SCHED_INIT, and checks that this header fits APP_SCHED_EVENT_HEADER_SIZE
+ *          (8 bytes). With 64-bit pointers it takes 16, so the headers live in an array of their
+ *          own here and the buffer keeps its target layout. The queue logic is the SDK one.
+ */
+#include "sdk_common.h"
+#include <string.h>
+#include "app_scheduler.h"
+#include "app_util_platform.h"
+#include "host.h"
+
+/**@brief Structure for holding a scheduled event header. */
+typedef struct
+{
+    app_sched_event_handler_t handler;              /**< Pointer to event handler to receive the event. */
+    uint16_t                  event_data_size;      /**< Size of event data. */
+} event_header_t;
+
+static event_header_t   m_queue_event_headers[UINT8_MAX + 1];   /**< The queue indexes are 8 bits wide. */
+static uint8_t        * m_queue_event_data;
+static volatile uint8_t m_queue_start_index;
+static volatile uint8_t m_queue_end_index;
+static uint16_t         m_queue_event_size;
+static uint16_t         m_queue_size;
+static uint16_t         m_peak_utilization;
+static uint32_t         m_refused;
+
+
+static uint8_t next_index(uint8_t index)
+{
+    return (index < m_queue_size) ? (index + 1) : 0;
+}
+
+
+static uint16_t utilization(void)
+{
+    uint16_t start = m_queue_start_index;
+    uint16_t end   = m_queue_end_index;
+
+    return (end >= start) ? (end - start) : (m_queue_size + 1 - start + end);
+}
+
+
+ret_code_t app_sched_init(uint16_t event_size, uint16_t queue_size, void * p_event_buffer)
+{
+    if (!is_word_aligned(p_event_buffer) || (queue_size > UINT8_MAX))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+
+    m_queue_event_data  = &((uint8_t *)p_event_buffer)[(queue_size + 1) * APP_SCHED_EVENT_HEADER_SIZE];
+    m_queue_end_index   = 0;
+    m_queue_start_index = 0;
+    m_queue_event_size  = event_size;
+    m_queue_size        = queue_size;
+    return NRF_SUCCESS;
+}
+
+
+uint16_t app_sched_queue_space_get(void)
+{
+    return m_queue_size - utilization();
+}
+
+
+uint16_t app_sched_queue_utilization_get(void)
+{
+    return m_peak_utilization;
+}
+
+
+uint32_t app_sched_event_put(void const *              p_event_data,
+                             uint16_t                  event_data_size,
+                             app_sched_event_handler_t handler)
+{
+    uint16_t event_index = 0xFFFF;
+
+    if (event_data_size > m_queue_event_size)
+    {
+        return NRF_ERROR_INVALID_LENGTH;
+    }
+
+    CRITICAL_REGION_ENTER();
+    if (next_index(m_queue_end_index) != m_queue_start_index)
+    {
+        event_index        = m_queue_end_index;
+        m_queue_end_index  = next_index(m_queue_end_index);
+        m_peak_utilization = MAX(m_peak_utilization, utilization());
+    }
+    else
+    {
+        m_refused++;
+    }
+    CRITICAL_REGION_EXIT();
+
+    if (event_index == 0xFFFF)
+    {
+        return NRF_ERROR_NO_MEM;
+    }
+
+    m_queue_event_headers[event_index].handler = handler;
+    if ((p_event_data != NULL) && (event_data_size > 0))
+    {
+        memcpy(&m_queue_event_data[event_index * m_queue_event_size], p_event_data, event_data_size);
+        m_queue_event_headers[event_index].event_data_size = event_data_size;
+    }
+    else
+    {
+        m_queue_event_headers[event_index].event_data_size = 0;
+    }
+    return NRF_SUCCESS;
+}
+
+
+void app_sched_execute(void)
+{
+    while (m_queue_end_index != m_queue_start_index)
+    {
+        uint16_t event_index = m_queue_start_index;
+
+        m_queue_event_headers[event_index].handler(&m_queue_event_data[event_index * m_queue_event_size],
+                                                   m_queue_event_headers[event_index].event_data_size);
+        m_queue_start_index = next_index(m_queue_start_index);
+    }
+}
+
+
+void host_sched_report(void)
+{
+    if (m_queue_size != 0)
+    {
+        printf("host: scheduler peak %u of %u events, %u puts refused\n",
+               m_peak_utilization, m_queue_size, m_refused);
+    }
+}
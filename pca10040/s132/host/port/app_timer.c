@@ -0,0 +1,163 @@
+/**
+ * @file
+ * @brief Host build: app_timer on the simulated RTC1 clock, in place of timer/app_timer.c.
+ *
+ * @details The SDK module cannot be built for the host: its timer node holds three pointers and
+ *          a STATIC_ASSERT checks it against APP_TIMER_NODE_SIZE, which only fits 32-bit
+ *          pointers. This node keeps the same 32 bytes. Every start schedules the expiry as an
+ *          action of the simulation, a stop or a new start makes the earlier one stale. The
+ *          handlers run from the RTC1 interrupt, APP_TIMER_CONFIG_USE_SCHEDULER is 0.
+ */
+#include "sdk_common.h"
+#include "app_timer.h"
+#include "host.h"
+
+#define HOST_RTC_FREQ                   (APP_TIMER_CLOCK_FREQ / (APP_TIMER_CONFIG_RTC_FREQUENCY + 1))
+#define HOST_RTC_TICKS_TO_US(ticks)     (((ticks) * 1000000ULL + HOST_RTC_FREQ - 1) / HOST_RTC_FREQ)
+#define HOST_US_TO_RTC_TICKS(us)        (((us) * HOST_RTC_FREQ) / 1000000ULL)
+
+/**@brief Timer node, stored in the app_timer_t of APP_TIMER_DEF. */
+typedef struct __attribute__((packed, aligned(4)))
+{
+    app_timer_timeout_handler_t handler;
+    void *                      p_context;
+    uint64_t                    expiry;             /**< Unwrapped RTC1 counter value of the next expiry. */
+    uint32_t                    period;
+    uint16_t                    generation;         /**< Makes the expiry of an earlier start stale. */
+    uint8_t                     mode;
+    uint8_t                     running;
+} timer_node_t;
+
+STATIC_ASSERT(sizeof(timer_node_t) <= APP_TIMER_NODE_SIZE);
+
+static bool m_initialized;
+
+
+/**@brief Function for reading the unwrapped RTC1 counter. */
+static uint64_t rtc_now(void)
+{
+    return HOST_US_TO_RTC_TICKS(host_now_us());
+}
+
+
+ret_code_t app_timer_init(void)
+{
+    m_initialized = true;
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t app_timer_create(app_timer_id_t const *      p_timer_id,
+                            app_timer_mode_t            mode,
+                            app_timer_timeout_handler_t timeout_handler)
+{
+    timer_node_t * p_node;
+
+    if (timeout_handler == NULL)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if ((p_timer_id == NULL) || (*p_timer_id == NULL))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    p_node = (timer_node_t *)*p_timer_id;
+    if (p_node->running)
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    p_node->handler = timeout_handler;
+    p_node->mode    = (uint8_t)mode;
+    return NRF_SUCCESS;
+}
+
+
+static void timer_expire(void * p_context, uint32_t generation)
+{
+    timer_node_t * p_node = p_context;
+
+    if (!p_node->running || (p_node->generation != (uint16_t)generation))
+    {
+        return;
+    }
+    if (p_node->mode == APP_TIMER_MODE_REPEATED)
+    {
+        p_node->expiry += p_node->period;
+        host_schedule(HOST_RTC_TICKS_TO_US(p_node->expiry), timer_expire, p_node, p_node->generation);
+    }
+    else
+    {
+        p_node->running = false;
+    }
+    p_node->handler(p_node->p_context);
+}
+
+
+ret_code_t app_timer_start(app_timer_id_t timer_id, uint32_t timeout_ticks, void * p_context)
+{
+    timer_node_t * p_node = (timer_node_t *)timer_id;
+
+    if (timeout_ticks < APP_TIMER_MIN_TIMEOUT_TICKS)
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    if (!m_initialized || (p_node == NULL) || (p_node->handler == NULL))
+    {
+        return NRF_ERROR_INVALID_STATE;
+    }
+    if (p_node->running)
+    {
+        // Starting a running timer is ignored, like the SDK module.
+        return NRF_SUCCESS;
+    }
+
+    p_node->running   = true;
+    p_node->p_context = p_context;
+    p_node->period    = timeout_ticks;
+    p_node->expiry    = rtc_now() + timeout_ticks;
+    p_node->generation++;
+    host_schedule(HOST_RTC_TICKS_TO_US(p_node->expiry), timer_expire, p_node, p_node->generation);
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t app_timer_stop(app_timer_id_t timer_id)
+{
+    timer_node_t * p_node = (timer_node_t *)timer_id;
+
+    if ((p_node == NULL) || (p_node->handler == NULL))
+    {
+        return NRF_ERROR_INVALID_PARAM;
+    }
+    p_node->running = false;
+    p_node->generation++;
+    return NRF_SUCCESS;
+}
+
+
+ret_code_t app_timer_stop_all(void)
+{
+    return NRF_ERROR_NOT_SUPPORTED;
+}
+
+
+uint32_t app_timer_cnt_get(void)
+{
+    return (uint32_t)(rtc_now() & APP_TIMER_MAX_CNT_VAL);
+}
+
+
+uint32_t app_timer_cnt_diff_compute(uint32_t ticks_to, uint32_t ticks_from)
+{
+    return (ticks_to - ticks_from) & APP_TIMER_MAX_CNT_VAL;
+}
+
+
+void app_timer_pause(void)
+{
+}
+
+
+void app_timer_resume(void)
+{
+}
@@ -0,0 +1,145 @@
+/**
+ * @file
+ * @brief Host build: board LEDs and buttons on the simulated pins, in place of boards/boards.c.
+ *
+ * @details The SDK module drives the LEDs through OUTSET/OUTCLR and reads them back from OUT,
+ *          which only works with the GPIO hardware behind the registers. This one keeps the
+ *          index to pin mapping and the active levels of the board header and goes through the
+ *          pin model of host_sim.c instead.
+ */
+#include "boards.h"
+#include "nrf_assert.h"
+#include "host.h"
+
+#if LEDS_NUMBER > 0
+static const uint8_t m_board_led_list[LEDS_NUMBER] = LEDS_LIST;
+#endif
+
+#if BUTTONS_NUMBER > 0
+static const uint8_t m_board_btn_list[BUTTONS_NUMBER] = BUTTONS_LIST;
+#endif
+
+
+#if LEDS_NUMBER > 0
+bool bsp_board_led_state_get(uint32_t led_idx)
+{
+    ASSERT(led_idx < LEDS_NUMBER);
+    return host_pin_get(m_board_led_list[led_idx]) == (LEDS_ACTIVE_STATE ? true : false);
+}
+
+
+void bsp_board_led_on(uint32_t led_idx)
+{
+    ASSERT(led_idx < LEDS_NUMBER);
+    host_pin_set(m_board_led_list[led_idx], LEDS_ACTIVE_STATE ? true : false);
+}
+
+
+void bsp_board_led_off(uint32_t led_idx)
+{
+    ASSERT(led_idx < LEDS_NUMBER);
+    host_pin_set(m_board_led_list[led_idx], LEDS_ACTIVE_STATE ? false : true);
+}
+
+
+void bsp_board_leds_off(void)
+{
+    for (uint32_t i = 0; i < LEDS_NUMBER; ++i)
+    {
+        bsp_board_led_off(i);
+    }
+}
+
+
+void bsp_board_leds_on(void)
+{
+    for (uint32_t i = 0; i < LEDS_NUMBER; ++i)
+    {
+        bsp_board_led_on(i);
+    }
+}
+
+
+void bsp_board_led_invert(uint32_t led_idx)
+{
+    ASSERT(led_idx < LEDS_NUMBER);
+    host_pin_set(m_board_led_list[led_idx], !host_pin_get(m_board_led_list[led_idx]));
+}
+
+
+uint32_t bsp_board_led_idx_to_pin(uint32_t led_idx)
+{
+    ASSERT(led_idx < LEDS_NUMBER);
+    return m_board_led_list[led_idx];
+}
+
+
+uint32_t bsp_board_pin_to_led_idx(uint32_t pin_number)
+{
+    uint32_t ret = 0xFFFFFFFF;
+
+    for (uint32_t i = 0; i < LEDS_NUMBER; ++i)
+    {
+        if (m_board_led_list[i] == pin_number)
+        {
+            ret = i;
+            break;
+        }
+    }
+    return ret;
+}
+#endif // LEDS_NUMBER > 0
+
+
+#if BUTTONS_NUMBER > 0
+bool bsp_board_button_state_get(uint32_t button_idx)
+{
+    ASSERT(button_idx < BUTTONS_NUMBER);
+    return host_pin_get(m_board_btn_list[button_idx]) == (BUTTONS_ACTIVE_STATE ? true : false);
+}
+
+
+uint32_t bsp_board_pin_to_button_idx(uint32_t pin_number)
+{
+    uint32_t ret = 0xFFFFFFFF;
+
+    for (uint32_t i = 0; i < BUTTONS_NUMBER; ++i)
+    {
+        if (m_board_btn_list[i] == pin_number)
+        {
+            ret = i;
+            break;
+        }
+    }
+    return ret;
+}
+
+
+uint32_t bsp_board_button_idx_to_pin(uint32_t button_idx)
+{
+    ASSERT(button_idx < BUTTONS_NUMBER);
+    return m_board_btn_list[button_idx];
+}
+#endif // BUTTONS_NUMBER > 0
+
+
+void bsp_board_init(uint32_t init_flags)
+{
+#if LEDS_NUMBER > 0
+    if (init_flags & BSP_INIT_LEDS)
+    {
+        bsp_board_leds_off();
+    }
+#endif
+
+#if BUTTONS_NUMBER > 0
+    if (init_flags & BSP_INIT_BUTTONS)
+    {
+        for (uint32_t i = 0; i < BUTTONS_NUMBER; ++i)
+        {
+            // BUTTON_PULL keeps an idle button at its inactive level.
+            host_pin_set(m_board_btn_list[i], BUTTONS_ACTIVE_STATE ? false : true);
+        }
+    }
+#endif
+}
@@ -0,0 +1,333 @@
+/**
+ * @file
+ * @brief Host build: Cortex-M4 core header in place of CMSIS core_cm4.h.
+ *
+ * @details nrf52.h includes this file after the IRQn_Type list, as on the target. The core
+ *          registers the SDK touches exist, but the NVIC state lives in host_nvic: the
+ *          SoftDevice critical region in nrf_nvic.h writes NVIC->ICER and NVIC->ISER directly,
+ *          which would need write-1-to-clear and write-1-to-set hardware behind them. These
+ *          writes land in a plain NVIC block and have no effect, which is safe because an
+ *          interrupt is only taken when the application sleeps in __WFE() or sd_app_evt_wait(),
+ *          never in the middle of thread code. DWT->CYCCNT follows the host clock.
+ */
+#ifndef HOST_CORE_CM4_H__
+#define HOST_CORE_CM4_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define __CORTEX_M                      (4U)
+#define __CM4_CMSIS_VERSION             ((5U << 16U) | 0U)
+
+#if defined(__FPU_PRESENT) && (__FPU_PRESENT == 1U)
+#define __FPU_USED                      1U
+#else
+#define __FPU_USED                      0U
+#endif
+
+#define __I                             volatile const
+#define __O                             volatile
+#define __IO                            volatile
+#define __IM                            volatile const
+#define __OM                            volatile
+#define __IOM                           volatile
+
+#ifndef __ASM
+#define __ASM                           __asm
+#endif
+#ifndef __INLINE
+#define __INLINE                        inline
+#endif
+#ifndef __STATIC_INLINE
+#define __STATIC_INLINE                 static inline
+#endif
+#ifndef __NO_RETURN
+#define __NO_RETURN                     __attribute__((__noreturn__))
+#endif
+#ifndef __USED
+#define __USED                          __attribute__((used))
+#endif
+#ifndef __WEAK
+#define __WEAK                          __attribute__((weak))
+#endif
+#ifndef __PACKED
+#define __PACKED                        __attribute__((packed))
+#endif
+#ifndef __ALIGNED
+#define __ALIGNED(x)                    __attribute__((aligned(x)))
+#endif
+
+#define HOST_IRQ_COUNT                  64                      /**< External interrupts of the nRF52832 NVIC, rounded up. */
+
+/**@brief Nested Vectored Interrupt Controller, as laid out on the target. */
+typedef struct
+{
+    __IOM uint32_t ISER[8U];
+          uint32_t RESERVED0[24U];
+    __IOM uint32_t ICER[8U];
+          uint32_t RESERVED1[24U];
+    __IOM uint32_t ISPR[8U];
+          uint32_t RESERVED2[24U];
+    __IOM uint32_t ICPR[8U];
+          uint32_t RESERVED3[24U];
+    __IOM uint32_t IABR[8U];
+          uint32_t RESERVED4[56U];
+    __IOM uint8_t  IP[240U];
+          uint32_t RESERVED5[644U];
+    __OM  uint32_t STIR;
+} NVIC_Type;
+
+/**@brief System Control Block. */
+typedef struct
+{
+    __IM  uint32_t CPUID;
+    __IOM uint32_t ICSR;
+    __IOM uint32_t VTOR;
+    __IOM uint32_t AIRCR;
+    __IOM uint32_t SCR;
+    __IOM uint32_t CCR;
+    __IOM uint8_t  SHP[12U];
+    __IOM uint32_t SHCSR;
+    __IOM uint32_t CFSR;
+    __IOM uint32_t HFSR;
+    __IOM uint32_t DFSR;
+    __IOM uint32_t MMFAR;
+    __IOM uint32_t BFAR;
+    __IOM uint32_t AFSR;
+    __IM  uint32_t PFR[2U];
+    __IM  uint32_t DFR;
+    __IM  uint32_t ADR;
+    __IM  uint32_t MMFR[4U];
+    __IM  uint32_t ISAR[5U];
+          uint32_t RESERVED0[5U];
+    __IOM uint32_t CPACR;
+} SCB_Type;
+
+/**@brief Data Watchpoint and Trace unit, the cycle counter part. */
+typedef struct
+{
+    __IOM uint32_t CTRL;
+    __IOM uint32_t CYCCNT;
+    __IOM uint32_t CPICNT;
+    __IOM uint32_t EXCCNT;
+    __IOM uint32_t SLEEPCNT;
+    __IOM uint32_t LSUCNT;
+    __IOM uint32_t FOLDCNT;
+    __IM  uint32_t PCSR;
+} DWT_Type;
+
+/**@brief Core Debug registers. */
+typedef struct
+{
+    __IOM uint32_t DHCSR;
+    __OM  uint32_t DCRSR;
+    __IOM uint32_t DCRDR;
+    __IOM uint32_t DEMCR;
+} CoreDebug_Type;
+
+/**@brief Interrupt state behind the NVIC_* functions, kept by host_sim.c. */
+typedef struct
+{
+    bool     enabled[HOST_IRQ_COUNT];
+    bool     pending[HOST_IRQ_COUNT];
+    uint8_t  priority[HOST_IRQ_COUNT];
+    uint32_t primask;
+    uint32_t ipsr;                                  /**< Exception number of the running handler, 0 in thread mode. */
+    bool     event;                                 /**< Event register of WFE/SEV. */
+} host_nvic_t;
+
+extern host_nvic_t    host_nvic;
+extern NVIC_Type      host_nvic_regs;
+extern SCB_Type       host_scb;
+extern CoreDebug_Type host_core_debug;
+
+DWT_Type * host_dwt(void);
+void       host_wfe(void);
+void       host_reset(void);
+
+#define NVIC                            (&host_nvic_regs)
+#define SCB                             (&host_scb)
+#define DWT                             (host_dwt())
+#define CoreDebug                       (&host_core_debug)
+
+#define IPSR_ISR_Pos                    0U
+#define IPSR_ISR_Msk                    (0x1FFUL << IPSR_ISR_Pos)
+#define CONTROL_nPRIV_Pos               0U
+#define CONTROL_nPRIV_Msk               (1UL << CONTROL_nPRIV_Pos)
+
+#define SCB_SCR_SEVONPEND_Pos           4U
+#define SCB_SCR_SEVONPEND_Msk           (1UL << SCB_SCR_SEVONPEND_Pos)
+#define SCB_SCR_SLEEPDEEP_Pos           2U
+#define SCB_SCR_SLEEPDEEP_Msk           (1UL << SCB_SCR_SLEEPDEEP_Pos)
+#define SCB_SCR_SLEEPONEXIT_Pos         1U
+#define SCB_SCR_SLEEPONEXIT_Msk         (1UL << SCB_SCR_SLEEPONEXIT_Pos)
+
+#define DWT_CTRL_CYCCNTENA_Pos          0U
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << DWT_CTRL_CYCCNTENA_Pos)
+#define CoreDebug_DEMCR_TRCENA_Pos      24U
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << CoreDebug_DEMCR_TRCENA_Pos)
+
+#define __NOP()                         __asm volatile ("nop")
+#define __ISB()                         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __DSB()                         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __DMB()                         __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define __BKPT(value)                   __builtin_trap()
+
+__STATIC_INLINE void __enable_irq(void)
+{
+    host_nvic.primask = 0;
+}
+
+__STATIC_INLINE void __disable_irq(void)
+{
+    host_nvic.primask = 1;
+}
+
+__STATIC_INLINE uint32_t __get_PRIMASK(void)
+{
+    return host_nvic.primask;
+}
+
+__STATIC_INLINE void __set_PRIMASK(uint32_t priMask)
+{
+    host_nvic.primask = priMask & 1U;
+}
+
+__STATIC_INLINE uint32_t __get_IPSR(void)
+{
+    return host_nvic.ipsr;
+}
+
+__STATIC_INLINE uint32_t __get_CONTROL(void)
+{
+    return 0;
+}
+
+__STATIC_INLINE uint32_t __get_FPSCR(void)
+{
+    return 0;
+}
+
+__STATIC_INLINE void __set_FPSCR(uint32_t fpscr)
+{
+    (void)fpscr;
+}
+
+/**@brief Function for sleeping until the next interrupt, see host_wfe(). */
+__STATIC_INLINE void __WFE(void)
+{
+    if (host_nvic.event)
+    {
+        host_nvic.event = false;
+        return;
+    }
+    host_wfe();
+}
+
+#define __WFI()                         __WFE()
+
+__STATIC_INLINE void __SEV(void)
+{
+    host_nvic.event = true;
+}
+
+__STATIC_INLINE uint32_t __REV(uint32_t value)
+{
+    return __builtin_bswap32(value);
+}
+
+__STATIC_INLINE uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+
+    for (uint32_t i = 0; i < 32; i++)
+    {
+        result = (result << 1) | ((value >> i) & 1U);
+    }
+    return result;
+}
+
+__STATIC_INLINE uint8_t __CLZ(uint32_t value)
+{
+    return (value == 0) ? 32U : (uint8_t)__builtin_clz(value);
+}
+
+__STATIC_INLINE bool host_irq_valid(IRQn_Type IRQn)
+{
+    return ((int32_t)IRQn >= 0) && ((int32_t)IRQn < HOST_IRQ_COUNT);
+}
+
+__STATIC_INLINE void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    if (host_irq_valid(IRQn))
+    {
+        host_nvic.enabled[IRQn] = true;
+    }
+}
+
+__STATIC_INLINE uint32_t NVIC_GetEnableIRQ(IRQn_Type IRQn)
+{
+    return host_irq_valid(IRQn) ? host_nvic.enabled[IRQn] : 0U;
+}
+
+__STATIC_INLINE void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    if (host_irq_valid(IRQn))
+    {
+        host_nvic.enabled[IRQn] = false;
+    }
+}
+
+__STATIC_INLINE uint32_t NVIC_GetPendingIRQ(IRQn_Type IRQn)
+{
+    return host_irq_valid(IRQn) ? host_nvic.pending[IRQn] : 0U;
+}
+
+__STATIC_INLINE void NVIC_SetPendingIRQ(IRQn_Type IRQn)
+{
+    if (host_irq_valid(IRQn))
+    {
+        host_nvic.pending[IRQn] = true;
+    }
+}
+
+__STATIC_INLINE void NVIC_ClearPendingIRQ(IRQn_Type IRQn)
+{
+    if (host_irq_valid(IRQn))
+    {
+        host_nvic.pending[IRQn] = false;
+    }
+}
+
+__STATIC_INLINE uint32_t NVIC_GetActive(IRQn_Type IRQn)
+{
+    return host_irq_valid(IRQn) && (host_nvic.ipsr == (uint32_t)IRQn + 16U);
+}
+
+__STATIC_INLINE void NVIC_SetPriority(IRQn_Type IRQn, uint32_t priority)
+{
+    if (host_irq_valid(IRQn))
+    {
+        host_nvic.priority[IRQn] = (uint8_t)(priority & ((1UL << __NVIC_PRIO_BITS) - 1UL));
+    }
+}
+
+__STATIC_INLINE uint32_t NVIC_GetPriority(IRQn_Type IRQn)
+{
+    return host_irq_valid(IRQn) ? host_nvic.priority[IRQn] : 0U;
+}
+
+__STATIC_INLINE void NVIC_SystemReset(void)
+{
+    host_reset();
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HOST_CORE_CM4_H__
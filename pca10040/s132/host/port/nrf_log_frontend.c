@@ -0,0 +1,317 @@
+/**
+ * @file
+ * @brief Host build: logger on stdout, in place of log/src/nrf_log_frontend.c, the string
+ *        formatter and the default backends.
+ *
+ * @details The SDK frontend stores every argument and the format string pointer in 32-bit words
+ *          of its ring buffer, which cuts a 64-bit pointer. This one keeps the same behavior with
+ *          machine words: NRF_LOG_BUFSIZE bounds the buffer in target words, NRF_LOG_ALLOW_OVERFLOW
+ *          drops the oldest entries, NRF_LOG_PROCESS() formats one entry, nrf_log_push() copies
+ *          a string to the push buffer. Without NRF_LOG_DEFERRED an entry is formatted in the
+ *          call. The build links with -no-pie, so the addresses of static data and string literals
+ *          fit the uint32_t arguments of the logger macros. Lines are prefixed with the simulated
+ *          time and printed in the layout of the RTT backend.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "sdk_common.h"
+#include "nrf_log.h"
+#include "nrf_log_ctrl.h"
+#include "nrf_log_default_backends.h"
+#include "nrf_log_internal.h"
+#include "host.h"
+
+NRF_LOG_MODULE_REGISTER();
+
+#define HOST_LOG_WORDS                  (NRF_LOG_BUFSIZE / 4)   /**< Capacity of the log buffer in target words. */
+#define HOST_LOG_HEADER_WORDS           2                       /**< Header words of a log entry on the target. */
+#define HOST_LOG_HEXDUMP_MAX            64                      /**< Bytes of a hexdump kept per entry. */
+
+/**@brief Deferred log entry. */
+typedef struct
+{
+    uint64_t     t_us;                              /**< Simulated time of the call. */
+    uint32_t     severity_mid;
+    char const * p_str;                             /**< Format string, NULL for a hexdump. */
+    uint32_t     nargs;
+    uintptr_t    args[NRF_LOG_MAX_NUM_OF_ARGS];
+    uint16_t     data_len;
+    uint8_t      data[HOST_LOG_HEXDUMP_MAX];
+} log_entry_t;
+
+static char const * const m_severity_names[] =
+{
+    [NRF_LOG_SEVERITY_ERROR]   = "error",
+    [NRF_LOG_SEVERITY_WARNING] = "warning",
+    [NRF_LOG_SEVERITY_INFO]    = "info",
+    [NRF_LOG_SEVERITY_DEBUG]   = "debug",
+};
+
+static log_entry_t m_log[HOST_LOG_WORDS / HOST_LOG_HEADER_WORDS];
+static uint32_t    m_start;
+static uint32_t    m_count;
+static uint32_t    m_words;
+static uint32_t    m_dropped;
+static bool        m_panic;
+static bool        m_line_start = true;
+static char        m_push_buffer[NRF_LOG_STR_PUSH_BUFFER_SIZE];
+static uint32_t    m_push_wr_idx;
+
+
+/**@brief Function for getting the name of a module from its index in the log_const_data section. */
+static char const * module_name_get(uint32_t module_id)
+{
+    // Address arithmetic, the section array has no size the compiler could check.
+    uintptr_t addr = (uintptr_t)NRF_SECTION_START_ADDR(log_const_data)
+                   + module_id * sizeof(nrf_log_module_const_data_t);
+
+    return ((nrf_log_module_const_data_t const *)addr)->p_module_name;
+}
+
+
+static uint32_t entry_words(log_entry_t const * p_entry)
+{
+    return HOST_LOG_HEADER_WORDS + p_entry->nargs + CEIL_DIV(p_entry->data_len, sizeof(uint32_t));
+}
+
+
+ret_code_t nrf_log_init(nrf_log_timestamp_func_t timestamp_func, uint32_t timestamp_freq)
+{
+    UNUSED_PARAMETER(timestamp_func);
+    UNUSED_PARAMETER(timestamp_freq);
+    return NRF_SUCCESS;
+}
+
+
+void nrf_log_default_backends_init(void)
+{
+}
+
+
+static void entry_print(log_entry_t const * p_entry)
+{
+    nrf_log_severity_t severity = (nrf_log_severity_t)(p_entry->severity_mid & NRF_LOG_LEVEL_MASK);
+    uint32_t           module   = p_entry->severity_mid >> NRF_LOG_MODULE_ID_POS;
+
+    if (m_line_start)
+    {
+        printf("[%5llu.%06llu] ", (unsigned long long)(p_entry->t_us / 1000000),
+               (unsigned long long)(p_entry->t_us % 1000000));
+    }
+    if ((severity != NRF_LOG_SEVERITY_INFO_RAW) && (severity < ARRAY_SIZE(m_severity_names)))
+    {
+        printf("<%s> %s: ", m_severity_names[severity], module_name_get(module));
+    }
+
+    if (p_entry->p_str == NULL)
+    {
+        for (uint32_t i = 0; i < p_entry->data_len; i++)
+        {
+            printf("%02x%s", p_entry->data[i], (i + 1 < p_entry->data_len) ? " " : "");
+        }
+        printf("\n");
+        m_line_start = true;
+        return;
+    }
+
+    // The arguments are machine words, as in the target logger. Extra ones are ignored.
+    printf(p_entry->p_str, p_entry->args[0], p_entry->args[1], p_entry->args[2],
+           p_entry->args[3], p_entry->args[4], p_entry->args[5]);
+    if (severity != NRF_LOG_SEVERITY_INFO_RAW)
+    {
+        printf("\n");
+        m_line_start = true;
+    }
+    else
+    {
+        size_t len = strlen(p_entry->p_str);
+
+        m_line_start = (len > 0) && (p_entry->p_str[len - 1] == '\n');
+    }
+}
+
+
+/**@brief Function for storing an entry, the oldest entries make room when the buffer is full. */
+static void entry_put(log_entry_t const * p_new)
+{
+    uint32_t words = entry_words(p_new);
+
+    if (host_quiet)
+    {
+        return;
+    }
+    if (m_panic || !NRF_LOG_DEFERRED)
+    {
+        // In place, as the SDK frontend does in panic mode or without NRF_LOG_DEFERRED.
+        entry_print(p_new);
+        return;
+    }
+    while ((m_words + words > HOST_LOG_WORDS) || (m_count == ARRAY_SIZE(m_log)))
+    {
+        if (!NRF_LOG_ALLOW_OVERFLOW || (m_count == 0))
+        {
+            m_dropped++;
+            return;
+        }
+        m_words -= entry_words(&m_log[m_start]);
+        m_start  = (m_start + 1) % ARRAY_SIZE(m_log);
+        m_count--;
+        m_dropped++;
+    }
+
+    m_log[(m_start + m_count) % ARRAY_SIZE(m_log)] = *p_new;
+    m_count++;
+    m_words += words;
+}
+
+
+static void std_n(uint32_t severity_mid, char const * const p_str, uint32_t nargs, uint32_t const * p_args)
+{
+    log_entry_t entry = {
+        .t_us         = host_now_us(),
+        .severity_mid = severity_mid,
+        .p_str        = p_str,
+        .nargs        = nargs,
+    };
+
+    for (uint32_t i = 0; i < nargs; i++)
+    {
+        entry.args[i] = p_args[i];
+    }
+    entry_put(&entry);
+}
+
+
+void nrf_log_frontend_std_0(uint32_t severity_mid, char const * const p_str)
+{
+    std_n(severity_mid, p_str, 0, NULL);
+}
+
+
+void nrf_log_frontend_std_1(uint32_t severity_mid, char const * const p_str, uint32_t val0)
+{
+    uint32_t args[] = {val0};
+
+    std_n(severity_mid, p_str, ARRAY_SIZE(args), args);
+}
+
+
+void nrf_log_frontend_std_2(uint32_t severity_mid, char const * const p_str, uint32_t val0, uint32_t val1)
+{
+    uint32_t args[] = {val0, val1};
+
+    std_n(severity_mid, p_str, ARRAY_SIZE(args), args);
+}
+
+
+void nrf_log_frontend_std_3(uint32_t severity_mid, char const * const p_str, uint32_t val0, uint32_t val1,
+                            uint32_t val2)
+{
+    uint32_t args[] = {val0, val1, val2};
+
+    std_n(severity_mid, p_str, ARRAY_SIZE(args), args);
+}
+
+
+void nrf_log_frontend_std_4(uint32_t severity_mid, char const * const p_str, uint32_t val0, uint32_t val1,
+                            uint32_t val2, uint32_t val3)
+{
+    uint32_t args[] = {val0, val1, val2, val3};
+
+    std_n(severity_mid, p_str, ARRAY_SIZE(args), args);
+}
+
+
+void nrf_log_frontend_std_5(uint32_t severity_mid, char const * const p_str, uint32_t val0, uint32_t val1,
+                            uint32_t val2, uint32_t val3, uint32_t val4)
+{
+    uint32_t args[] = {val0, val1, val2, val3, val4};
+
+    std_n(severity_mid, p_str, ARRAY_SIZE(args), args);
+}
+
+
+void nrf_log_frontend_std_6(uint32_t severity_mid, char const * const p_str, uint32_t val0, uint32_t val1,
+                            uint32_t val2, uint32_t val3, uint32_t val4, uint32_t val5)
+{
+    uint32_t args[] = {val0, val1, val2, val3, val4, val5};
+
+    std_n(severity_mid, p_str, ARRAY_SIZE(args), args);
+}
+
+
+void nrf_log_frontend_hexdump(uint32_t severity_mid, const void * const p_data, uint16_t length)
+{
+    log_entry_t entry = {
+        .t_us         = host_now_us(),
+        .severity_mid = severity_mid,
+        .data_len     = MIN(length, HOST_LOG_HEXDUMP_MAX),
+    };
+
+    memcpy(entry.data, p_data, entry.data_len);
+    entry_put(&entry);
+}
+
+
+/**@brief Function for copying a transient string, the copy lives until the push buffer wraps. */
+char const * nrf_log_push(char * const p_str)
+{
+    size_t len = strlen(p_str) + 1;
+    char * p_copy;
+
+    if (len > sizeof(m_push_buffer))
+    {
+        len = sizeof(m_push_buffer);
+    }
+    if (m_push_wr_idx + len > sizeof(m_push_buffer))
+    {
+        m_push_wr_idx = 0;
+    }
+    p_copy = &m_push_buffer[m_push_wr_idx];
+    memcpy(p_copy, p_str, len - 1);
+    p_copy[len - 1] = '\0';
+    m_push_wr_idx  += len;
+    return p_copy;
+}
+
+
+uint8_t nrf_log_getchar(void)
+{
+    return 0;
+}
+
+
+/**@brief Function for formatting the oldest entry.
+ *
+ * @return true if more entries are waiting.
+ */
+bool nrf_log_frontend_dequeue(void)
+{
+    if (m_count == 0)
+    {
+        return false;
+    }
+    entry_print(&m_log[m_start]);
+    m_words -= entry_words(&m_log[m_start]);
+    m_start  = (m_start + 1) % ARRAY_SIZE(m_log);
+    m_count--;
+    return m_count != 0;
+}
+
+
+void nrf_log_panic(void)
+{
+    m_panic = true;
+}
+
+
+/**@brief Function for flushing the log at the end of the run. */
+void host_log_report(void)
+{
+    NRF_LOG_FLUSH();
+    printf("%s", m_line_start ? "" : "\n");
+    if (m_dropped != 0)
+    {
+        printf("host: %u log entries lost to a full log buffer\n", m_dropped);
+    }
+}
@@ -0,0 +1,353 @@
+/**
+ * @file
+ * @brief Host build: GPIOTE driver on the simulated pins, in place of nrfx/drivers/src/nrfx_gpiote.c.
+ *
+ * @details The nrfx driver drives the pins through OUTSET/OUTCLR and the GPIOTE tasks and learns
+ *          about input changes from EVENTS_IN and EVENTS_PORT, which only work with the hardware
+ *          behind them. This one keeps the channel allocation and the API of the driver on top
+ *          of the pin model of host_sim.c. TASKS_OUT is reached by PPI through its register
+ *          address, an input change calls the handler like GPIOTE_IRQHandler.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "nrfx_gpiote.h"
+#include "host.h"
+
+#define HOST_GPIOTE_CH_COUNT            8
+#define HOST_GPIOTE_IN_COUNT            (HOST_GPIOTE_CH_COUNT + NRFX_GPIOTE_CONFIG_NUM_OF_LOW_POWER_EVENTS)
+#define HOST_GPIO_PIN_COUNT             32
+
+/**@brief Task channel of an output pin. */
+typedef struct
+{
+    bool                  used;
+    bool                  task_enabled;
+    nrfx_gpiote_pin_t     pin;
+    nrf_gpiote_polarity_t action;
+    uint32_t              tasks;
+} gpiote_out_t;
+
+/**@brief Event of an input pin, a channel or a port event. */
+typedef struct
+{
+    bool                      used;
+    bool                      enabled;
+    nrfx_gpiote_pin_t         pin;
+    nrf_gpiote_polarity_t     sense;
+    nrfx_gpiote_evt_handler_t handler;
+} gpiote_in_t;
+
+static nrfx_drv_state_t m_state;
+static gpiote_out_t     m_out[HOST_GPIOTE_CH_COUNT];
+static gpiote_in_t      m_in[HOST_GPIOTE_IN_COUNT];
+static bool             m_out_pins[HOST_GPIO_PIN_COUNT];
+
+
+static gpiote_out_t * out_find(nrfx_gpiote_pin_t pin)
+{
+    for (uint32_t i = 0; i < HOST_GPIOTE_CH_COUNT; i++)
+    {
+        if (m_out[i].used && (m_out[i].pin == pin))
+        {
+            return &m_out[i];
+        }
+    }
+    return NULL;
+}
+
+
+static gpiote_in_t * in_find(nrfx_gpiote_pin_t pin)
+{
+    for (uint32_t i = 0; i < HOST_GPIOTE_IN_COUNT; i++)
+    {
+        if (m_in[i].used && (m_in[i].pin == pin))
+        {
+            return &m_in[i];
+        }
+    }
+    return NULL;
+}
+
+
+nrfx_err_t nrfx_gpiote_init(void)
+{
+    if (m_state != NRFX_DRV_STATE_UNINITIALIZED)
+    {
+        return NRFX_ERROR_INVALID_STATE;
+    }
+    memset(m_out, 0, sizeof(m_out));
+    memset(m_in, 0, sizeof(m_in));
+    memset(m_out_pins, 0, sizeof(m_out_pins));
+    m_state = NRFX_DRV_STATE_INITIALIZED;
+    return NRFX_SUCCESS;
+}
+
+
+bool nrfx_gpiote_is_init(void)
+{
+    return m_state != NRFX_DRV_STATE_UNINITIALIZED;
+}
+
+
+void nrfx_gpiote_uninit(void)
+{
+    NRFX_ASSERT(m_state != NRFX_DRV_STATE_UNINITIALIZED);
+    m_state = NRFX_DRV_STATE_UNINITIALIZED;
+}
+
+
+nrfx_err_t nrfx_gpiote_out_init(nrfx_gpiote_pin_t pin, nrfx_gpiote_out_config_t const * p_config)
+{
+    NRFX_ASSERT(pin < HOST_GPIO_PIN_COUNT);
+    NRFX_ASSERT(m_state == NRFX_DRV_STATE_INITIALIZED);
+
+    if (m_out_pins[pin] || (in_find(pin) != NULL))
+    {
+        return NRFX_ERROR_INVALID_STATE;
+    }
+    if (p_config->task_pin)
+    {
+        gpiote_out_t * p_out = NULL;
+
+        for (uint32_t i = 0; (i < HOST_GPIOTE_CH_COUNT) && (p_out == NULL); i++)
+        {
+            p_out = m_out[i].used ? NULL : &m_out[i];
+        }
+        if (p_out == NULL)
+        {
+            return NRFX_ERROR_NO_MEM;
+        }
+        *p_out = (gpiote_out_t){
+            .used   = true,
+            .pin    = pin,
+            .action = p_config->action,
+        };
+    }
+    m_out_pins[pin] = true;
+    host_pin_set(pin, p_config->init_state == NRF_GPIOTE_INITIAL_VALUE_HIGH);
+    return NRFX_SUCCESS;
+}
+
+
+void nrfx_gpiote_out_uninit(nrfx_gpiote_pin_t pin)
+{
+    gpiote_out_t * p_out = out_find(pin);
+
+    if (p_out != NULL)
+    {
+        p_out->used = false;
+    }
+    m_out_pins[pin] = false;
+}
+
+
+void nrfx_gpiote_out_set(nrfx_gpiote_pin_t pin)
+{
+    NRFX_ASSERT(m_out_pins[pin] && (out_find(pin) == NULL));
+    host_pin_set(pin, true);
+}
+
+
+void nrfx_gpiote_out_clear(nrfx_gpiote_pin_t pin)
+{
+    NRFX_ASSERT(m_out_pins[pin] && (out_find(pin) == NULL));
+    host_pin_set(pin, false);
+}
+
+
+void nrfx_gpiote_out_toggle(nrfx_gpiote_pin_t pin)
+{
+    NRFX_ASSERT(m_out_pins[pin] && (out_find(pin) == NULL));
+    host_pin_set(pin, !host_pin_get(pin));
+}
+
+
+void nrfx_gpiote_out_task_enable(nrfx_gpiote_pin_t pin)
+{
+    gpiote_out_t * p_out = out_find(pin);
+
+    NRFX_ASSERT(p_out != NULL);
+    p_out->task_enabled = true;
+}
+
+
+void nrfx_gpiote_out_task_disable(nrfx_gpiote_pin_t pin)
+{
+    gpiote_out_t * p_out = out_find(pin);
+
+    NRFX_ASSERT(p_out != NULL);
+    p_out->task_enabled = false;
+}
+
+
+uint32_t nrfx_gpiote_out_task_addr_get(nrfx_gpiote_pin_t pin)
+{
+    gpiote_out_t * p_out = out_find(pin);
+
+    NRFX_ASSERT(p_out != NULL);
+    return nrf_gpiote_task_addr_get((nrf_gpiote_tasks_t)(NRF_GPIOTE_TASKS_OUT_0 + 4 * (p_out - m_out)));
+}
+
+
+void nrfx_gpiote_out_task_force(nrfx_gpiote_pin_t pin, uint8_t state)
+{
+    NRFX_ASSERT(out_find(pin) != NULL);
+    host_pin_set(pin, state != 0);
+}
+
+
+/**@brief Function for running TASKS_OUT of a channel: it only drives a pin in task mode. */
+static void task_out(gpiote_out_t * p_out)
+{
+    if (!p_out->used || !p_out->task_enabled)
+    {
+        return;
+    }
+    p_out->tasks++;
+    switch (p_out->action)
+    {
+        case NRF_GPIOTE_POLARITY_LOTOHI:
+            host_pin_set(p_out->pin, true);
+            break;
+
+        case NRF_GPIOTE_POLARITY_HITOLO:
+            host_pin_set(p_out->pin, false);
+            break;
+
+        default:
+            host_pin_set(p_out->pin, !host_pin_get(p_out->pin));
+            break;
+    }
+}
+
+
+void nrfx_gpiote_out_task_trigger(nrfx_gpiote_pin_t pin)
+{
+    gpiote_out_t * p_out = out_find(pin);
+
+    NRFX_ASSERT(p_out != NULL);
+    task_out(p_out);
+}
+
+
+/**@brief Function for running a GPIOTE task reached through its register address, from PPI.
+ *
+ * @return true if the address is a GPIOTE task.
+ */
+bool host_gpiote_task(uint32_t address)
+{
+    uint32_t first = nrf_gpiote_task_addr_get(NRF_GPIOTE_TASKS_OUT_0);
+
+    if ((address < first) || (address >= first + 4 * HOST_GPIOTE_CH_COUNT))
+    {
+        return false;
+    }
+    task_out(&m_out[(address - first) / 4]);
+    return true;
+}
+
+
+nrfx_err_t nrfx_gpiote_in_init(nrfx_gpiote_pin_t               pin,
+                               nrfx_gpiote_in_config_t const * p_config,
+                               nrfx_gpiote_evt_handler_t       evt_handler)
+{
+    gpiote_in_t * p_in  = NULL;
+    uint32_t      first = p_config->hi_accuracy ? 0 : HOST_GPIOTE_CH_COUNT;
+    uint32_t      last  = p_config->hi_accuracy ? HOST_GPIOTE_CH_COUNT : HOST_GPIOTE_IN_COUNT;
+
+    NRFX_ASSERT(pin < HOST_GPIO_PIN_COUNT);
+    if (m_out_pins[pin] || (in_find(pin) != NULL))
+    {
+        return NRFX_ERROR_INVALID_STATE;
+    }
+    for (uint32_t i = first; (i < last) && (p_in == NULL); i++)
+    {
+        p_in = m_in[i].used ? NULL : &m_in[i];
+    }
+    if (p_in == NULL)
+    {
+        return NRFX_ERROR_NO_MEM;
+    }
+    *p_in = (gpiote_in_t){
+        .used    = true,
+        .pin     = pin,
+        .sense   = p_config->sense,
+        .handler = evt_handler,
+    };
+    return NRFX_SUCCESS;
+}
+
+
+void nrfx_gpiote_in_uninit(nrfx_gpiote_pin_t pin)
+{
+    gpiote_in_t * p_in = in_find(pin);
+
+    if (p_in != NULL)
+    {
+        p_in->used = false;
+    }
+}
+
+
+void nrfx_gpiote_in_event_enable(nrfx_gpiote_pin_t pin, bool int_enable)
+{
+    gpiote_in_t * p_in = in_find(pin);
+
+    NRFX_ASSERT(p_in != NULL);
+    p_in->enabled = int_enable;
+}
+
+
+void nrfx_gpiote_in_event_disable(nrfx_gpiote_pin_t pin)
+{
+    gpiote_in_t * p_in = in_find(pin);
+
+    NRFX_ASSERT(p_in != NULL);
+    p_in->enabled = false;
+}
+
+
+bool nrfx_gpiote_in_is_set(nrfx_gpiote_pin_t pin)
+{
+    return host_pin_get(pin);
+}
+
+
+uint32_t nrfx_gpiote_in_event_addr_get(nrfx_gpiote_pin_t pin)
+{
+    gpiote_in_t * p_in = in_find(pin);
+
+    NRFX_ASSERT(p_in != NULL);
+    return nrf_gpiote_event_addr_get((p_in < &m_in[HOST_GPIOTE_CH_COUNT]) ?
+                                     (nrf_gpiote_events_t)(NRF_GPIOTE_EVENTS_IN_0 + 4 * (p_in - m_in)) :
+                                     NRF_GPIOTE_EVENTS_PORT);
+}
+
+
+/**@brief Function for signalling a level change of a pin, like GPIOTE_IRQHandler. */
+void host_gpiote_pin_changed(uint32_t pin, bool level)
+{
+    gpiote_in_t * p_in = in_find(pin);
+
+    if ((p_in == NULL) || !p_in->enabled)
+    {
+        return;
+    }
+    if ((p_in->sense == NRF_GPIOTE_POLARITY_TOGGLE) ||
+        ((p_in->sense == NRF_GPIOTE_POLARITY_LOTOHI) == level))
+    {
+        p_in->handler(pin, p_in->sense);
+    }
+}
+
+
+void host_gpiote_report(void)
+{
+    for (uint32_t i = 0; i < HOST_GPIOTE_CH_COUNT; i++)
+    {
+        if (m_out[i].used)
+        {
+            printf("host: GPIOTE pin %u, %u OUT tasks\n", m_out[i].pin, m_out[i].tasks);
+        }
+    }
+}
@@ -0,0 +1,161 @@
+/**
+ * @file
+ * @brief Host build: PPI driver of the simulation, in place of nrfx/drivers/src/nrfx_ppi.c.
+ *
+ * @details The nrfx driver enables channels through CHENSET/CHENCLR, which only work with the
+ *          hardware behind them. This one keeps the channel allocation of the driver and routes
+ *          an event to the tasks by register address: the event end point is the address a
+ *          peripheral model signals with host_ppi_event(), the task end point is looked up by
+ *          the model that owns it.
+ */
+#include <stdio.h>
+#include "nrfx_ppi.h"
+#include "host.h"
+
+/**@brief Programmable channel. */
+typedef struct
+{
+    bool     allocated;
+    bool     enabled;
+    uint32_t eep;
+    uint32_t tep;
+    uint32_t fork_tep;
+    uint32_t routed;
+} ppi_channel_t;
+
+static ppi_channel_t m_channels[PPI_CH_NUM];
+
+
+static bool is_app_channel(nrf_ppi_channel_t channel)
+{
+    return (channel < PPI_CH_NUM) && ((NRFX_PPI_PROG_APP_CHANNELS_MASK & (1UL << channel)) != 0);
+}
+
+
+void nrfx_ppi_free_all(void)
+{
+    for (uint32_t i = 0; i < PPI_CH_NUM; i++)
+    {
+        m_channels[i] = (ppi_channel_t){0};
+    }
+}
+
+
+nrfx_err_t nrfx_ppi_channel_alloc(nrf_ppi_channel_t * p_channel)
+{
+    for (uint32_t i = 0; i < PPI_CH_NUM; i++)
+    {
+        if (is_app_channel((nrf_ppi_channel_t)i) && !m_channels[i].allocated)
+        {
+            m_channels[i].allocated = true;
+            *p_channel              = (nrf_ppi_channel_t)i;
+            return NRFX_SUCCESS;
+        }
+    }
+    return NRFX_ERROR_NO_MEM;
+}
+
+
+nrfx_err_t nrfx_ppi_channel_free(nrf_ppi_channel_t channel)
+{
+    if (!is_app_channel(channel))
+    {
+        return NRFX_ERROR_INVALID_PARAM;
+    }
+    m_channels[channel] = (ppi_channel_t){0};
+    return NRFX_SUCCESS;
+}
+
+
+nrfx_err_t nrfx_ppi_channel_assign(nrf_ppi_channel_t channel, uint32_t eep, uint32_t tep)
+{
+    if ((eep == 0) || (tep == 0))
+    {
+        return NRFX_ERROR_NULL;
+    }
+    if (!is_app_channel(channel))
+    {
+        return NRFX_ERROR_INVALID_PARAM;
+    }
+    if (!m_channels[channel].allocated)
+    {
+        return NRFX_ERROR_INVALID_STATE;
+    }
+    m_channels[channel].eep = eep;
+    m_channels[channel].tep = tep;
+    return NRFX_SUCCESS;
+}
+
+
+nrfx_err_t nrfx_ppi_channel_fork_assign(nrf_ppi_channel_t channel, uint32_t fork_tep)
+{
+    if (!is_app_channel(channel) || !m_channels[channel].allocated)
+    {
+        return NRFX_ERROR_INVALID_STATE;
+    }
+    m_channels[channel].fork_tep = fork_tep;
+    return NRFX_SUCCESS;
+}
+
+
+nrfx_err_t nrfx_ppi_channel_enable(nrf_ppi_channel_t channel)
+{
+    if (!is_app_channel(channel))
+    {
+        return NRFX_ERROR_INVALID_PARAM;
+    }
+    if (!m_channels[channel].allocated)
+    {
+        return NRFX_ERROR_INVALID_STATE;
+    }
+    m_channels[channel].enabled = true;
+    return NRFX_SUCCESS;
+}
+
+
+nrfx_err_t nrfx_ppi_channel_disable(nrf_ppi_channel_t channel)
+{
+    if (!is_app_channel(channel))
+    {
+        return NRFX_ERROR_INVALID_PARAM;
+    }
+    if (!m_channels[channel].allocated)
+    {
+        return NRFX_ERROR_INVALID_STATE;
+    }
+    m_channels[channel].enabled = false;
+    return NRFX_SUCCESS;
+}
+
+
+/**@brief Function for signalling a peripheral event to the enabled channels. */
+void host_ppi_event(uint32_t eep)
+{
+    for (uint32_t i = 0; i < PPI_CH_NUM; i++)
+    {
+        ppi_channel_t * p_channel = &m_channels[i];
+
+        if (!p_channel->enabled || (p_channel->eep != eep))
+        {
+            continue;
+        }
+        p_channel->routed++;
+        (void)host_gpiote_task(p_channel->tep);
+        if (p_channel->fork_tep != 0)
+        {
+            (void)host_gpiote_task(p_channel->fork_tep);
+        }
+    }
+}
+
+
+void host_ppi_report(void)
+{
+    for (uint32_t i = 0; i < PPI_CH_NUM; i++)
+    {
+        if (m_channels[i].allocated)
+        {
+            printf("host: PPI channel %u routed %u events\n", i, m_channels[i].routed);
+        }
+    }
+}
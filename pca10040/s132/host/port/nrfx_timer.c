@@ -0,0 +1,261 @@
+/**
+ * @file
+ * @brief Host build: TIMER driver on the simulated clock, in place of nrfx/drivers/src/nrfx_timer.c.
+ *
+ * @details The nrfx driver starts, stops and configures the peripheral through TASKS and
+ *          INTENSET/INTENCLR registers, which only work with the hardware behind them. This one
+ *          keeps the same API and the same state machine, and turns every configured compare
+ *          into an action of the simulation. A compare signals its event to PPI, applies the
+ *          CLEAR and STOP shorts and calls the handler when its interrupt is enabled.
+ *          PRESCALER and CC are written to the register block too, so the inline helpers of
+ *          nrfx_timer.h read the real values.
+ */
+#include <stdio.h>
+#include "nrfx_timer.h"
+#include "host.h"
+
+#define HOST_TIMER_FREQ_HZ(freq)        (16000000UL >> (freq))
+#define HOST_TIMER_CC_COUNT             6                       /**< CC registers of a TIMER instance. */
+
+/**@brief Control block of a driver instance. */
+typedef struct
+{
+    nrfx_drv_state_t           state;
+    nrfx_timer_event_handler_t handler;
+    void *                     p_context;
+    NRF_TIMER_Type *           p_reg;
+    nrf_timer_frequency_t      frequency;
+    uint8_t                    cc_set;              /**< Channels configured with a compare value. */
+    uint8_t                    int_mask;            /**< Channels with the compare interrupt enabled. */
+    uint32_t                   shorts;
+    uint32_t                   generation;          /**< Makes the compares of an earlier start stale. */
+    uint64_t                   start_ns;            /**< Simulated time the counter was last cleared. */
+    uint64_t                   enabled_ns;          /**< Simulated time the timer was last started. */
+    uint64_t                   run_ns;              /**< Time spent running before the last start, with HFCLK requested. */
+    uint32_t                   compares;
+} timer_control_block_t;
+
+static timer_control_block_t m_cb[NRFX_TIMER_ENABLED_COUNT];
+
+static void timer_compare(void * p_context, uint32_t arg);
+
+
+/**@brief Function for stopping a running timer, the time it ran is added to its run time. */
+static void timer_stop(timer_control_block_t * p_cb)
+{
+    if (p_cb->state == NRFX_DRV_STATE_POWERED_ON)
+    {
+        p_cb->run_ns += host_now_us() * 1000 - p_cb->enabled_ns;
+        p_cb->state   = NRFX_DRV_STATE_INITIALIZED;
+    }
+    p_cb->generation++;
+}
+
+
+static uint64_t ticks_to_ns(timer_control_block_t const * p_cb, uint32_t ticks)
+{
+    return ((uint64_t)ticks * 1000000000ULL) / HOST_TIMER_FREQ_HZ(p_cb->frequency);
+}
+
+
+/**@brief Function for scheduling the next compare of every configured channel from the counter start. */
+static void compares_schedule(timer_control_block_t * p_cb)
+{
+    for (uint32_t ch = 0; ch < HOST_TIMER_CC_COUNT; ch++)
+    {
+        if (p_cb->cc_set & (1U << ch))
+        {
+            host_schedule((p_cb->start_ns + ticks_to_ns(p_cb, p_cb->p_reg->CC[ch])) / 1000,
+                          timer_compare, p_cb, (p_cb->generation << 3) | ch);
+        }
+    }
+}
+
+
+/**@brief Function for handling a compare of the simulation, like TIMERx_IRQHandler. */
+static void timer_compare(void * p_context, uint32_t arg)
+{
+    timer_control_block_t * p_cb  = p_context;
+    uint32_t                ch    = arg & 0x7;
+    nrf_timer_event_t       event = nrf_timer_compare_event_get(ch);
+
+    if ((p_cb->state != NRFX_DRV_STATE_POWERED_ON) || ((p_cb->generation & 0x1FFFFFFF) != (arg >> 3)))
+    {
+        return;
+    }
+    p_cb->compares++;
+    nrf_timer_event_clear(p_cb->p_reg, event);
+    host_ppi_event((uint32_t)nrf_timer_event_address_get(p_cb->p_reg, event));
+
+    if (p_cb->shorts & (NRF_TIMER_SHORT_COMPARE0_STOP_MASK << ch))
+    {
+        timer_stop(p_cb);
+    }
+    else if (p_cb->shorts & (NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK << ch))
+    {
+        p_cb->generation++;
+        p_cb->start_ns += ticks_to_ns(p_cb, p_cb->p_reg->CC[ch]);
+        compares_schedule(p_cb);
+    }
+    if (p_cb->int_mask & (1U << ch))
+    {
+        p_cb->handler(event, p_cb->p_context);
+    }
+}
+
+
+nrfx_err_t nrfx_timer_init(nrfx_timer_t const * const  p_instance,
+                           nrfx_timer_config_t const * p_config,
+                           nrfx_timer_event_handler_t  timer_event_handler)
+{
+    timer_control_block_t * p_cb = &m_cb[p_instance->instance_id];
+
+    NRFX_ASSERT(timer_event_handler);
+    if (p_cb->state != NRFX_DRV_STATE_UNINITIALIZED)
+    {
+        return NRFX_ERROR_INVALID_STATE;
+    }
+
+    *p_cb = (timer_control_block_t){
+        .state     = NRFX_DRV_STATE_INITIALIZED,
+        .handler   = timer_event_handler,
+        .p_context = p_config->p_context,
+        .p_reg     = p_instance->p_reg,
+        .frequency = p_config->frequency,
+    };
+    nrf_timer_frequency_set(p_instance->p_reg, p_config->frequency);
+    return NRFX_SUCCESS;
+}
+
+
+void nrfx_timer_uninit(nrfx_timer_t const * const p_instance)
+{
+    timer_control_block_t * p_cb = &m_cb[p_instance->instance_id];
+
+    timer_stop(p_cb);
+    p_cb->state = NRFX_DRV_STATE_UNINITIALIZED;
+}
+
+
+void nrfx_timer_enable(nrfx_timer_t const * const p_instance)
+{
+    timer_control_block_t * p_cb = &m_cb[p_instance->instance_id];
+
+    NRFX_ASSERT(p_cb->state == NRFX_DRV_STATE_INITIALIZED);
+    p_cb->state      = NRFX_DRV_STATE_POWERED_ON;
+    p_cb->start_ns   = host_now_us() * 1000;
+    p_cb->enabled_ns = p_cb->start_ns;
+    p_cb->generation++;
+    compares_schedule(p_cb);
+}
+
+
+void nrfx_timer_disable(nrfx_timer_t const * const p_instance)
+{
+    timer_control_block_t * p_cb = &m_cb[p_instance->instance_id];
+
+    NRFX_ASSERT(p_cb->state != NRFX_DRV_STATE_UNINITIALIZED);
+    timer_stop(p_cb);
+}
+
+
+bool nrfx_timer_is_enabled(nrfx_timer_t const * const p_instance)
+{
+    return m_cb[p_instance->instance_id].state == NRFX_DRV_STATE_POWERED_ON;
+}
+
+
+void nrfx_timer_clear(nrfx_timer_t const * const p_instance)
+{
+    timer_control_block_t * p_cb = &m_cb[p_instance->instance_id];
+
+    p_cb->start_ns = host_now_us() * 1000;
+    if (p_cb->state == NRFX_DRV_STATE_POWERED_ON)
+    {
+        p_cb->generation++;
+        compares_schedule(p_cb);
+    }
+}
+
+
+uint32_t nrfx_timer_capture(nrfx_timer_t const * const p_instance, nrf_timer_cc_channel_t cc_channel)
+{
+    timer_control_block_t * p_cb  = &m_cb[p_instance->instance_id];
+    uint64_t                ticks = ((host_now_us() * 1000 - p_cb->start_ns) * HOST_TIMER_FREQ_HZ(p_cb->frequency))
+                                    / 1000000000ULL;
+
+    nrf_timer_cc_write(p_cb->p_reg, cc_channel, (uint32_t)ticks);
+    return (uint32_t)ticks;
+}
+
+
+void nrfx_timer_compare(nrfx_timer_t const * const p_instance,
+                        nrf_timer_cc_channel_t     cc_channel,
+                        uint32_t                   cc_value,
+                        bool                       enable_int)
+{
+    timer_control_block_t * p_cb = &m_cb[p_instance->instance_id];
+
+    nrf_timer_cc_write(p_cb->p_reg, cc_channel, cc_value);
+    p_cb->cc_set |= 1U << cc_channel;
+    if (enable_int)
+    {
+        p_cb->int_mask |= 1U << cc_channel;
+    }
+    else
+    {
+        p_cb->int_mask &= ~(1U << cc_channel);
+    }
+    if (p_cb->state == NRFX_DRV_STATE_POWERED_ON)
+    {
+        p_cb->generation++;
+        compares_schedule(p_cb);
+    }
+}
+
+
+void nrfx_timer_extended_compare(nrfx_timer_t const * const p_instance,
+                                 nrf_timer_cc_channel_t     cc_channel,
+                                 uint32_t                   cc_value,
+                                 nrf_timer_short_mask_t     timer_short_mask,
+                                 bool                       enable_int)
+{
+    timer_control_block_t * p_cb = &m_cb[p_instance->instance_id];
+
+    p_cb->shorts &= ~((NRF_TIMER_SHORT_COMPARE0_STOP_MASK | NRF_TIMER_SHORT_COMPARE0_CLEAR_MASK) << cc_channel);
+    p_cb->shorts |= timer_short_mask;
+    nrfx_timer_compare(p_instance, cc_channel, cc_value, enable_int);
+}
+
+
+void nrfx_timer_compare_int_enable(nrfx_timer_t const * const p_instance, uint32_t channel)
+{
+    m_cb[p_instance->instance_id].int_mask |= 1U << channel;
+}
+
+
+void nrfx_timer_compare_int_disable(nrfx_timer_t const * const p_instance, uint32_t channel)
+{
+    m_cb[p_instance->instance_id].int_mask &= ~(1U << channel);
+}
+
+
+void host_timer_report(void)
+{
+    for (uint32_t i = 0; i < NRFX_TIMER_ENABLED_COUNT; i++)
+    {
+        uint64_t now_ns = host_now_us() * 1000;
+        uint64_t run_ns = m_cb[i].run_ns;
+
+        if (m_cb[i].state == NRFX_DRV_STATE_POWERED_ON)
+        {
+            run_ns += now_ns - m_cb[i].enabled_ns;
+        }
+        if ((m_cb[i].state != NRFX_DRV_STATE_UNINITIALIZED) && (now_ns != 0))
+        {
+            printf("host: TIMER at 0x%08x, %u compare events, running %llu.%llu %% of the time\n",
+                   (uint32_t)(uintptr_t)m_cb[i].p_reg, m_cb[i].compares,
+                   (unsigned long long)(run_ns * 100 / now_ns), (unsigned long long)((run_ns * 1000 / now_ns) % 10));
+        }
+    }
+}